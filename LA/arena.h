@@ -0,0 +1,211 @@
+/*                                                                 -*- C++ -*-
+ * File: arena.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Monotonic arena allocator for short-lived scratch data
+ *   (e.g. per-image matrices and feature vectors).
+ *   Memory is taken from large blocks by bumping a pointer and
+ *   is released all at once, so once the arena has grown, a loop
+ *   resetting it after each iteration does no heap allocations.
+ *
+ */
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+/************************************************************
+* Blocks are kept on reset() and rewind(): allocations after
+* them are served from the same blocks again. A request which
+* does not fit into the rest of the current block goes to the
+* next block (or a new one), so the same sequence of requests
+* after reset() never allocates.
+* Each thread has its own arena (local()), Scope rewinds it
+* on exit. Memory taken after a mark must not be used after
+* rewinding to it
+************************************************************/
+class Arena
+{
+public:
+
+	// Position of the arena
+	struct Marker
+	{
+		size_t block;
+		size_t offset;
+	};
+
+	// Rewinds arena to the position it had at construction
+	class Scope
+	{
+	public:
+		explicit Scope(Arena & arena = Arena::local()) : arena(arena), marker(arena.mark()) {}
+		~Scope() { arena.rewind(marker); }
+
+	private:
+		Scope(const Scope &);
+		Scope & operator = (const Scope &);
+
+		Arena & arena;
+		Marker marker;
+	};
+
+	explicit Arena(size_t block_size = 64 * 1024) :
+		block_size(block_size), current(0), offset(0), nblocks_allocated(0) {}
+
+	~Arena()
+	{
+		for (auto & block : blocks)
+			::operator delete(block.data);
+	}
+
+	void * allocate(size_t bytes, size_t alignment = alignof(max_align_t));
+
+	// Releases everything
+	void reset() { current = 0; offset = 0; }
+
+	Marker mark() const { Marker m = { current, offset }; return m; }
+	void rewind(const Marker & m) { current = m.block; offset = m.offset; }
+
+	// Bytes of all blocks
+	size_t capacity() const;
+
+	// Number of blocks taken from the heap during the life of the arena
+	size_t heap_allocations() const { return nblocks_allocated; }
+
+	// Arena of the calling thread
+	static Arena & local()
+	{
+		static thread_local Arena arena;
+		return arena;
+	}
+
+private:
+
+	Arena(const Arena &);
+	Arena & operator = (const Arena &);
+
+	struct Block
+	{
+		char * data;
+		size_t size;
+	};
+
+	size_t block_size;
+	vector<Block> blocks;
+	size_t current;
+	size_t offset;
+	size_t nblocks_allocated;
+};
+
+/************************************************************
+* Standard allocator on top of arena (the calling thread's
+* one by default). Deallocation does nothing
+************************************************************/
+template <class T>
+class ArenaAllocator
+{
+public:
+
+	typedef T value_type;
+
+	ArenaAllocator() : arena(&Arena::local()) {}
+	explicit ArenaAllocator(Arena & arena) : arena(&arena) {}
+
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U> & other) : arena(other.arena) {}
+
+	T * allocate(size_t n) { return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T))); }
+	void deallocate(T *, size_t) {}
+
+	template <class U>
+	struct rebind { typedef ArenaAllocator<U> other; };
+
+	Arena * arena;
+};
+
+template <class T, class U>
+bool operator == (const ArenaAllocator<T> & a, const ArenaAllocator<U> & b) { return a.arena == b.arena; }
+
+template <class T, class U>
+bool operator != (const ArenaAllocator<T> & a, const ArenaAllocator<U> & b) { return a.arena != b.arena; }
+
+/************************************************************
+* Matrix (image) with rows in the arena, interchangeable with
+* Matrix in templates on image type (nrow(), ncol(), [r][c],
+* iteration over rows). Must not outlive rewinding of arena
+* to a position before its construction
+************************************************************/
+template <class T>
+class ArenaMatrix : public vector<vector<T, ArenaAllocator<T> >, ArenaAllocator<vector<T, ArenaAllocator<T> > > >
+{
+public:
+
+	typedef vector<T, ArenaAllocator<T> > Row;
+	typedef vector<Row, ArenaAllocator<Row> > Super;
+
+	ArenaMatrix() {}
+
+	// Creates matrix row * col and initializes with val
+	ArenaMatrix(unsigned row, unsigned col, T val = T())
+	{
+		this->reserve(row);
+		for (unsigned r = 0; r < row; ++r)
+			this->push_back(Row(col, val));
+	}
+
+	unsigned nrow() const { return this->size(); }
+	unsigned ncol() const { return this->size() ? this->front().size() : 0; }
+};
+
+/******************************************************************************
+*
+* IMPLEMENTATIONS
+*
+*******************************************************************************/
+
+inline void * Arena::allocate(size_t bytes, size_t alignment)
+{
+	for (;; ++current, offset = 0)
+	{
+		if (current == blocks.size())
+		{
+			Block block;
+			block.size = max(block_size, bytes + alignment);
+			block.data = static_cast<char *>(::operator new(block.size));
+			blocks.push_back(block);
+			++nblocks_allocated;
+		}
+
+		Block & block = blocks[current];
+		size_t address = reinterpret_cast<size_t>(block.data + offset);
+		size_t begin = offset + (alignment - address % alignment) % alignment;
+
+		if (begin + bytes <= block.size)
+		{
+			offset = begin + bytes;
+			return block.data + begin;
+		}
+	}
+}
+
+inline size_t Arena::capacity() const
+{
+	size_t total = 0;
+	for (const auto & block : blocks)
+		total += block.size;
+
+	return total;
+}
+
+#endif
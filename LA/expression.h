@@ -0,0 +1,426 @@
+/*                                                                 -*- C++ -*-
+ * File: expression.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Expression templates for vector and matrix arithmetic.
+ *   Expressions built from lazy(x) operands (e.g. lazy(a) - b * s + c)
+ *   are not evaluated until assigned, so the whole expression is computed
+ *   in a single fused loop without intermediate allocations.
+ *
+ *   Expression objects keep references to their operands, so they have
+ *   to be evaluated within the same full expression (do not store them in auto).
+ *   Operations are elementwise, hence v = lazy(v) * 2 etc. are safe.
+ *   Matrix expressions are evaluated row by row. An expression which reads
+ *   other rows of the target (m = lazy(m) - broadcast_rows(m[0], n)) is
+ *   evaluated into a temporary first (see MatrixExpr::aliases).
+ *
+ */
+
+#ifndef _EXPRESSION_H_
+#define _EXPRESSION_H_
+
+#include <vector>
+#include <functional>
+
+using namespace std;
+
+template <class T>
+class Matrix;
+
+/******************************************************************************
+*
+* Elementwise operations
+*
+*******************************************************************************/
+
+struct PlusOp
+{
+	template <class T>
+	static T apply(const T & a, const T & b) { return a + b; }
+};
+
+struct MinusOp
+{
+	template <class T>
+	static T apply(const T & a, const T & b) { return a - b; }
+};
+
+struct MultipliesOp
+{
+	template <class T>
+	static T apply(const T & a, const T & b) { return a * b; }
+};
+
+struct DividesOp
+{
+	template <class T>
+	static T apply(const T & a, const T & b) { return a / b; }
+};
+
+/******************************************************************************
+*
+* Vector expressions
+*
+*******************************************************************************/
+
+template <class E>
+struct VectorExpr
+{
+	const E & self() const { return static_cast<const E &>(*this); }
+};
+
+template <class T>
+class VectorRef : public VectorExpr<VectorRef<T> >
+{
+public:
+	typedef T Value;
+
+	VectorRef(const vector<T> & v) : v(v) {}
+
+	unsigned size() const { return v.size(); }
+	const T & operator [] (unsigned i) const { return v[i]; }
+
+private:
+	const vector<T> & v;
+};
+
+template <class L, class R, class Op>
+class VectorBinary : public VectorExpr<VectorBinary<L, R, Op> >
+{
+public:
+	typedef typename L::Value Value;
+
+	VectorBinary(const L & l, const R & r) : l(l), r(r)
+	{
+		if (l.size() != r.size())
+			throw exception("vector expression: inconsistent sizes");
+	}
+
+	unsigned size() const { return l.size(); }
+	Value operator [] (unsigned i) const { return Op::apply(l[i], r[i]); }
+
+private:
+	// Nodes are held by value (leaves are just references)
+	L l;
+	R r;
+};
+
+template <class E, class Op>
+class VectorScalar : public VectorExpr<VectorScalar<E, Op> >
+{
+public:
+	typedef typename E::Value Value;
+
+	VectorScalar(const E & e, const Value & s) : e(e), s(s) {}
+
+	unsigned size() const { return e.size(); }
+	Value operator [] (unsigned i) const { return Op::apply(e[i], s); }
+
+private:
+	E e;
+	Value s;
+};
+
+template <class T>
+VectorRef<T> lazy(const vector<T> & v) { return VectorRef<T>(v); }
+
+// Vector + vector
+
+template <class L, class R>
+VectorBinary<L, R, PlusOp> operator + (const VectorExpr<L> & l, const VectorExpr<R> & r)
+{
+	return VectorBinary<L, R, PlusOp>(l.self(), r.self());
+}
+
+template <class L, class T>
+VectorBinary<L, VectorRef<T>, PlusOp> operator + (const VectorExpr<L> & l, const vector<T> & r)
+{
+	return VectorBinary<L, VectorRef<T>, PlusOp>(l.self(), VectorRef<T>(r));
+}
+
+template <class T, class R>
+VectorBinary<VectorRef<T>, R, PlusOp> operator + (const vector<T> & l, const VectorExpr<R> & r)
+{
+	return VectorBinary<VectorRef<T>, R, PlusOp>(VectorRef<T>(l), r.self());
+}
+
+// Vector - vector
+
+template <class L, class R>
+VectorBinary<L, R, MinusOp> operator - (const VectorExpr<L> & l, const VectorExpr<R> & r)
+{
+	return VectorBinary<L, R, MinusOp>(l.self(), r.self());
+}
+
+template <class L, class T>
+VectorBinary<L, VectorRef<T>, MinusOp> operator - (const VectorExpr<L> & l, const vector<T> & r)
+{
+	return VectorBinary<L, VectorRef<T>, MinusOp>(l.self(), VectorRef<T>(r));
+}
+
+template <class T, class R>
+VectorBinary<VectorRef<T>, R, MinusOp> operator - (const vector<T> & l, const VectorExpr<R> & r)
+{
+	return VectorBinary<VectorRef<T>, R, MinusOp>(VectorRef<T>(l), r.self());
+}
+
+// Vector * scalar, vector / scalar
+
+template <class E>
+VectorScalar<E, MultipliesOp> operator * (const VectorExpr<E> & e, const typename E::Value & s)
+{
+	return VectorScalar<E, MultipliesOp>(e.self(), s);
+}
+
+template <class E>
+VectorScalar<E, MultipliesOp> operator * (const typename E::Value & s, const VectorExpr<E> & e)
+{
+	return VectorScalar<E, MultipliesOp>(e.self(), s);
+}
+
+// NOTE: unlike vector<T> /= T, does not round results close to integers
+template <class E>
+VectorScalar<E, DividesOp> operator / (const VectorExpr<E> & e, const typename E::Value & s)
+{
+	return VectorScalar<E, DividesOp>(e.self(), s);
+}
+
+// Evaluation
+
+template <class T, class E>
+vector<T> & assign(vector<T> & v, const VectorExpr<E> & expr)
+{
+	const E & e = expr.self();
+	unsigned n = e.size();
+
+	if (v.size() != n)
+		v.resize(n);
+
+	for (unsigned i = 0; i < n; ++i)
+		v[i] = e[i];
+
+	return v;
+}
+
+template <class E>
+vector<typename E::Value> eval(const VectorExpr<E> & expr)
+{
+	vector<typename E::Value> v(expr.self().size());
+	return assign(v, expr);
+}
+
+template <class T, class E>
+vector<T> & operator += (vector<T> & v, const VectorExpr<E> & expr)
+{
+	const E & e = expr.self();
+	if (v.size() != e.size())
+		throw exception("not compatible for operator '+='");
+
+	for (unsigned i = 0, n = e.size(); i < n; ++i)
+		v[i] += e[i];
+
+	return v;
+}
+
+template <class T, class E>
+vector<T> & operator -= (vector<T> & v, const VectorExpr<E> & expr)
+{
+	const E & e = expr.self();
+	if (v.size() != e.size())
+		throw exception("not compatible for operator '-='");
+
+	for (unsigned i = 0, n = e.size(); i < n; ++i)
+		v[i] -= e[i];
+
+	return v;
+}
+
+/******************************************************************************
+*
+* Matrix expressions
+* (each node provides row(r) - vector expression of its r-th row, and
+* aliases(m) - whether row r reads rows of m other than its r-th row)
+*
+*******************************************************************************/
+
+template <class E>
+struct MatrixExpr
+{
+	const E & self() const { return static_cast<const E &>(*this); }
+};
+
+template <class T>
+class MatrixRef : public MatrixExpr<MatrixRef<T> >
+{
+public:
+	typedef T Value;
+	typedef VectorRef<T> RowExpr;
+
+	MatrixRef(const Matrix<T> & m) : m(m) {}
+
+	unsigned nrow() const { return m.nrow(); }
+	unsigned ncol() const { return m.ncol(); }
+	RowExpr row(unsigned r) const { return RowExpr(m[r]); }
+
+	// Row r reads only row r of m
+	template <class U>
+	bool aliases(const Matrix<U> &) const { return false; }
+
+private:
+	const Matrix<T> & m;
+};
+
+// Matrix with identical rows (e.g. column means), without creating it
+template <class T>
+class RowBroadcast : public MatrixExpr<RowBroadcast<T> >
+{
+public:
+	typedef T Value;
+	typedef VectorRef<T> RowExpr;
+
+	RowBroadcast(const vector<T> & v, unsigned n) : v(v), n(n) {}
+
+	unsigned nrow() const { return n; }
+	unsigned ncol() const { return v.size(); }
+	RowExpr row(unsigned) const { return RowExpr(v); }
+
+	// Every row reads v, which may be a row of m
+	template <class U>
+	bool aliases(const Matrix<U> & m) const
+	{
+		const void * p = &v;
+		return !m.empty() && !less<const void *>()(p, &m.front()) && !less<const void *>()(&m.back(), p);
+	}
+
+private:
+	const vector<T> & v;
+	unsigned n;
+};
+
+template <class L, class R, class Op>
+class MatrixBinary : public MatrixExpr<MatrixBinary<L, R, Op> >
+{
+public:
+	typedef typename L::Value Value;
+	typedef VectorBinary<typename L::RowExpr, typename R::RowExpr, Op> RowExpr;
+
+	MatrixBinary(const L & l, const R & r) : l(l), r(r)
+	{
+		if (l.nrow() != r.nrow() || l.ncol() != r.ncol())
+			throw exception("matrix expression: inconsistent sizes");
+	}
+
+	unsigned nrow() const { return l.nrow(); }
+	unsigned ncol() const { return l.ncol(); }
+	RowExpr row(unsigned i) const { return RowExpr(l.row(i), r.row(i)); }
+
+	template <class U>
+	bool aliases(const Matrix<U> & m) const { return l.aliases(m) || r.aliases(m); }
+
+private:
+	L l;
+	R r;
+};
+
+template <class E, class Op>
+class MatrixScalar : public MatrixExpr<MatrixScalar<E, Op> >
+{
+public:
+	typedef typename E::Value Value;
+	typedef VectorScalar<typename E::RowExpr, Op> RowExpr;
+
+	MatrixScalar(const E & e, const Value & s) : e(e), s(s) {}
+
+	unsigned nrow() const { return e.nrow(); }
+	unsigned ncol() const { return e.ncol(); }
+	RowExpr row(unsigned i) const { return RowExpr(e.row(i), s); }
+
+	template <class U>
+	bool aliases(const Matrix<U> & m) const { return e.aliases(m); }
+
+private:
+	E e;
+	Value s;
+};
+
+template <class T>
+MatrixRef<T> lazy(const Matrix<T> & m) { return MatrixRef<T>(m); }
+
+// Returns n * v.size() matrix with all rows equal to v
+template <class T>
+RowBroadcast<T> broadcast_rows(const vector<T> & v, unsigned n) { return RowBroadcast<T>(v, n); }
+
+// Matrix + matrix
+
+template <class L, class R>
+MatrixBinary<L, R, PlusOp> operator + (const MatrixExpr<L> & l, const MatrixExpr<R> & r)
+{
+	return MatrixBinary<L, R, PlusOp>(l.self(), r.self());
+}
+
+template <class L, class T>
+MatrixBinary<L, MatrixRef<T>, PlusOp> operator + (const MatrixExpr<L> & l, const Matrix<T> & r)
+{
+	return MatrixBinary<L, MatrixRef<T>, PlusOp>(l.self(), MatrixRef<T>(r));
+}
+
+template <class T, class R>
+MatrixBinary<MatrixRef<T>, R, PlusOp> operator + (const Matrix<T> & l, const MatrixExpr<R> & r)
+{
+	return MatrixBinary<MatrixRef<T>, R, PlusOp>(MatrixRef<T>(l), r.self());
+}
+
+// Matrix - matrix
+
+template <class L, class R>
+MatrixBinary<L, R, MinusOp> operator - (const MatrixExpr<L> & l, const MatrixExpr<R> & r)
+{
+	return MatrixBinary<L, R, MinusOp>(l.self(), r.self());
+}
+
+template <class L, class T>
+MatrixBinary<L, MatrixRef<T>, MinusOp> operator - (const MatrixExpr<L> & l, const Matrix<T> & r)
+{
+	return MatrixBinary<L, MatrixRef<T>, MinusOp>(l.self(), MatrixRef<T>(r));
+}
+
+template <class T, class R>
+MatrixBinary<MatrixRef<T>, R, MinusOp> operator - (const Matrix<T> & l, const MatrixExpr<R> & r)
+{
+	return MatrixBinary<MatrixRef<T>, R, MinusOp>(MatrixRef<T>(l), r.self());
+}
+
+// Matrix * scalar, matrix / scalar
+
+template <class E>
+MatrixScalar<E, MultipliesOp> operator * (const MatrixExpr<E> & e, const typename E::Value & s)
+{
+	return MatrixScalar<E, MultipliesOp>(e.self(), s);
+}
+
+template <class E>
+MatrixScalar<E, MultipliesOp> operator * (const typename E::Value & s, const MatrixExpr<E> & e)
+{
+	return MatrixScalar<E, MultipliesOp>(e.self(), s);
+}
+
+// NOTE: unlike Matrix<T> /= T, does not round results close to integers
+template <class E>
+MatrixScalar<E, DividesOp> operator / (const MatrixExpr<E> & e, const typename E::Value & s)
+{
+	return MatrixScalar<E, DividesOp>(e.self(), s);
+}
+
+// Evaluation
+
+template <class E>
+Matrix<typename E::Value> eval(const MatrixExpr<E> & expr)
+{
+	return Matrix<typename E::Value>(expr);
+}
+
+#endif
@@ -0,0 +1,120 @@
+/*                                                                 -*- C++ -*-
+ * File: fast_math.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Elementwise math over arrays, written as straight-line loops
+ *   (no calls, no branches) so the compiler can vectorize them.
+ *   Clamping compares have to be if-converted, which compilers do
+ *   with relaxed floating point exceptions (/fp:fast, -fno-trapping-math)
+ *
+ */
+
+#ifndef _FAST_MATH_H_
+#define _FAST_MATH_H_
+
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ v[i] = exp(v[i]) for i < n.
+ Range reduction exp(x) = 2^m * exp(r), |r| <= ln(2)/2, polynomial for exp(r)
+ (Cephes coefficients for float, Taylor series of degree 13 for double).
+ Relative error is within a few ulp. Results below the smallest
+ normalized number are flushed to 0, arguments above 88 (float)
+ or 709 (double) are clamped
+ */
+inline void exp_inplace(float * v, unsigned n)
+{
+	const float max_arg = 88.02f;
+	const float min_arg = -87.3365447504f;
+
+	for (unsigned i = 0; i < n; ++i)
+	{
+		float x = v[i];
+		bool underflow = x < min_arg;
+		x = x > max_arg ? max_arg : (x < min_arg ? min_arg : x);
+
+		// Rounding to nearest integer by adding 1.5 * 2^23:
+		// low bits of t are m, so 2^m is built from them without conversions
+		float t = x * 1.44269504088896341f + 12582912.0f;
+		float m = t - 12582912.0f;
+		uint32_t bits;
+		memcpy(&bits, &t, sizeof(bits));
+		bits = (bits + 127) << 23;
+		float scale;
+		memcpy(&scale, &bits, sizeof(scale));
+
+		x -= m * 0.693359375f;
+		x -= m * -2.12194440e-4f;
+
+		float z = x * x;
+		float y = 1.9875691500e-4f;
+		y = y * x + 1.3981999507e-3f;
+		y = y * x + 8.3334519073e-3f;
+		y = y * x + 4.1665795894e-2f;
+		y = y * x + 1.6666665459e-1f;
+		y = y * x + 5.0000001201e-1f;
+		y = y * z + x + 1.0f;
+
+		v[i] = underflow ? 0.0f : y * scale;
+	}
+}
+
+inline void exp_inplace(double * v, unsigned n)
+{
+	const double max_arg = 709.08;
+	const double min_arg = -708.39641853226408;
+
+	for (unsigned i = 0; i < n; ++i)
+	{
+		double x = v[i];
+		bool underflow = x < min_arg;
+		x = x > max_arg ? max_arg : (x < min_arg ? min_arg : x);
+
+		double t = x * 1.4426950408889634073599 + 6755399441055744.0;
+		double m = t - 6755399441055744.0;
+		uint64_t bits;
+		memcpy(&bits, &t, sizeof(bits));
+		bits = (bits + 1023) << 52;
+		double scale;
+		memcpy(&scale, &bits, sizeof(scale));
+
+		x -= m * 6.93145751953125e-1;
+		x -= m * 1.42860682030941723212e-6;
+
+		// Taylor series, terms are summed from the smallest
+		double y = 1.0 / 6227020800.0;
+		y = y * x + 1.0 / 479001600;
+		y = y * x + 1.0 / 39916800;
+		y = y * x + 1.0 / 3628800;
+		y = y * x + 1.0 / 362880;
+		y = y * x + 1.0 / 40320;
+		y = y * x + 1.0 / 5040;
+		y = y * x + 1.0 / 720;
+		y = y * x + 1.0 / 120;
+		y = y * x + 1.0 / 24;
+		y = y * x + 1.0 / 6;
+		y = y * x + 0.5;
+		y = y * x + 1.0;
+		y = y * x + 1.0;
+
+		v[i] = underflow ? 0.0 : y * scale;
+	}
+}
+
+// Any other type: std::exp
+template <class T>
+void exp_inplace(T * v, unsigned n)
+{
+	for (unsigned i = 0; i < n; ++i)
+		v[i] = static_cast<T>(exp(v[i]));
+}
+
+#endif
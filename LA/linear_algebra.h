@@ -29,6 +29,24 @@ T det(const Matrix<T> & m);
 template <class T>
 Matrix<T> inv(const Matrix<T> & m);
 
+// Returns m^t
+template <class T>
+Matrix<T> transpose(const Matrix<T> & m);
+
+/**
+ Blocked matrix multiplication c = a * b (c += a * b if accumulate).
+ Zero elements of a are skipped
+ */
+template <class T>
+void gemm(const Matrix<T> & a, const Matrix<T> & b, Matrix<T> & c, bool accumulate = false);
+
+/**
+ Blocked matrix multiplication c = a^t * b (c += a^t * b if accumulate)
+ without forming a^t. Zero elements of a are skipped
+ */
+template <class T>
+void gemm_tn(const Matrix<T> & a, const Matrix<T> & b, Matrix<T> & c, bool accumulate = false);
+
 // Returns Gramian matrix (x^t * x)
 template <class T>
 Matrix<T> gram(const Matrix<T> & x);
@@ -98,6 +116,80 @@ vector<T> eigenvalues_2x2(const Matrix<T> & m);
 template <class T>
 vector<pair<T, vector<T>>> eigen_2x2(const Matrix<T> & m);
 
+/**
+ Orthonormalizes rows of m in place (modified Gram-Schmidt).
+ Rows which are linearly dependent on the previous rows are set to zero.
+ Returns the number of independent rows
+ */
+template <class T>
+unsigned orthonormalize_rows(Matrix<T> & m);
+
+/**
+ Returns vector of pairs <eigenval, eigenvec> of symmetric matrix,
+ sorted by eigenvalue in descending order.
+ Implements Householder tridiagonalization followed by implicit QL
+ */
+template <class T>
+vector<pair<T, vector<T>>> eigen_symmetric(const Matrix<T> & m);
+
+/**
+ Returns k eigenpairs of symmetric matrix with the largest |eigenval|
+ (i.e. the largest ones for positive semi-definite matrices, such as covariance),
+ sorted by eigenvalue in descending order.
+ Implements subspace iteration with Rayleigh-Ritz projection,
+ so only k components are computed.
+ Throws if residuals of the k pairs are not within tolerance
+ after max_iter iterations
+ */
+template <class T>
+vector<pair<T, vector<T>>> eigen_symmetric_top(const Matrix<T> & m, unsigned k, 
+	unsigned max_iter = 500, T tolerance = static_cast<T>(1e-6));
+
+/**
+ Sequential reader of row blocks of in-memory matrix.
+ Algorithms which only need passes over rows (e.g. randomized_svd_rows)
+ accept any class with the same interface, so that data which 
+ does not fit in memory can be streamed from file
+ */
+template <class T>
+class MatrixRowBlocks
+{
+public:
+	typedef T Value;
+
+	MatrixRowBlocks(const Matrix<T> & m, unsigned block_size = 1024) : 
+		m(m), block_size(block_size), next_row(0) {}
+
+	unsigned ncol() const { return m.ncol(); }
+
+	// Starts a new pass
+	void rewind() { next_row = 0; }
+
+	// Reads next block (up to block_size rows). Returns false at the end of pass
+	bool read(Matrix<T> & block);
+
+private:
+	const Matrix<T> & m;
+	unsigned block_size;
+	unsigned next_row;
+};
+
+/**
+ Returns truncated SVD (u, s, vt) of the matrix m * n, such as 
+ a ~ u * diag(s) * vt, where u is m * k, s - top k singular values 
+ in descending order, vt is k * n (rows are right singular vectors).
+ Implements randomized range finder (Halko, Martinsson, Tropp)
+ with oversampling and power iterations. Input is accessed only 
+ by sequential passes over row blocks (2 + 2 * power_iter passes)
+ */
+template <class RowBlocks>
+tuple<Matrix<typename RowBlocks::Value>, vector<typename RowBlocks::Value>, Matrix<typename RowBlocks::Value>> 
+	randomized_svd_rows(RowBlocks & a, unsigned k, unsigned oversampling = 10, unsigned power_iter = 2);
+
+template <class T>
+tuple<Matrix<T>, vector<T>, Matrix<T>> randomized_svd(const Matrix<T> & a, unsigned k, 
+	unsigned oversampling = 10, unsigned power_iter = 2);
+
 #include "LA/linear_algebra_impl.h"
 
 #endif
@@ -1,410 +1,1065 @@
-﻿/*                                                                 -*- C++ -*-
- * File: linear_algebra_impl.h
- * 
- * Author: Ilya Ivensky
- * 
- * Created on: Dec 7, 2013
- *   
- */
-
-#include <limits>
-#include <cassert>
-
-template <class T>
-T tr(const Matrix<T> & m)
-{
-	if (!is_square(m))
-		throw exception("trace is not defined for non-square matrix");
-
-	T tr = 0;
-	for (unsigned i = 0; i < m.nrow(); ++i)
-		tr += m[i][i];
-
-	return tr;
-}
-
-template <class T>
-T det(const Matrix<T> & m)
-{
-	if (!is_square(m))
-		throw exception("determinant is not defined for non-square matrix"); 
-
-	switch (m.nrow())
-	{
-	case 0:
-		return 0;
-	case 1:
-		return m[0][0];
-	case 2:
-		return m[0][0] * m[1][1] - m[0][1] * m[1][0];
-	default:
-		break;
-	}
-
-	T d = 0;
-	for (unsigned j = 0; j < m.nrow(); ++j)
-		d += static_cast<T>(pow(-1, j + 2)) * m[0][j] * det(m.minor(0, j));
-
-	return d;
-}
-		
-template <class T>
-Matrix<T> gram(const Matrix<T> & m)
-{
-	unsigned DIM = m.ncol();
-
-	Matrix<T> res(DIM, DIM, 0);	
-	for (unsigned i = 0; i < DIM; ++i)
-	{
-		Matrix<T>::Row & ri = res[i];
-		for (unsigned j = i; j < DIM; ++j)
-		{
-			T & rij = ri[j]; 
-
-			for (const auto & row : m)
-				rij += row[i] * row[j];
-
-			res[j][i] = rij;
-		}
-	}
-
-	return res;
-}
-
-template <class T>
-vector<T> mean_col(const Matrix<T> & m)
-{
-	Matrix<T> k(1, m.nrow(), 1);
-	Matrix<T> res(k * m);
-	res /= static_cast<T>(m.nrow());
-	return res[0];
-}
-
-template <class T>
-Matrix<T> dev(const Matrix<T> & m)
-{
-	return m - Matrix<T>(mean_col(m), m.nrow());
-}
-
-template <class T>
-Matrix<T> cov(const Matrix<T> & m)
-{
-	auto deviation = dev(m);
-	auto cov = gram(deviation);
-	cov /= static_cast<T>(m.nrow());
-	return cov;
-}
-
-template <class T>
-Matrix<T> inv(const Matrix<T> & m)
-{
-	if (!is_square(m))
-		throw exception("cannot inverse non-square matrix\n");
-
-	unsigned n = m.size();
-	Matrix<T> upper = m, inverse = Matrix<T>::diag(n, 1);
-	
-	for (unsigned pivot = 0; pivot < n; ++pivot)
-	{
-		for (unsigned r = 0; r < n; ++r)
-		{
-			if (r != pivot)
-			{
-				if (upper[pivot][pivot] == 0)
-					throw exception("matrix cannot be inverted\n");
-				
-				T ratio = upper[r][pivot]/upper[pivot][pivot];
-
-				upper[r] -= upper[pivot] * ratio;
-				inverse[r] -= inverse[pivot] * ratio;
-			}
-		}
-	}
-
-	for (unsigned i = 0; i < n; ++i)
-	{
-		T a = upper[i][i];
-		if (a == 0)
-			throw exception("matrix cannot be inverted\n");
-
-		inverse[i] /= a;
-	}
-
-	return inverse;
-}
-
-template <class T>
-vector<T> characteristic_polynomial(const Matrix<T> & m)
-{
-	if (!is_square(m))
-		throw exception("characteristic_polynomial(): Matrix is not square");
-
-	switch (m.size())
-	{
-	case 2:
-		return vector<T>({ 1, (-1) * tr(m), det(m) });
-	case 3:
-	{
-		T c = (pow(tr(m), 2) - tr(m * m)) / (-2);
-		return vector<T>({ (-1), tr(m), c, det(m) });
-	}
-	default:
-		break;
-	}
-
-	throw exception("characteristic_polynomial(): matrices of this size are not supported");
-	return vector<T>();
-}
-
-template <class T>
-vector<T> solve_quadratic(const vector<T> & p)
-{
-	if (p.size() != 3)
-		throw exception("solve_quadratic(): polynom length is not 3");
-
-	T d = sqrt(pow(p[1], 2) - (4 * p[0] * p[2]));
-	T a2 = 2 * p[0];
-	T b = (-1) * p[1];
-
-	if (d == 0)
-		return vector<T>(1, (b / a2));
-
-	T root1 = (b - d) / a2;
-	T root2 = (b + d) / a2;
-
-	return vector<T>( { root1, root2 } );
-}
-
-template <class T>
-vector<T> eigenvalues_2x2(const Matrix<T> & m)
-{
-	if (m.nrow() != 2 || m.ncol() != 2)
-		throw exception("eigen_values_2x2(): matrices of this size are not supported");
-
-	auto cp = characteristic_polynomial(m);
-
-	return solve_quadratic(cp);
-}
-
-template <class T>
-tuple <Matrix<T>, Matrix<T>, Matrix<T>> lu(const Matrix<T> & m)
-{
-	if (!is_square(m))
-		throw exception("lu: m is not square");
-
-	Matrix<T> lower(Matrix<T>::diag(m.nrow(), 1));
-	Matrix<T> upper(m);
-	Matrix<T> permutation(Matrix<T>::diag(m.nrow(), 1));
-
-	unsigned n = m.nrow();
-
-	// Find the optimal permutation matrix (P)
-	for (unsigned pivot = 0; pivot < n; ++pivot)
-	{
-		T max_pivot = 0;
-		unsigned max_pivot_row = m.nrow();
-		for (unsigned r = pivot; r < n; ++r)
-		{
-			if (abs(upper[r][pivot]) > abs(max_pivot))
-			{
-				max_pivot_row = r;
-				max_pivot = upper[r][pivot];
-			}
-		}
-
-		if (max_pivot == 0)
-			throw exception("lu: cannot decompose m because it is singular");
-
-		if (max_pivot_row != pivot)
-		{
-			swap(upper[max_pivot_row], upper[pivot]);
-			swap(permutation[max_pivot_row], permutation[pivot]);
-		}
-	}
-
-	// Generate lower (L) and upper (U) matrices
-	for (unsigned pivot = 0; pivot < n; ++pivot)
-	{
-		for (unsigned r = pivot + 1; r < n; ++r)
-		{
-			T ratio = upper[r][pivot] / upper[pivot][pivot];
-			upper[r] -= upper[pivot] * ratio;
-			lower[r][pivot] = ratio;
-		}
-	}
-
-	return make_tuple(lower, upper, permutation);
-}
-
-template <class T>
-Matrix<T> rref_int(const Matrix<T> & m)
-{
-	Matrix<T> a(m);
-	for (unsigned pivot_row = 0, pivot_col = 0; pivot_col < a.ncol(); ++pivot_col)
-	{
-		// Find the best pivot row for this column
-		T pivot = 0;
-		unsigned max_pivot_row = m.nrow();
-		for (unsigned r = pivot_row; r < a.nrow(); ++r)
-		{
-			auto & row = a[r];
-			if (row[pivot_col] != 0)
-			{
-				pivot = row[pivot_col];
-				max_pivot_row = r;
-				break;
-			}
-		}
-
-		if (pivot == 0)
-			continue;
-
-		auto k = a[max_pivot_row][pivot_col];
-		if (k != 1) a[max_pivot_row] /= k;
-
-		if (max_pivot_row != pivot_row)
-			swap(a[max_pivot_row], a[pivot_row]);
-
-		auto & prow = a[pivot_row];
-		// Substruct pivot row (multiplied by proper k) from each non-pivot row
-		for (unsigned r = 0; r < a.nrow(); ++r)
-		{
-			if (r == pivot_row)
-				continue;
-
-			auto & row = a[r];
-			auto k = row[pivot_col];
-			for (unsigned c = pivot_col; c < a.ncol(); ++c)
-			{
-				if (row[c] == row[pivot_col]) row[c] = 0;
-				else row[c] -= prow[c] * k;
-			}
-		}
-
-		++pivot_row;
-	}
-
-	// Eliminate zero rows
-	// If there are any, they should be at the bottom of matrix
-	while (!a.empty())
-	{
-		const auto & row = a.back();
-		if (is_zero(row))
-			a.pop_back();
-		else
-			break;
-	}
-
-	return a;
-}
-
-Matrix<int> rref(const Matrix<int> & m)
-{
-	return rref_int(m);
-}
-
-Matrix<long> rref(const Matrix<long> & m)
-{
-	return rref_int(m);
-}
-
-template <class T>
-Matrix<T> rref(const Matrix<T> & m)
-{
-	Matrix<T> a(m);
-	for (unsigned pivot_row = 0, pivot_col = 0; pivot_col < a.ncol(); ++pivot_col)
-	{
-		// Find the best pivot row for this column
-		T max_pivot = 0;
-		unsigned max_pivot_row = m.nrow();
-		for (unsigned r = pivot_row; r < a.nrow(); ++r)
-		{
-			auto & row = a[r];
-			if (abs(row[pivot_col]) > abs(max_pivot))
-			{
-				max_pivot = row[pivot_col];
-				max_pivot_row = r;
-			}
-		}
-
-		if (max_pivot == 0)
-			continue;
-
-		auto k = a[max_pivot_row][pivot_col];
-		if (k != 1) a[max_pivot_row] /= k;
-
-		if (max_pivot_row != pivot_row)
-			swap(a[max_pivot_row], a[pivot_row]);
-
-		auto & prow = a[pivot_row];
-		// Substruct pivot row (multiplied by proper k) from each non-pivot row
-		for (unsigned r = 0; r < a.nrow(); ++r)
-		{
-			if (r == pivot_row)
-				continue;
-
-			auto & row = a[r];
-			auto k = row[pivot_col];
-			for (unsigned c = pivot_col; c < a.ncol(); ++c)
-			{
-				if (row[c] == row[pivot_col]) row[c] = 0;
-				else
-				{
-					row[c] -= prow[c] * k;
-					auto rounded = round(row[c]);
-					if (fabs(row[c] - rounded) < EPSILON) row[c] = rounded;
-				}
-			}
-		}
-
-		++pivot_row;
-	}
-
-	// Eliminate zero rows
-	// If there are any, they should be at the bottom of matrix
-	while (!a.empty())
-	{
-		const auto & row = a.back();
-		if (is_zero(row))
-			a.pop_back();
-		else
-			break;
-	}
-
-	return a;
-}
-
-template <class T>
-vector<pair<T, vector<T>>> eigen_2x2(const Matrix<T> & m)
-{
-	auto eigenvalues = eigenvalues_2x2(m);
-
-	static Matrix<T> zeros(m.nrow(), 1);
-
-	vector<std::pair<T, vector<T>>> eigens;
-
-	for (const auto & eigenval : eigenvalues)
-	{
-		auto a = m - Matrix<T>::diag(m.nrow(), eigenval);
-		auto constraints = rref(a);
-
-		// Because det(a) has to be 0
-		assert(constraints.nrow() == 1);
-		
-		/*
-		   constraints[0][0] has to be always 1 
-		   (because it is echelon form of a)
-		   so if we set eigenvec[0] to be 1,
-		   then eigenvec[1] = -1 / constraints[0][1]
-		   because a * eigenvec = 0
-		 */
-		vector<T> eigenvec = { 1, (-1) / constraints[0][1] };
-		eigens.push_back(make_pair(eigenval, eigenvec));
-	}
-	
-	return eigens;
-}
-
-
-
-
+﻿/*                                                                 -*- C++ -*-
+ * File: linear_algebra_impl.h
+ * 
+ * Author: Ilya Ivensky
+ * 
+ * Created on: Dec 7, 2013
+ *   
+ */
+
+#include <limits>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <iterator>
+
+template <class T>
+T tr(const Matrix<T> & m)
+{
+	if (!is_square(m))
+		throw exception("trace is not defined for non-square matrix");
+
+	T tr = 0;
+	for (unsigned i = 0; i < m.nrow(); ++i)
+		tr += m[i][i];
+
+	return tr;
+}
+
+template <class T>
+T det(const Matrix<T> & m)
+{
+	if (!is_square(m))
+		throw exception("determinant is not defined for non-square matrix"); 
+
+	switch (m.nrow())
+	{
+	case 0:
+		return 0;
+	case 1:
+		return m[0][0];
+	case 2:
+		return m[0][0] * m[1][1] - m[0][1] * m[1][0];
+	default:
+		break;
+	}
+
+	T d = 0;
+	for (unsigned j = 0; j < m.nrow(); ++j)
+		d += static_cast<T>(pow(-1, j + 2)) * m[0][j] * det(m.minor(0, j));
+
+	return d;
+}
+		
+template <class T>
+Matrix<T> gram(const Matrix<T> & m)
+{
+	unsigned DIM = m.ncol();
+
+	Matrix<T> res(DIM, DIM, 0);	
+	for (unsigned i = 0; i < DIM; ++i)
+	{
+		Matrix<T>::Row & ri = res[i];
+		for (unsigned j = i; j < DIM; ++j)
+		{
+			T & rij = ri[j]; 
+
+			for (const auto & row : m)
+				rij += row[i] * row[j];
+
+			res[j][i] = rij;
+		}
+	}
+
+	return res;
+}
+
+template <class T>
+vector<T> mean_col(const Matrix<T> & m)
+{
+	Matrix<T> k(1, m.nrow(), 1);
+	Matrix<T> res(k * m);
+	res /= static_cast<T>(m.nrow());
+	return res[0];
+}
+
+template <class T>
+Matrix<T> dev(const Matrix<T> & m)
+{
+	return Matrix<T>(lazy(m) - broadcast_rows(mean_col(m), m.nrow()));
+}
+
+template <class T>
+Matrix<T> cov(const Matrix<T> & m)
+{
+	auto deviation = dev(m);
+	auto cov = gram(deviation);
+	cov /= static_cast<T>(m.nrow());
+	return cov;
+}
+
+template <class T>
+Matrix<T> inv(const Matrix<T> & m)
+{
+	if (!is_square(m))
+		throw exception("cannot inverse non-square matrix\n");
+
+	unsigned n = m.size();
+	Matrix<T> upper = m, inverse = Matrix<T>::diag(n, 1);
+	
+	for (unsigned pivot = 0; pivot < n; ++pivot)
+	{
+		for (unsigned r = 0; r < n; ++r)
+		{
+			if (r != pivot)
+			{
+				if (upper[pivot][pivot] == 0)
+					throw exception("matrix cannot be inverted\n");
+				
+				T ratio = upper[r][pivot]/upper[pivot][pivot];
+
+				upper[r] -= lazy(upper[pivot]) * ratio;
+				inverse[r] -= lazy(inverse[pivot]) * ratio;
+			}
+		}
+	}
+
+	for (unsigned i = 0; i < n; ++i)
+	{
+		T a = upper[i][i];
+		if (a == 0)
+			throw exception("matrix cannot be inverted\n");
+
+		inverse[i] /= a;
+	}
+
+	return inverse;
+}
+
+template <class T>
+vector<T> characteristic_polynomial(const Matrix<T> & m)
+{
+	if (!is_square(m))
+		throw exception("characteristic_polynomial(): Matrix is not square");
+
+	switch (m.size())
+	{
+	case 2:
+		return vector<T>({ 1, (-1) * tr(m), det(m) });
+	case 3:
+	{
+		T c = (pow(tr(m), 2) - tr(m * m)) / (-2);
+		return vector<T>({ (-1), tr(m), c, det(m) });
+	}
+	default:
+		break;
+	}
+
+	throw exception("characteristic_polynomial(): matrices of this size are not supported");
+	return vector<T>();
+}
+
+template <class T>
+vector<T> solve_quadratic(const vector<T> & p)
+{
+	if (p.size() != 3)
+		throw exception("solve_quadratic(): polynom length is not 3");
+
+	T d = sqrt(pow(p[1], 2) - (4 * p[0] * p[2]));
+	T a2 = 2 * p[0];
+	T b = (-1) * p[1];
+
+	if (d == 0)
+		return vector<T>(1, (b / a2));
+
+	T root1 = (b - d) / a2;
+	T root2 = (b + d) / a2;
+
+	return vector<T>( { root1, root2 } );
+}
+
+template <class T>
+vector<T> eigenvalues_2x2(const Matrix<T> & m)
+{
+	if (m.nrow() != 2 || m.ncol() != 2)
+		throw exception("eigen_values_2x2(): matrices of this size are not supported");
+
+	auto cp = characteristic_polynomial(m);
+
+	return solve_quadratic(cp);
+}
+
+template <class T>
+tuple <Matrix<T>, Matrix<T>, Matrix<T>> lu(const Matrix<T> & m)
+{
+	if (!is_square(m))
+		throw exception("lu: m is not square");
+
+	Matrix<T> lower(Matrix<T>::diag(m.nrow(), 1));
+	Matrix<T> upper(m);
+	Matrix<T> permutation(Matrix<T>::diag(m.nrow(), 1));
+
+	unsigned n = m.nrow();
+
+	// Find the optimal permutation matrix (P)
+	for (unsigned pivot = 0; pivot < n; ++pivot)
+	{
+		T max_pivot = 0;
+		unsigned max_pivot_row = m.nrow();
+		for (unsigned r = pivot; r < n; ++r)
+		{
+			if (abs(upper[r][pivot]) > abs(max_pivot))
+			{
+				max_pivot_row = r;
+				max_pivot = upper[r][pivot];
+			}
+		}
+
+		if (max_pivot == 0)
+			throw exception("lu: cannot decompose m because it is singular");
+
+		if (max_pivot_row != pivot)
+		{
+			swap(upper[max_pivot_row], upper[pivot]);
+			swap(permutation[max_pivot_row], permutation[pivot]);
+		}
+	}
+
+	// Generate lower (L) and upper (U) matrices
+	for (unsigned pivot = 0; pivot < n; ++pivot)
+	{
+		for (unsigned r = pivot + 1; r < n; ++r)
+		{
+			T ratio = upper[r][pivot] / upper[pivot][pivot];
+			upper[r] -= lazy(upper[pivot]) * ratio;
+			lower[r][pivot] = ratio;
+		}
+	}
+
+	return make_tuple(lower, upper, permutation);
+}
+
+template <class T>
+Matrix<T> rref_int(const Matrix<T> & m)
+{
+	Matrix<T> a(m);
+	for (unsigned pivot_row = 0, pivot_col = 0; pivot_col < a.ncol(); ++pivot_col)
+	{
+		// Find the best pivot row for this column
+		T pivot = 0;
+		unsigned max_pivot_row = m.nrow();
+		for (unsigned r = pivot_row; r < a.nrow(); ++r)
+		{
+			auto & row = a[r];
+			if (row[pivot_col] != 0)
+			{
+				pivot = row[pivot_col];
+				max_pivot_row = r;
+				break;
+			}
+		}
+
+		if (pivot == 0)
+			continue;
+
+		auto k = a[max_pivot_row][pivot_col];
+		if (k != 1) a[max_pivot_row] /= k;
+
+		if (max_pivot_row != pivot_row)
+			swap(a[max_pivot_row], a[pivot_row]);
+
+		auto & prow = a[pivot_row];
+		// Substruct pivot row (multiplied by proper k) from each non-pivot row
+		for (unsigned r = 0; r < a.nrow(); ++r)
+		{
+			if (r == pivot_row)
+				continue;
+
+			auto & row = a[r];
+			auto k = row[pivot_col];
+			for (unsigned c = pivot_col; c < a.ncol(); ++c)
+			{
+				if (row[c] == row[pivot_col]) row[c] = 0;
+				else row[c] -= prow[c] * k;
+			}
+		}
+
+		++pivot_row;
+	}
+
+	// Eliminate zero rows
+	// If there are any, they should be at the bottom of matrix
+	while (!a.empty())
+	{
+		const auto & row = a.back();
+		if (is_zero(row))
+			a.pop_back();
+		else
+			break;
+	}
+
+	return a;
+}
+
+Matrix<int> rref(const Matrix<int> & m)
+{
+	return rref_int(m);
+}
+
+Matrix<long> rref(const Matrix<long> & m)
+{
+	return rref_int(m);
+}
+
+template <class T>
+Matrix<T> rref(const Matrix<T> & m)
+{
+	Matrix<T> a(m);
+	for (unsigned pivot_row = 0, pivot_col = 0; pivot_col < a.ncol(); ++pivot_col)
+	{
+		// Find the best pivot row for this column
+		T max_pivot = 0;
+		unsigned max_pivot_row = m.nrow();
+		for (unsigned r = pivot_row; r < a.nrow(); ++r)
+		{
+			auto & row = a[r];
+			if (abs(row[pivot_col]) > abs(max_pivot))
+			{
+				max_pivot = row[pivot_col];
+				max_pivot_row = r;
+			}
+		}
+
+		if (max_pivot == 0)
+			continue;
+
+		auto k = a[max_pivot_row][pivot_col];
+		if (k != 1) a[max_pivot_row] /= k;
+
+		if (max_pivot_row != pivot_row)
+			swap(a[max_pivot_row], a[pivot_row]);
+
+		auto & prow = a[pivot_row];
+		// Substruct pivot row (multiplied by proper k) from each non-pivot row
+		for (unsigned r = 0; r < a.nrow(); ++r)
+		{
+			if (r == pivot_row)
+				continue;
+
+			auto & row = a[r];
+			auto k = row[pivot_col];
+			for (unsigned c = pivot_col; c < a.ncol(); ++c)
+			{
+				if (row[c] == row[pivot_col]) row[c] = 0;
+				else
+				{
+					row[c] -= prow[c] * k;
+					auto rounded = round(row[c]);
+					if (fabs(row[c] - rounded) < EPSILON) row[c] = rounded;
+				}
+			}
+		}
+
+		++pivot_row;
+	}
+
+	// Eliminate zero rows
+	// If there are any, they should be at the bottom of matrix
+	while (!a.empty())
+	{
+		const auto & row = a.back();
+		if (is_zero(row))
+			a.pop_back();
+		else
+			break;
+	}
+
+	return a;
+}
+
+template <class T>
+vector<pair<T, vector<T>>> eigen_2x2(const Matrix<T> & m)
+{
+	auto eigenvalues = eigenvalues_2x2(m);
+
+	static Matrix<T> zeros(m.nrow(), 1);
+
+	vector<std::pair<T, vector<T>>> eigens;
+
+	for (const auto & eigenval : eigenvalues)
+	{
+		auto a = m - Matrix<T>::diag(m.nrow(), eigenval);
+		auto constraints = rref(a);
+
+		// Because det(a) has to be 0
+		assert(constraints.nrow() == 1);
+		
+		/*
+		   constraints[0][0] has to be always 1 
+		   (because it is echelon form of a)
+		   so if we set eigenvec[0] to be 1,
+		   then eigenvec[1] = -1 / constraints[0][1]
+		   because a * eigenvec = 0
+		 */
+		vector<T> eigenvec = { 1, (-1) / constraints[0][1] };
+		eigens.push_back(make_pair(eigenval, eigenvec));
+	}
+	
+	return eigens;
+}
+
+template <class T>
+unsigned orthonormalize_rows(Matrix<T> & m)
+{
+	unsigned rank = 0;
+
+	for (unsigned i = 0; i < m.nrow(); ++i)
+	{
+		auto & row = m[i];
+		T norm_before = sqrt(inner_product(row, row));
+
+		// Two passes of projection keep the basis orthogonal in finite precision
+		for (unsigned pass = 0; pass < 2; ++pass)
+			for (unsigned j = 0; j < i; ++j)
+			{
+				const auto & prev = m[j];
+				T proj = inner_product(row, prev);
+				if (proj == 0)
+					continue;
+
+				for (unsigned c = 0; c < row.size(); ++c)
+					row[c] -= proj * prev[c];
+			}
+
+		T norm_after = sqrt(inner_product(row, row));
+		if (norm_after <= norm_before * numeric_limits<T>::epsilon() * row.size() || norm_after == 0)
+		{
+			fill(row.begin(), row.end(), T());
+			continue;
+		}
+
+		for (auto & el : row)
+			el /= norm_after;
+
+		++rank;
+	}
+
+	return rank;
+}
+
+// Reduces symmetric matrix to tridiagonal form (Householder reflections).
+// On exit v holds the accumulated orthogonal transformation, 
+// d - the diagonal and e - the subdiagonal (in e[1..n-1])
+template <class T>
+void householder_tridiagonalize(Matrix<T> & v, vector<T> & d, vector<T> & e)
+{
+	unsigned n = v.nrow();
+	d.assign(n, 0);
+	e.assign(n, 0);
+
+	for (unsigned j = 0; j < n; ++j)
+		d[j] = v[n - 1][j];
+
+	for (unsigned i = n - 1; i > 0; --i)
+	{
+		T scale = 0, h = 0;
+		for (unsigned k = 0; k < i; ++k)
+			scale += fabs(d[k]);
+
+		if (scale == 0)
+		{
+			e[i] = d[i - 1];
+			for (unsigned j = 0; j < i; ++j)
+			{
+				d[j] = v[i - 1][j];
+				v[i][j] = 0;
+				v[j][i] = 0;
+			}
+		}
+		else
+		{
+			// Generate Householder vector
+			for (unsigned k = 0; k < i; ++k)
+			{
+				d[k] /= scale;
+				h += d[k] * d[k];
+			}
+
+			T f = d[i - 1];
+			T g = sqrt(h);
+			if (f > 0) g = -g;
+
+			e[i] = scale * g;
+			h -= f * g;
+			d[i - 1] = f - g;
+
+			for (unsigned j = 0; j < i; ++j)
+				e[j] = 0;
+
+			// Apply similarity transformation to remaining columns
+			for (unsigned j = 0; j < i; ++j)
+			{
+				f = d[j];
+				v[j][i] = f;
+				g = e[j] + v[j][j] * f;
+				for (unsigned k = j + 1; k < i; ++k)
+				{
+					g += v[k][j] * d[k];
+					e[k] += v[k][j] * f;
+				}
+				e[j] = g;
+			}
+
+			f = 0;
+			for (unsigned j = 0; j < i; ++j)
+			{
+				e[j] /= h;
+				f += e[j] * d[j];
+			}
+
+			T hh = f / (h + h);
+			for (unsigned j = 0; j < i; ++j)
+				e[j] -= hh * d[j];
+
+			for (unsigned j = 0; j < i; ++j)
+			{
+				f = d[j];
+				g = e[j];
+				for (unsigned k = j; k < i; ++k)
+					v[k][j] -= (f * e[k] + g * d[k]);
+
+				d[j] = v[i - 1][j];
+				v[i][j] = 0;
+			}
+		}
+
+		d[i] = h;
+	}
+
+	// Accumulate transformations
+	for (unsigned i = 0; i + 1 < n; ++i)
+	{
+		v[n - 1][i] = v[i][i];
+		v[i][i] = 1;
+
+		T h = d[i + 1];
+		if (h != 0)
+		{
+			for (unsigned k = 0; k <= i; ++k)
+				d[k] = v[k][i + 1] / h;
+
+			for (unsigned j = 0; j <= i; ++j)
+			{
+				T g = 0;
+				for (unsigned k = 0; k <= i; ++k)
+					g += v[k][i + 1] * v[k][j];
+				for (unsigned k = 0; k <= i; ++k)
+					v[k][j] -= g * d[k];
+			}
+		}
+
+		for (unsigned k = 0; k <= i; ++k)
+			v[k][i + 1] = 0;
+	}
+
+	for (unsigned j = 0; j < n; ++j)
+	{
+		d[j] = v[n - 1][j];
+		v[n - 1][j] = 0;
+	}
+
+	v[n - 1][n - 1] = 1;
+	e[0] = 0;
+}
+
+// Diagonalizes symmetric tridiagonal matrix (implicit QL with Wilkinson shifts).
+// vt is transposed transformation (eigenvectors are accumulated in its rows,
+// so that each plane rotation touches two contiguous rows)
+template <class T>
+void implicit_ql(Matrix<T> & vt, vector<T> & d, vector<T> & e)
+{
+	const unsigned max_iter = 60;
+
+	unsigned n = vt.nrow();
+
+	for (unsigned i = 1; i < n; ++i)
+		e[i - 1] = e[i];
+	e[n - 1] = 0;
+
+	T f = 0, tst1 = 0;
+	const T eps = numeric_limits<T>::epsilon();
+
+	for (unsigned l = 0; l < n; ++l)
+	{
+		// Find small subdiagonal element
+		tst1 = max(tst1, fabs(d[l]) + fabs(e[l]));
+		unsigned m = l;
+		while (m < n - 1 && fabs(e[m]) > eps * tst1)
+			++m;
+
+		// If m == l, d[l] is already an eigenvalue, otherwise iterate
+		if (m > l)
+		{
+			unsigned iter = 0;
+			do
+			{
+				if (++iter > max_iter)
+					throw exception("eigen_symmetric: QL iterations did not converge");
+
+				// Compute implicit shift
+				T g = d[l];
+				T p = (d[l + 1] - g) / (2 * e[l]);
+				T r = hypot(p, static_cast<T>(1));
+				if (p < 0) r = -r;
+
+				d[l] = e[l] / (p + r);
+				d[l + 1] = e[l] * (p + r);
+				T dl1 = d[l + 1];
+				T h = g - d[l];
+				for (unsigned i = l + 2; i < n; ++i)
+					d[i] -= h;
+				f += h;
+
+				// Implicit QL transformation
+				p = d[m];
+				T c = 1, c2 = c, c3 = c;
+				T el1 = e[l + 1];
+				T s = 0, s2 = 0;
+				for (unsigned i = m; i-- > l; )
+				{
+					c3 = c2;
+					c2 = c;
+					s2 = s;
+					g = c * e[i];
+					h = c * p;
+					r = hypot(p, e[i]);
+					e[i + 1] = s * r;
+					s = e[i] / r;
+					c = p / r;
+					p = c * d[i] - s * g;
+					d[i + 1] = h + s * (c * g + s * d[i]);
+
+					// Accumulate transformation
+					auto & vi = vt[i];
+					auto & vi1 = vt[i + 1];
+					for (unsigned k = 0; k < n; ++k)
+					{
+						h = vi1[k];
+						vi1[k] = s * vi[k] + c * h;
+						vi[k] = c * vi[k] - s * h;
+					}
+				}
+
+				p = (-s) * s2 * c3 * el1 * e[l] / dl1;
+				e[l] = s * p;
+				d[l] = c * p;
+
+			} while (fabs(e[l]) > eps * tst1);
+		}
+
+		d[l] += f;
+		e[l] = 0;
+	}
+}
+
+template <class T>
+vector<pair<T, vector<T>>> eigen_symmetric(const Matrix<T> & m)
+{
+	if (!is_square(m))
+		throw exception("eigen_symmetric(): matrix is not square");
+
+	vector<pair<T, vector<T>>> eigens;
+	unsigned n = m.nrow();
+	if (n == 0)
+		return eigens;
+
+	Matrix<T> v(m);
+	vector<T> d, e;
+
+	householder_tridiagonalize(v, d, e);
+
+	// Transpose, so that eigenvectors end up in rows
+	Matrix<T> vt(n, n);
+	for (unsigned r = 0; r < n; ++r)
+		for (unsigned c = 0; c < n; ++c)
+			vt[c][r] = v[r][c];
+
+	implicit_ql(vt, d, e);
+
+	eigens.reserve(n);
+	for (unsigned i = 0; i < n; ++i)
+		eigens.push_back(make_pair(d[i], std::move(vt[i])));
+
+	sort(eigens.begin(), eigens.end(), 
+		[](const pair<T, vector<T>> & a, const pair<T, vector<T>> & b) { return a.first > b.first; });
+
+	return eigens;
+}
+
+template <class T>
+vector<pair<T, vector<T>>> eigen_symmetric_top(const Matrix<T> & m, unsigned k, unsigned max_iter, T tolerance)
+{
+	if (!is_square(m))
+		throw exception("eigen_symmetric_top(): matrix is not square");
+
+	unsigned n = m.nrow();
+	if (k > n)
+		throw exception("eigen_symmetric_top(): k is greater than matrix size");
+
+	vector<pair<T, vector<T>>> eigens;
+	if (k == 0)
+		return eigens;
+
+	// Small problems (or almost all components requested) are cheaper to solve directly
+	unsigned p = min(n, k + max(k, 8u));
+	if (p == n)
+	{
+		eigens = eigen_symmetric(m);
+		eigens.resize(k);
+		return eigens;
+	}
+
+	// Rows of q span the current subspace (fixed seed keeps results reproducible)
+	std::mt19937 gen(5489u);
+	std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+
+	Matrix<T> q(p, n);
+	for (auto & row : q)
+		for (auto & el : row)
+			el = static_cast<T>(uniform(gen));
+
+	orthonormalize_rows(q);
+
+	for (unsigned iter = 0; iter < max_iter; ++iter)
+	{
+		// z = q * m (rows of z are m * q[i], since m is symmetric)
+		Matrix<T> z = q.multiply_by_transposed(m);
+
+		// Rayleigh-Ritz: project m onto the subspace and rotate the basis to Ritz vectors
+		Matrix<T> h = z.multiply_by_transposed(q);
+		for (unsigned i = 0; i < p; ++i)
+			for (unsigned j = i + 1; j < p; ++j)
+				h[i][j] = h[j][i] = (h[i][j] + h[j][i]) / 2;
+
+		auto ritz = eigen_symmetric(h);
+		sort(ritz.begin(), ritz.end(), 
+			[](const pair<T, vector<T>> & a, const pair<T, vector<T>> & b) { return fabs(a.first) > fabs(b.first); });
+
+		Matrix<T> w(p, 0);
+		for (unsigned i = 0; i < p; ++i)
+			w[i] = ritz[i].second;
+
+		q = w * q;
+		z = w * z;
+
+		// Converged when residuals ||m * x - lambda * x|| of the top k Ritz pairs are small
+		T scale = max(fabs(ritz[0].first), numeric_limits<T>::min());
+		bool converged = true;
+		for (unsigned i = 0; i < k && converged; ++i)
+		{
+			T residual = 0;
+			for (unsigned c = 0; c < n; ++c)
+			{
+				T diff = z[i][c] - ritz[i].first * q[i][c];
+				residual += diff * diff;
+			}
+
+			if (sqrt(residual) > tolerance * scale)
+				converged = false;
+		}
+
+		if (converged)
+		{
+			for (unsigned i = 0; i < k; ++i)
+				eigens.push_back(make_pair(ritz[i].first, std::move(q[i])));
+
+			sort(eigens.begin(), eigens.end(), 
+				[](const pair<T, vector<T>> & a, const pair<T, vector<T>> & b) { return a.first > b.first; });
+
+			return eigens;
+		}
+
+		// Next subspace
+		q.swap(z);
+		if (orthonormalize_rows(q) < p)
+		{
+			// Subspace collapsed (m has rank < p) - refill with random directions
+			for (auto & row : q)
+				if (is_zero(row))
+					for (auto & el : row)
+						el = static_cast<T>(uniform(gen));
+			orthonormalize_rows(q);
+		}
+	}
+
+	throw exception("eigen_symmetric_top(): subspace iterations did not converge");
+}
+
+template <class T>
+Matrix<T> transpose(const Matrix<T> & m)
+{
+	Matrix<T> t(m.ncol(), m.nrow());
+	for (unsigned r = 0; r < m.nrow(); ++r)
+	{
+		const auto & row = m[r];
+		for (unsigned c = 0; c < m.ncol(); ++c)
+			t[c][r] = row[c];
+	}
+
+	return t;
+}
+
+template <class T>
+void gemm(const Matrix<T> & a, const Matrix<T> & b, Matrix<T> & c, bool accumulate)
+{
+	// Block of b (rows x cols) which is reused by all rows of a while in cache
+	const unsigned BLOCK_ROWS = 64;
+	const unsigned BLOCK_COLS = 256;
+
+	if (a.ncol() != b.nrow())
+		throw exception("gemm: not compatible for multiplication");
+
+	if (!accumulate)
+		c = Matrix<T>(a.nrow(), b.ncol());
+	else if (c.nrow() != a.nrow() || c.ncol() != b.ncol())
+		throw exception("gemm: result is not compatible for accumulation");
+
+	for (unsigned kb = 0; kb < a.ncol(); kb += BLOCK_ROWS)
+	{
+		unsigned ke = min(kb + BLOCK_ROWS, a.ncol());
+
+		for (unsigned jb = 0; jb < b.ncol(); jb += BLOCK_COLS)
+		{
+			unsigned je = min(jb + BLOCK_COLS, b.ncol());
+
+			for (unsigned i = 0; i < a.nrow(); ++i)
+			{
+				const auto & ai = a[i];
+				auto & ci = c[i];
+
+				for (unsigned k = kb; k < ke; ++k)
+				{
+					T aik = ai[k];
+					if (aik == 0)
+						continue;
+
+					const auto & bk = b[k];
+					for (unsigned j = jb; j < je; ++j)
+						ci[j] += aik * bk[j];
+				}
+			}
+		}
+	}
+}
+
+template <class T>
+void gemm_tn(const Matrix<T> & a, const Matrix<T> & b, Matrix<T> & c, bool accumulate)
+{
+	const unsigned BLOCK_ROWS = 64;
+	const unsigned BLOCK_COLS = 256;
+
+	if (a.nrow() != b.nrow())
+		throw exception("gemm_tn: not compatible for multiplication");
+
+	if (!accumulate)
+		c = Matrix<T>(a.ncol(), b.ncol());
+	else if (c.nrow() != a.ncol() || c.ncol() != b.ncol())
+		throw exception("gemm_tn: result is not compatible for accumulation");
+
+	// Sum of rank-1 updates a[r]^t * b[r], blocked over r
+	for (unsigned rb = 0; rb < a.nrow(); rb += BLOCK_ROWS)
+	{
+		unsigned re = min(rb + BLOCK_ROWS, a.nrow());
+
+		for (unsigned jb = 0; jb < b.ncol(); jb += BLOCK_COLS)
+		{
+			unsigned je = min(jb + BLOCK_COLS, b.ncol());
+
+			for (unsigned i = 0; i < a.ncol(); ++i)
+			{
+				auto & ci = c[i];
+
+				for (unsigned r = rb; r < re; ++r)
+				{
+					T ari = a[r][i];
+					if (ari == 0)
+						continue;
+
+					const auto & br = b[r];
+					for (unsigned j = jb; j < je; ++j)
+						ci[j] += ari * br[j];
+				}
+			}
+		}
+	}
+}
+
+template <class T>
+bool MatrixRowBlocks<T>::read(Matrix<T> & block)
+{
+	if (next_row >= m.nrow())
+		return false;
+
+	unsigned end = min(next_row + block_size, m.nrow());
+	block.assign(m.begin() + next_row, m.begin() + end);
+	next_row = end;
+
+	return true;
+}
+
+// Returns a * b, where a is read by row blocks
+template <class RowBlocks, class T>
+Matrix<T> multiply_rows(RowBlocks & a, const Matrix<T> & b)
+{
+	Matrix<T> result, block, result_block;
+
+	a.rewind();
+	while (a.read(block))
+	{
+		gemm(block, b, result_block);
+		result.insert(result.end(), 
+			make_move_iterator(result_block.begin()), make_move_iterator(result_block.end()));
+	}
+
+	return result;
+}
+
+// Returns q^t * a, where a is read by row blocks
+template <class RowBlocks, class T>
+Matrix<T> multiply_transposed_rows(RowBlocks & a, const Matrix<T> & q)
+{
+	Matrix<T> result(q.ncol(), a.ncol()), block;
+
+	unsigned offset = 0;
+	a.rewind();
+	while (a.read(block))
+	{
+		if (offset + block.nrow() > q.nrow())
+			throw exception("randomized_svd: number of rows has changed between passes");
+
+		Matrix<T> q_block;
+		q_block.assign(q.begin() + offset, q.begin() + offset + block.nrow());
+		gemm_tn(q_block, block, result, true);
+		offset += block.nrow();
+	}
+
+	if (offset != q.nrow())
+		throw exception("randomized_svd: number of rows has changed between passes");
+
+	return result;
+}
+
+// Orthonormalizes columns of tall matrix y (m * p, m >> p) by eigendecomposition 
+// of its p * p Gramian (applied twice for accuracy). Dependent columns are dropped
+template <class T>
+void orthonormalize_cols(Matrix<T> & y)
+{
+	for (unsigned pass = 0; pass < 2 && y.ncol() > 0; ++pass)
+	{
+		Matrix<T> g;
+		gemm_tn(y, y, g);
+
+		auto eigens = eigen_symmetric(g);
+		T threshold = eigens[0].first * numeric_limits<T>::epsilon() * g.nrow();
+
+		unsigned rank = 0;
+		while (rank < eigens.size() && eigens[rank].first > threshold)
+			++rank;
+
+		// y * w * diag(1/sqrt(eigenval)) has orthonormal columns
+		Matrix<T> w(g.nrow(), rank);
+		for (unsigned j = 0; j < rank; ++j)
+		{
+			T k = 1 / sqrt(eigens[j].first);
+			for (unsigned i = 0; i < g.nrow(); ++i)
+				w[i][j] = eigens[j].second[i] * k;
+		}
+
+		Matrix<T> q;
+		gemm(y, w, q);
+		y.swap(q);
+	}
+}
+
+template <class RowBlocks>
+tuple<Matrix<typename RowBlocks::Value>, vector<typename RowBlocks::Value>, Matrix<typename RowBlocks::Value>> 
+	randomized_svd_rows(RowBlocks & a, unsigned k, unsigned oversampling, unsigned power_iter)
+{
+	typedef typename RowBlocks::Value T;
+
+	unsigned n = a.ncol();
+	if (k == 0 || k > n)
+		throw exception("randomized_svd: illegal number of singular values");
+
+	unsigned p = min(k + oversampling, n);
+
+	// Gaussian test matrix (fixed seed keeps results reproducible)
+	std::mt19937 gen(5489u);
+	std::normal_distribution<double> normal;
+
+	Matrix<T> omega(n, p);
+	for (auto & row : omega)
+		for (auto & el : row)
+			el = static_cast<T>(normal(gen));
+
+	// Orthonormal basis q (m * p) of the range of a * omega
+	Matrix<T> q = multiply_rows(a, omega);
+	if (q.empty())
+		throw exception("randomized_svd: empty matrix");
+
+	orthonormalize_cols(q);
+
+	// Power iterations sharpen the basis when singular values decay slowly
+	for (unsigned i = 0; i < power_iter && q.ncol() > 0; ++i)
+	{
+		Matrix<T> z = multiply_transposed_rows(a, q);
+		orthonormalize_rows(z);
+		q = multiply_rows(a, transpose(z));
+		orthonormalize_cols(q);
+	}
+
+	// Project: b = q^t * a is small (p * n), its SVD is obtained from b * b^t
+	Matrix<T> b = multiply_transposed_rows(a, q);
+	Matrix<T> bbt = b.multiply_by_transposed(b);
+	auto eigens = eigen_symmetric(bbt);
+
+	unsigned rank = min(k, b.nrow());
+
+	vector<T> s(k, 0);
+	Matrix<T> vt(k, n);
+	Matrix<T> w(b.nrow(), k);
+
+	for (unsigned i = 0; i < rank; ++i)
+	{
+		const auto & eigen = eigens[i];
+		if (eigen.first <= 0)
+			break;
+
+		s[i] = sqrt(eigen.first);
+
+		for (unsigned j = 0; j < b.nrow(); ++j)
+		{
+			T wj = eigen.second[j];
+			w[j][i] = wj;
+
+			T coef = wj / s[i];
+			const auto & bj = b[j];
+			for (unsigned c = 0; c < n; ++c)
+				vt[i][c] += coef * bj[c];
+		}
+	}
+
+	Matrix<T> u;
+	gemm(q, w, u);
+
+	return make_tuple(u, s, vt);
+}
+
+template <class T>
+tuple<Matrix<T>, vector<T>, Matrix<T>> randomized_svd(const Matrix<T> & a, unsigned k, 
+	unsigned oversampling, unsigned power_iter)
+{
+	MatrixRowBlocks<T> blocks(a);
+	return randomized_svd_rows(blocks, k, oversampling, power_iter);
+}
@@ -0,0 +1,152 @@
+/*                                                                 -*- C++ -*-
+ * File: mapped_file.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Whole file mapped into memory (read only, or copy-on-write)
+ *
+ */
+
+#ifndef _MAPPED_FILE_H_
+#define _MAPPED_FILE_H_
+
+#include <string>
+#include <sstream>
+#include <exception>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+
+class MappedFile
+{
+public:
+
+	MappedFile() : ptr(nullptr), len(0), opened(false) {}
+
+	/**
+	 With copy_on_write the mapping is writable: changes are private
+	 to the process and never reach the file
+	 */
+	explicit MappedFile(const string & file_name, bool copy_on_write = false) : ptr(nullptr), len(0), opened(false)
+	{
+		open(file_name, copy_on_write);
+	}
+
+	~MappedFile() { close(); }
+
+	void open(const string & file_name, bool copy_on_write = false);
+	void close();
+
+	bool is_open() const { return opened; }
+
+	// nullptr for empty file
+	char * data() { return ptr; }
+	const char * data() const { return ptr; }
+
+	size_t size() const { return len; }
+
+private:
+
+	MappedFile(const MappedFile &);
+	MappedFile & operator = (const MappedFile &);
+
+	static void open_error(const string & file_name)
+	{
+		stringstream msg;
+		msg << "can't open input file " << file_name;
+		throw exception(msg.str().c_str());
+	}
+
+	char * ptr;
+	size_t len;
+	bool opened;
+};
+
+inline void MappedFile::open(const string & file_name, bool copy_on_write)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		open_error(file_name);
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size))
+	{
+		CloseHandle(file);
+		open_error(file_name);
+	}
+
+	len = static_cast<size_t>(file_size.QuadPart);
+	if (len)
+	{
+		HANDLE mapping = CreateFileMappingA(file, NULL, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+		if (mapping)
+		{
+			ptr = static_cast<char *>(MapViewOfFile(mapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+			CloseHandle(mapping);
+		}
+	}
+	CloseHandle(file);
+#else
+	int fd = ::open(file_name.c_str(), O_RDONLY);
+	if (fd < 0)
+		open_error(file_name);
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		open_error(file_name);
+	}
+
+	len = static_cast<size_t>(st.st_size);
+	if (len)
+	{
+		void * p = mmap(NULL, len, copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+		ptr = p == MAP_FAILED ? nullptr : static_cast<char *>(p);
+		if (ptr)
+			madvise(p, len, MADV_SEQUENTIAL);
+	}
+	::close(fd);
+#endif
+
+	if (len && !ptr)
+	{
+		len = 0;
+		open_error(file_name);
+	}
+
+	opened = true;
+}
+
+inline void MappedFile::close()
+{
+	if (ptr)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(ptr);
+#else
+		munmap(ptr, len);
+#endif
+	}
+
+	ptr = nullptr;
+	len = 0;
+	opened = false;
+}
+
+#endif
@@ -16,6 +16,8 @@
 #include <vector>
 #include <initializer_list>
 
+#include "LA/expression.h"
+
 using namespace std;
 
 template <class T>
@@ -49,6 +51,13 @@ public:
 	// Creates matrix with identical columns
 	Matrix(unsigned ncol, const vector<T> & col);
 
+	// Evaluates matrix expression (see LA/expression.h) in a single pass
+	template <class E>
+	Matrix(const MatrixExpr<E> & e);
+
+	template <class E>
+	Matrix & operator = (const MatrixExpr<E> & e);
+
 	unsigned nrow() const { return size(); }
 	unsigned ncol() const { return size() ? front().size() : 0; }
 
@@ -73,6 +82,14 @@ public:
 	// Transforms according to transform function
 	void transform_self(vector<T> (*t)(const vector<T> &));
 
+	// Same as above, but for stateful transforms (function objects
+	// with vector<T> operator () (const vector<T> &) const, e.g. PCA)
+	template <class Transform>
+	Matrix get_transformed(const Transform & t) const;
+
+	template <class Transform>
+	void transform_self(const Transform & t);
+
 	// Creates binary matrix of type B according 
 	// to the label function (e.g. 1:0 or 1:-1 or true:false) 
 	template <class B>
@@ -117,6 +134,12 @@ public:
 
 	Matrix operator - (const Matrix & m) const;
 	Matrix & operator -= (const Matrix & m);
+
+	template <class E>
+	Matrix & operator += (const MatrixExpr<E> & e);
+
+	template <class E>
+	Matrix & operator -= (const MatrixExpr<E> & e);
 };
 
 template <class T>
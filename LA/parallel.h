@@ -0,0 +1,92 @@
+/*                                                                 -*- C++ -*-
+ * File: parallel.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Minimal data-parallel helpers on top of std::thread
+ *
+ */
+
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <thread>
+#include <vector>
+#include <exception>
+#include <algorithm>
+
+using namespace std;
+
+// Returns number of threads to use: nthreads, or all hardware threads if nthreads == 0
+inline unsigned resolve_threads(unsigned nthreads)
+{
+	if (nthreads)
+		return nthreads;
+
+	unsigned hw = thread::hardware_concurrency();
+	return hw ? hw : 1;
+}
+
+/**
+ Splits [begin, end) into at most nthreads contiguous chunks and calls
+ f(chunk_id, chunk_begin, chunk_end) for each of them in parallel.
+ Chunk ids are consecutive from 0, so they can index per-thread state.
+ The last chunk is processed by the calling thread.
+ The first exception thrown by f is rethrown after all chunks are done.
+ */
+template <class F>
+void parallel_for(unsigned begin, unsigned end, unsigned nthreads, F f)
+{
+	if (begin >= end)
+		return;
+
+	unsigned n = end - begin;
+	unsigned chunks = min(resolve_threads(nthreads), n);
+
+	if (chunks == 1)
+	{
+		f(0u, begin, end);
+		return;
+	}
+
+	vector<exception_ptr> errors(chunks);
+	vector<thread> workers;
+	workers.reserve(chunks - 1);
+
+	auto run = [&](unsigned chunk)
+	{
+		unsigned chunk_begin = begin + static_cast<unsigned>(static_cast<unsigned long long>(n) * chunk / chunks);
+		unsigned chunk_end = begin + static_cast<unsigned>(static_cast<unsigned long long>(n) * (chunk + 1) / chunks);
+		try
+		{
+			f(chunk, chunk_begin, chunk_end);
+		}
+		catch (...)
+		{
+			errors[chunk] = current_exception();
+		}
+	};
+
+	for (unsigned chunk = 0; chunk + 1 < chunks; ++chunk)
+		workers.push_back(thread(run, chunk));
+
+	run(chunks - 1);
+
+	for (auto & worker : workers)
+		worker.join();
+
+	for (const auto & error : errors)
+		if (error)
+			rethrow_exception(error);
+}
+
+// Number of chunks parallel_for(begin, end, nthreads, f) will create
+inline unsigned parallel_chunks(unsigned begin, unsigned end, unsigned nthreads)
+{
+	return begin < end ? min(resolve_threads(nthreads), end - begin) : 0;
+}
+
+#endif
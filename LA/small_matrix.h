@@ -0,0 +1,160 @@
+/*                                                                 -*- C++ -*-
+ * File: small_matrix.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Fixed-size vectors and matrices with stack storage
+ *   (for small geometric kernels, e.g. 2x2 covariance of pixel coordinates).
+ *   Sizes are compile-time constants (usable in constant expressions),
+ *   so loops are unrolled by the compiler and no heap allocation takes place.
+ *   Arithmetic, products, det and inv are constexpr. Norms and eigen
+ *   routines are not: they need pow, sqrt and sort, which are not
+ *   constexpr in C++17.
+ *
+ */
+
+#ifndef _SMALL_MATRIX_H_
+#define _SMALL_MATRIX_H_
+
+#include <array>
+#include <utility>
+#include <initializer_list>
+
+#include "LA/matrix.h"
+
+using namespace std;
+
+template <class T, unsigned N>
+class SmallVector : public array<T, N>
+{
+public:
+	typedef array<T, N> Super;
+
+	constexpr SmallVector() : Super() {}
+
+	// Missing elements are initialized with default value of T
+	constexpr SmallVector(const initializer_list<T> & list);
+
+	constexpr SmallVector & operator += (const SmallVector & v);
+	constexpr SmallVector & operator -= (const SmallVector & v);
+	constexpr SmallVector & operator *= (const T & t);
+	constexpr SmallVector & operator /= (const T & t);
+
+	constexpr SmallVector operator + (const SmallVector & v) const { SmallVector r(*this); return r += v; }
+	constexpr SmallVector operator - (const SmallVector & v) const { SmallVector r(*this); return r -= v; }
+	constexpr SmallVector operator * (const T & t) const { SmallVector r(*this); return r *= t; }
+	constexpr SmallVector operator / (const T & t) const { SmallVector r(*this); return r /= t; }
+};
+
+template <class T, unsigned R, unsigned C>
+class SmallMatrix : public array<SmallVector<T, C>, R>
+{
+public:
+	typedef SmallVector<T, C> Row;
+	typedef array<Row, R> Super;
+
+	constexpr SmallMatrix() : Super() {}
+
+	constexpr SmallMatrix(const initializer_list<initializer_list<T> > & list);
+
+	// Conversions from/to dynamic matrix
+	explicit SmallMatrix(const Matrix<T> & m);
+	Matrix<T> to_matrix() const;
+
+	static constexpr unsigned nrow() { return R; }
+	static constexpr unsigned ncol() { return C; }
+
+	// Creates diagonal matrix
+	static constexpr SmallMatrix diag(const T & value);
+
+	constexpr SmallMatrix & operator += (const SmallMatrix & m);
+	constexpr SmallMatrix & operator -= (const SmallMatrix & m);
+	constexpr SmallMatrix & operator *= (const T & t);
+	constexpr SmallMatrix & operator /= (const T & t);
+
+	constexpr SmallMatrix operator + (const SmallMatrix & m) const { SmallMatrix r(*this); return r += m; }
+	constexpr SmallMatrix operator - (const SmallMatrix & m) const { SmallMatrix r(*this); return r -= m; }
+	constexpr SmallMatrix operator * (const T & t) const { SmallMatrix r(*this); return r *= t; }
+	constexpr SmallMatrix operator / (const T & t) const { SmallMatrix r(*this); return r /= t; }
+
+	template <unsigned K>
+	constexpr SmallMatrix<T, R, K> operator * (const SmallMatrix<T, C, K> & m) const;
+
+	constexpr SmallVector<T, R> operator * (const SmallVector<T, C> & v) const;
+};
+
+template <class T, unsigned N>
+constexpr T inner_product(const SmallVector<T, N> & v1, const SmallVector<T, N> & v2);
+
+template <class T, unsigned N>
+constexpr T square_dist(const SmallVector<T, N> & v1, const SmallVector<T, N> & v2);
+
+template <class T, unsigned N>
+T norm(const SmallVector<T, N> & v, unsigned p);
+
+template <class T, unsigned N>
+constexpr SmallMatrix<T, N, N> outer_product(const SmallVector<T, N> & v1, const SmallVector<T, N> & v2);
+
+template <class T, unsigned R, unsigned C>
+constexpr SmallMatrix<T, C, R> transpose(const SmallMatrix<T, R, C> & m);
+
+template <class T, unsigned N>
+constexpr T tr(const SmallMatrix<T, N, N> & m);
+
+// Closed forms for 1x1, 2x2 and 3x3, Gaussian elimination otherwise
+template <class T>
+constexpr T det(const SmallMatrix<T, 1, 1> & m);
+
+template <class T>
+constexpr T det(const SmallMatrix<T, 2, 2> & m);
+
+template <class T>
+constexpr T det(const SmallMatrix<T, 3, 3> & m);
+
+template <class T, unsigned N>
+constexpr T det(const SmallMatrix<T, N, N> & m);
+
+// Adjugate for 2x2 and 3x3, Gauss-Jordan elimination otherwise
+template <class T>
+constexpr SmallMatrix<T, 2, 2> inv(const SmallMatrix<T, 2, 2> & m);
+
+template <class T>
+constexpr SmallMatrix<T, 3, 3> inv(const SmallMatrix<T, 3, 3> & m);
+
+template <class T, unsigned N>
+constexpr SmallMatrix<T, N, N> inv(const SmallMatrix<T, N, N> & m);
+
+// Same conventions as characteristic_polynomial(const Matrix<T> &)
+template <class T>
+constexpr SmallVector<T, 3> characteristic_polynomial(const SmallMatrix<T, 2, 2> & m);
+
+template <class T>
+constexpr SmallVector<T, 4> characteristic_polynomial(const SmallMatrix<T, 3, 3> & m);
+
+/**
+ Returns both (possibly equal) eigenvalues of 2x2 matrix in descending order.
+ Throws if eigenvalues are complex
+ */
+template <class T>
+SmallVector<T, 2> eigenvalues_2x2(const SmallMatrix<T, 2, 2> & m);
+
+/**
+ Returns pairs <eigenval, eigenvec> of 2x2 matrix in descending order
+ of eigenvalues. Eigenvectors are normalized
+ */
+template <class T>
+array<pair<T, SmallVector<T, 2> >, 2> eigen_2x2(const SmallMatrix<T, 2, 2> & m);
+
+/**
+ Returns pairs <eigenval, eigenvec> of symmetric matrix sorted
+ by eigenvalue in descending order (cyclic Jacobi rotations)
+ */
+template <class T, unsigned N>
+array<pair<T, SmallVector<T, N> >, N> eigen_symmetric(const SmallMatrix<T, N, N> & m);
+
+#include "LA/small_matrix_impl.h"
+
+#endif
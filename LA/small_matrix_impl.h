@@ -0,0 +1,516 @@
+/*                                                                 -*- C++ -*-
+ * File: small_matrix_impl.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+// fabs and swap are not constexpr in C++17
+template <class T>
+constexpr T small_abs(const T & x)
+{
+	return x < 0 ? -x : x;
+}
+
+template <class V>
+constexpr void small_swap(V & a, V & b)
+{
+	V tmp(a);
+	a = b;
+	b = tmp;
+}
+
+/******************************************************************************
+*
+* SmallVector
+*
+*******************************************************************************/
+
+template <class T, unsigned N>
+constexpr SmallVector<T, N>::SmallVector(const initializer_list<T> & list) : Super()
+{
+	unsigned i = 0;
+	for (auto it = list.begin(); it != list.end() && i < N; ++it, ++i)
+		(*this)[i] = *it;
+}
+
+template <class T, unsigned N>
+constexpr SmallVector<T, N> & SmallVector<T, N>::operator += (const SmallVector & v)
+{
+	for (unsigned i = 0; i < N; ++i)
+		(*this)[i] += v[i];
+
+	return *this;
+}
+
+template <class T, unsigned N>
+constexpr SmallVector<T, N> & SmallVector<T, N>::operator -= (const SmallVector & v)
+{
+	for (unsigned i = 0; i < N; ++i)
+		(*this)[i] -= v[i];
+
+	return *this;
+}
+
+template <class T, unsigned N>
+constexpr SmallVector<T, N> & SmallVector<T, N>::operator *= (const T & t)
+{
+	for (unsigned i = 0; i < N; ++i)
+		(*this)[i] *= t;
+
+	return *this;
+}
+
+template <class T, unsigned N>
+constexpr SmallVector<T, N> & SmallVector<T, N>::operator /= (const T & t)
+{
+	for (unsigned i = 0; i < N; ++i)
+		(*this)[i] /= t;
+
+	return *this;
+}
+
+template <class T, unsigned N>
+constexpr T inner_product(const SmallVector<T, N> & v1, const SmallVector<T, N> & v2)
+{
+	T retval = 0;
+	for (unsigned i = 0; i < N; ++i)
+		retval += v1[i] * v2[i];
+
+	return retval;
+}
+
+template <class T, unsigned N>
+constexpr T square_dist(const SmallVector<T, N> & v1, const SmallVector<T, N> & v2)
+{
+	T result = 0;
+	for (unsigned i = 0; i < N; ++i)
+		result += (v1[i] - v2[i]) * (v1[i] - v2[i]);
+
+	return result;
+}
+
+template <class T, unsigned N>
+T norm(const SmallVector<T, N> & v, unsigned p)
+{
+	if (p < 1)
+		throw exception("norm of vector is not defined for p < 1");
+
+	T sum = 0;
+	for (unsigned i = 0; i < N; ++i)
+		sum += static_cast<T>(pow(fabs(v[i]), p));
+
+	return static_cast<T>(pow(sum, static_cast<T>(1) / p));
+}
+
+template <class T, unsigned N>
+constexpr SmallMatrix<T, N, N> outer_product(const SmallVector<T, N> & v1, const SmallVector<T, N> & v2)
+{
+	SmallMatrix<T, N, N> m;
+	for (unsigned i = 0; i < N; ++i)
+		for (unsigned j = 0; j < N; ++j)
+			m[i][j] = v1[i] * v2[j];
+
+	return m;
+}
+
+/******************************************************************************
+*
+* SmallMatrix
+*
+*******************************************************************************/
+
+template <class T, unsigned R, unsigned C>
+constexpr SmallMatrix<T, R, C>::SmallMatrix(const initializer_list<initializer_list<T> > & list) : Super()
+{
+	unsigned r = 0;
+	for (auto it = list.begin(); it != list.end() && r < R; ++it, ++r)
+		(*this)[r] = Row(*it);
+}
+
+template <class T, unsigned R, unsigned C>
+SmallMatrix<T, R, C>::SmallMatrix(const Matrix<T> & m)
+{
+	if (m.nrow() != R || m.ncol() != C)
+		throw exception("SmallMatrix: inconsistent size");
+
+	for (unsigned r = 0; r < R; ++r)
+		for (unsigned c = 0; c < C; ++c)
+			(*this)[r][c] = m[r][c];
+}
+
+template <class T, unsigned R, unsigned C>
+Matrix<T> SmallMatrix<T, R, C>::to_matrix() const
+{
+	Matrix<T> m(R, C);
+	for (unsigned r = 0; r < R; ++r)
+		for (unsigned c = 0; c < C; ++c)
+			m[r][c] = (*this)[r][c];
+
+	return m;
+}
+
+template <class T, unsigned R, unsigned C>
+constexpr SmallMatrix<T, R, C> SmallMatrix<T, R, C>::diag(const T & value)
+{
+	SmallMatrix<T, R, C> m;
+	for (unsigned i = 0; i < R && i < C; ++i)
+		m[i][i] = value;
+
+	return m;
+}
+
+template <class T, unsigned R, unsigned C>
+constexpr SmallMatrix<T, R, C> & SmallMatrix<T, R, C>::operator += (const SmallMatrix & m)
+{
+	for (unsigned r = 0; r < R; ++r)
+		(*this)[r] += m[r];
+
+	return *this;
+}
+
+template <class T, unsigned R, unsigned C>
+constexpr SmallMatrix<T, R, C> & SmallMatrix<T, R, C>::operator -= (const SmallMatrix & m)
+{
+	for (unsigned r = 0; r < R; ++r)
+		(*this)[r] -= m[r];
+
+	return *this;
+}
+
+template <class T, unsigned R, unsigned C>
+constexpr SmallMatrix<T, R, C> & SmallMatrix<T, R, C>::operator *= (const T & t)
+{
+	for (unsigned r = 0; r < R; ++r)
+		(*this)[r] *= t;
+
+	return *this;
+}
+
+template <class T, unsigned R, unsigned C>
+constexpr SmallMatrix<T, R, C> & SmallMatrix<T, R, C>::operator /= (const T & t)
+{
+	for (unsigned r = 0; r < R; ++r)
+		(*this)[r] /= t;
+
+	return *this;
+}
+
+template <class T, unsigned R, unsigned C>
+template <unsigned K>
+constexpr SmallMatrix<T, R, K> SmallMatrix<T, R, C>::operator * (const SmallMatrix<T, C, K> & m) const
+{
+	SmallMatrix<T, R, K> res;
+	for (unsigned r = 0; r < R; ++r)
+		for (unsigned k = 0; k < C; ++k)
+		{
+			T a = (*this)[r][k];
+			for (unsigned c = 0; c < K; ++c)
+				res[r][c] += a * m[k][c];
+		}
+
+	return res;
+}
+
+template <class T, unsigned R, unsigned C>
+constexpr SmallVector<T, R> SmallMatrix<T, R, C>::operator * (const SmallVector<T, C> & v) const
+{
+	SmallVector<T, R> res;
+	for (unsigned r = 0; r < R; ++r)
+		res[r] = inner_product((*this)[r], v);
+
+	return res;
+}
+
+template <class T, unsigned R, unsigned C>
+constexpr SmallMatrix<T, C, R> transpose(const SmallMatrix<T, R, C> & m)
+{
+	SmallMatrix<T, C, R> t;
+	for (unsigned r = 0; r < R; ++r)
+		for (unsigned c = 0; c < C; ++c)
+			t[c][r] = m[r][c];
+
+	return t;
+}
+
+template <class T, unsigned N>
+constexpr T tr(const SmallMatrix<T, N, N> & m)
+{
+	T tr = 0;
+	for (unsigned i = 0; i < N; ++i)
+		tr += m[i][i];
+
+	return tr;
+}
+
+template <class T>
+constexpr T det(const SmallMatrix<T, 1, 1> & m)
+{
+	return m[0][0];
+}
+
+template <class T>
+constexpr T det(const SmallMatrix<T, 2, 2> & m)
+{
+	return m[0][0] * m[1][1] - m[0][1] * m[1][0];
+}
+
+template <class T>
+constexpr T det(const SmallMatrix<T, 3, 3> & m)
+{
+	return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+		- m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+		+ m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+template <class T, unsigned N>
+constexpr T det(const SmallMatrix<T, N, N> & m)
+{
+	// Gaussian elimination with partial pivoting on a copy
+	SmallMatrix<T, N, N> a(m);
+	T d = 1;
+
+	for (unsigned pivot = 0; pivot < N; ++pivot)
+	{
+		unsigned max_row = pivot;
+		for (unsigned r = pivot + 1; r < N; ++r)
+			if (small_abs(a[r][pivot]) > small_abs(a[max_row][pivot]))
+				max_row = r;
+
+		if (a[max_row][pivot] == 0)
+			return 0;
+
+		if (max_row != pivot)
+		{
+			small_swap(a[max_row], a[pivot]);
+			d = -d;
+		}
+
+		d *= a[pivot][pivot];
+
+		for (unsigned r = pivot + 1; r < N; ++r)
+		{
+			T ratio = a[r][pivot] / a[pivot][pivot];
+			for (unsigned c = pivot; c < N; ++c)
+				a[r][c] -= a[pivot][c] * ratio;
+		}
+	}
+
+	return d;
+}
+
+template <class T>
+constexpr SmallMatrix<T, 2, 2> inv(const SmallMatrix<T, 2, 2> & m)
+{
+	T d = det(m);
+	if (d == 0)
+		throw exception("matrix cannot be inverted\n");
+
+	SmallMatrix<T, 2, 2> res;
+	res[0][0] = m[1][1] / d;
+	res[0][1] = -m[0][1] / d;
+	res[1][0] = -m[1][0] / d;
+	res[1][1] = m[0][0] / d;
+
+	return res;
+}
+
+template <class T>
+constexpr SmallMatrix<T, 3, 3> inv(const SmallMatrix<T, 3, 3> & m)
+{
+	T d = det(m);
+	if (d == 0)
+		throw exception("matrix cannot be inverted\n");
+
+	SmallMatrix<T, 3, 3> res;
+	res[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) / d;
+	res[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) / d;
+	res[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) / d;
+	res[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) / d;
+	res[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) / d;
+	res[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) / d;
+	res[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) / d;
+	res[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) / d;
+	res[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) / d;
+
+	return res;
+}
+
+template <class T, unsigned N>
+constexpr SmallMatrix<T, N, N> inv(const SmallMatrix<T, N, N> & m)
+{
+	// Gauss-Jordan elimination with partial pivoting
+	SmallMatrix<T, N, N> a(m), inverse(SmallMatrix<T, N, N>::diag(1));
+
+	for (unsigned pivot = 0; pivot < N; ++pivot)
+	{
+		unsigned max_row = pivot;
+		for (unsigned r = pivot + 1; r < N; ++r)
+			if (small_abs(a[r][pivot]) > small_abs(a[max_row][pivot]))
+				max_row = r;
+
+		if (a[max_row][pivot] == 0)
+			throw exception("matrix cannot be inverted\n");
+
+		small_swap(a[max_row], a[pivot]);
+		small_swap(inverse[max_row], inverse[pivot]);
+
+		T k = a[pivot][pivot];
+		a[pivot] /= k;
+		inverse[pivot] /= k;
+
+		for (unsigned r = 0; r < N; ++r)
+		{
+			if (r == pivot)
+				continue;
+
+			T ratio = a[r][pivot];
+			for (unsigned c = 0; c < N; ++c)
+			{
+				a[r][c] -= a[pivot][c] * ratio;
+				inverse[r][c] -= inverse[pivot][c] * ratio;
+			}
+		}
+	}
+
+	return inverse;
+}
+
+template <class T>
+constexpr SmallVector<T, 3> characteristic_polynomial(const SmallMatrix<T, 2, 2> & m)
+{
+	return SmallVector<T, 3>({ 1, (-1) * tr(m), det(m) });
+}
+
+template <class T>
+constexpr SmallVector<T, 4> characteristic_polynomial(const SmallMatrix<T, 3, 3> & m)
+{
+	T trace = tr(m);
+	T c = (trace * trace - tr(m * m)) / (-2);
+	return SmallVector<T, 4>({ (-1), trace, c, det(m) });
+}
+
+template <class T>
+SmallVector<T, 2> eigenvalues_2x2(const SmallMatrix<T, 2, 2> & m)
+{
+	T half_tr = tr(m) / 2;
+	T d = half_tr * half_tr - det(m);
+
+	if (d < 0)
+		throw exception("eigenvalues_2x2(): eigenvalues are complex");
+
+	T root = sqrt(d);
+	return SmallVector<T, 2>({ half_tr + root, half_tr - root });
+}
+
+template <class T>
+array<pair<T, SmallVector<T, 2> >, 2> eigen_2x2(const SmallMatrix<T, 2, 2> & m)
+{
+	SmallVector<T, 2> eigenvalues = eigenvalues_2x2(m);
+
+	array<pair<T, SmallVector<T, 2> >, 2> eigens;
+	for (unsigned i = 0; i < 2; ++i)
+	{
+		T eigenval = eigenvalues[i];
+
+		// Take a non-zero row of (m - eigenval * I) and
+		// choose eigenvector orthogonal to it
+		SmallVector<T, 2> eigenvec;
+		T a = m[0][0] - eigenval, b = m[0][1];
+		T c = m[1][0], d = m[1][1] - eigenval;
+
+		if (fabs(a) + fabs(b) >= fabs(c) + fabs(d))
+			eigenvec = SmallVector<T, 2>({ -b, a });
+		else
+			eigenvec = SmallVector<T, 2>({ -d, c });
+
+		T length = norm(eigenvec, 2);
+		if (length == 0)
+		{
+			// m is eigenval * I - any vector is eigenvector
+			eigenvec = SmallVector<T, 2>({ static_cast<T>(i == 0), static_cast<T>(i == 1) });
+			length = 1;
+		}
+
+		eigens[i] = make_pair(eigenval, eigenvec / length);
+	}
+
+	return eigens;
+}
+
+template <class T, unsigned N>
+array<pair<T, SmallVector<T, N> >, N> eigen_symmetric(const SmallMatrix<T, N, N> & m)
+{
+	const unsigned max_sweeps = 50;
+
+	SmallMatrix<T, N, N> a(m);
+	SmallMatrix<T, N, N> v(SmallMatrix<T, N, N>::diag(1));
+
+	for (unsigned sweep = 0; sweep < max_sweeps; ++sweep)
+	{
+		T off = 0, total = 0;
+		for (unsigned p = 0; p < N; ++p)
+			for (unsigned q = 0; q < N; ++q)
+			{
+				total += a[p][q] * a[p][q];
+				if (p != q)
+					off += a[p][q] * a[p][q];
+			}
+
+		if (off <= total * numeric_limits<T>::epsilon() * numeric_limits<T>::epsilon())
+			break;
+
+		for (unsigned p = 0; p + 1 < N; ++p)
+			for (unsigned q = p + 1; q < N; ++q)
+			{
+				if (a[p][q] == 0)
+					continue;
+
+				// Rotation which annihilates a[p][q]
+				T theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+				T t = (theta >= 0 ? 1 : -1) / (fabs(theta) + sqrt(theta * theta + 1));
+				T c = 1 / sqrt(t * t + 1);
+				T s = t * c;
+
+				for (unsigned k = 0; k < N; ++k)
+				{
+					T akp = a[k][p], akq = a[k][q];
+					a[k][p] = c * akp - s * akq;
+					a[k][q] = s * akp + c * akq;
+				}
+
+				for (unsigned k = 0; k < N; ++k)
+				{
+					T apk = a[p][k], aqk = a[q][k];
+					a[p][k] = c * apk - s * aqk;
+					a[q][k] = s * apk + c * aqk;
+				}
+
+				for (unsigned k = 0; k < N; ++k)
+				{
+					T vkp = v[k][p], vkq = v[k][q];
+					v[k][p] = c * vkp - s * vkq;
+					v[k][q] = s * vkp + c * vkq;
+				}
+			}
+	}
+
+	// Eigenvectors are columns of v
+	array<pair<T, SmallVector<T, N> >, N> eigens;
+	for (unsigned i = 0; i < N; ++i)
+	{
+		eigens[i].first = a[i][i];
+		for (unsigned k = 0; k < N; ++k)
+			eigens[i].second[k] = v[k][i];
+	}
+
+	sort(eigens.begin(), eigens.end(),
+		[](const pair<T, SmallVector<T, N> > & x, const pair<T, SmallVector<T, N> > & y) { return x.first > y.first; });
+
+	return eigens;
+}
@@ -0,0 +1,123 @@
+/*                                                                 -*- C++ -*-
+ * File: sparse_matrix.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Sparse matrix in compressed sparse row (CSR) format.
+ *   Compressed sparse column (CSC) form of a matrix is CSR of its
+ *   transpose (see transpose()).
+ *
+ *   Non-zeros are stored as (index, value) pairs, each row followed
+ *   by terminator with index -1. For T = double this is exactly
+ *   the layout of libsvm svm_node and liblinear feature_node,
+ *   so rows can be passed to these libraries without copying
+ *   (see nodes()). Index of stored element is column + index_base
+ *   (libsvm/liblinear expect index_base = 1).
+ *
+ */
+
+#ifndef _SPARSE_MATRIX_H_
+#define _SPARSE_MATRIX_H_
+
+#include <vector>
+
+#include "LA/matrix.h"
+
+using namespace std;
+
+template <class T>
+struct SparseEntry
+{
+	int index;
+	T value;
+};
+
+template <class T>
+class SparseMatrix
+{
+public:
+	typedef SparseEntry<T> Entry;
+
+	// Creates empty matrix (0 rows) with ncol columns
+	SparseMatrix(unsigned ncol = 0, int index_base = 0);
+
+	// Converts dense matrix, columns before first_col are skipped
+	// (e.g. constant column x0 = 1 in our data sets)
+	template <class U>
+	explicit SparseMatrix(const Matrix<U> & m, unsigned first_col = 0, int index_base = 0);
+
+	unsigned nrow() const { return offsets.size() - 1; }
+	unsigned ncol() const { return cols; }
+
+	// Number of stored (non-zero) elements
+	unsigned nnz() const { return entries.size() - nrow(); }
+
+	int base() const { return index_base; }
+
+	// Appends row, skipping zeros. Elements before first_col are skipped
+	template <class U>
+	void add_row(const vector<U> & row, unsigned first_col = 0);
+
+	// Non-zeros of row r: [row_begin(r), row_end(r)), row_end(r) points to terminator
+	const Entry * row_begin(unsigned r) const { return entries.data() + offsets[r]; }
+	const Entry * row_end(unsigned r) const { return entries.data() + offsets[r + 1] - 1; }
+
+	unsigned column(const Entry & e) const { return e.index - index_base; }
+
+	// Returns rows [begin, end)
+	SparseMatrix rows(unsigned begin, unsigned end) const;
+
+	Matrix<T> to_matrix() const;
+
+	// Zero-copy view of row r as terminated array of Node
+	// (svm_node, feature_node or any other struct { int index; T value; })
+	template <class Node>
+	Node * nodes(unsigned r);
+
+	template <class Node>
+	const Node * nodes(unsigned r) const;
+
+	template <class U>
+	friend SparseMatrix<U> transpose(const SparseMatrix<U> & m);
+
+private:
+
+	template <class Node>
+	static void check_layout();
+
+	unsigned cols;
+	int index_base;
+
+	// Offset of each row in entries (nrow + 1 elements)
+	vector<unsigned> offsets;
+
+	// Non-zeros of all rows, each row is terminated by index -1
+	vector<Entry> entries;
+};
+
+// Returns transpose (i.e. CSC form of m)
+template <class T>
+SparseMatrix<T> transpose(const SparseMatrix<T> & m);
+
+// SpMV: m * v
+template <class T>
+vector<T> operator * (const SparseMatrix<T> & m, const vector<T> & v);
+
+// m^t * v without building transpose
+template <class T>
+vector<T> multiply_transposed(const SparseMatrix<T> & m, const vector<T> & v);
+
+// SpMM: sparse * dense
+template <class T>
+Matrix<T> operator * (const SparseMatrix<T> & a, const Matrix<T> & b);
+
+// SpMM: dense * sparse
+template <class T>
+Matrix<T> operator * (const Matrix<T> & a, const SparseMatrix<T> & b);
+
+#include "LA/sparse_matrix_impl.h"
+
+#endif
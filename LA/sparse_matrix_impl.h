@@ -0,0 +1,227 @@
+/*                                                                 -*- C++ -*-
+ * File: sparse_matrix_impl.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ */
+
+#include <cstddef>
+
+template <class T>
+SparseMatrix<T>::SparseMatrix(unsigned ncol, int index_base) :
+	cols(ncol), index_base(index_base), offsets(1, 0)
+{
+}
+
+template <class T>
+template <class U>
+SparseMatrix<T>::SparseMatrix(const Matrix<U> & m, unsigned first_col, int index_base) :
+	cols(m.ncol() > first_col ? m.ncol() - first_col : 0), index_base(index_base), offsets(1, 0)
+{
+	// Count non-zeros first to allocate storage once
+	unsigned nz = 0;
+	for (const auto & row : m)
+		for (unsigned c = first_col; c < row.size(); ++c)
+			if (row[c] != 0)
+				++nz;
+
+	offsets.reserve(m.nrow() + 1);
+	entries.reserve(nz + m.nrow());
+
+	for (const auto & row : m)
+		add_row(row, first_col);
+}
+
+template <class T>
+template <class U>
+void SparseMatrix<T>::add_row(const vector<U> & row, unsigned first_col)
+{
+	if (row.size() != cols + first_col)
+		throw exception("SparseMatrix: inconsistent num of columns");
+
+	for (unsigned c = first_col; c < row.size(); ++c)
+		if (row[c] != 0)
+		{
+			Entry e = { static_cast<int>(c - first_col) + index_base, static_cast<T>(row[c]) };
+			entries.push_back(e);
+		}
+
+	Entry terminator = { -1, 0 };
+	entries.push_back(terminator);
+	offsets.push_back(entries.size());
+}
+
+template <class T>
+SparseMatrix<T> SparseMatrix<T>::rows(unsigned begin, unsigned end) const
+{
+	if (begin > end || end > nrow())
+		throw exception("SparseMatrix: row range is out of bounds");
+
+	SparseMatrix<T> res(cols, index_base);
+	res.entries.assign(entries.begin() + offsets[begin], entries.begin() + offsets[end]);
+	res.offsets.resize(end - begin + 1);
+	for (unsigned r = begin; r <= end; ++r)
+		res.offsets[r - begin] = offsets[r] - offsets[begin];
+
+	return res;
+}
+
+template <class T>
+Matrix<T> SparseMatrix<T>::to_matrix() const
+{
+	Matrix<T> m(nrow(), cols, 0);
+	for (unsigned r = 0; r < nrow(); ++r)
+		for (const Entry * e = row_begin(r); e != row_end(r); ++e)
+			m[r][column(*e)] = e->value;
+
+	return m;
+}
+
+template <class T>
+template <class Node>
+void SparseMatrix<T>::check_layout()
+{
+	static_assert(sizeof(Node) == sizeof(Entry), "SparseMatrix::nodes(): inconsistent node size");
+	static_assert(offsetof(Node, index) == offsetof(Entry, index), "SparseMatrix::nodes(): inconsistent node layout");
+	static_assert(offsetof(Node, value) == offsetof(Entry, value), "SparseMatrix::nodes(): inconsistent node layout");
+	static_assert(sizeof(Node().value) == sizeof(T), "SparseMatrix::nodes(): inconsistent value type");
+}
+
+template <class T>
+template <class Node>
+Node * SparseMatrix<T>::nodes(unsigned r)
+{
+	check_layout<Node>();
+	return reinterpret_cast<Node *>(entries.data() + offsets[r]);
+}
+
+template <class T>
+template <class Node>
+const Node * SparseMatrix<T>::nodes(unsigned r) const
+{
+	check_layout<Node>();
+	return reinterpret_cast<const Node *>(entries.data() + offsets[r]);
+}
+
+template <class T>
+SparseMatrix<T> transpose(const SparseMatrix<T> & m)
+{
+	// Counting sort of non-zeros by column
+	vector<unsigned> counts(m.ncol(), 0);
+	for (unsigned r = 0; r < m.nrow(); ++r)
+		for (auto e = m.row_begin(r); e != m.row_end(r); ++e)
+			++counts[m.column(*e)];
+
+	SparseMatrix<T> t(m.nrow(), m.base());
+
+	// Every row of t gets its terminator, so rows are filled in place
+	vector<unsigned> pos(m.ncol());
+	t.entries.resize(m.nnz() + m.ncol());
+	t.offsets.assign(m.ncol() + 1, 0);
+	for (unsigned c = 0; c < m.ncol(); ++c)
+	{
+		pos[c] = t.offsets[c];
+		t.offsets[c + 1] = t.offsets[c] + counts[c] + 1;
+		t.entries[t.offsets[c + 1] - 1].index = -1;
+		t.entries[t.offsets[c + 1] - 1].value = 0;
+	}
+
+	// Rows of m are visited in order, so indices within each row of t are sorted
+	for (unsigned r = 0; r < m.nrow(); ++r)
+		for (auto e = m.row_begin(r); e != m.row_end(r); ++e)
+		{
+			auto & dst = t.entries[pos[m.column(*e)]++];
+			dst.index = static_cast<int>(r) + m.base();
+			dst.value = e->value;
+		}
+
+	return t;
+}
+
+template <class T>
+vector<T> operator * (const SparseMatrix<T> & m, const vector<T> & v)
+{
+	if (m.ncol() != v.size())
+		throw exception("not compatible for operator '*'");
+
+	vector<T> res(m.nrow());
+	for (unsigned r = 0; r < m.nrow(); ++r)
+	{
+		T sum = 0;
+		for (auto e = m.row_begin(r); e != m.row_end(r); ++e)
+			sum += e->value * v[m.column(*e)];
+
+		res[r] = sum;
+	}
+
+	return res;
+}
+
+template <class T>
+vector<T> multiply_transposed(const SparseMatrix<T> & m, const vector<T> & v)
+{
+	if (m.nrow() != v.size())
+		throw exception("not compatible for operator '*'");
+
+	vector<T> res(m.ncol(), 0);
+	for (unsigned r = 0; r < m.nrow(); ++r)
+	{
+		if (v[r] == 0)
+			continue;
+
+		for (auto e = m.row_begin(r); e != m.row_end(r); ++e)
+			res[m.column(*e)] += e->value * v[r];
+	}
+
+	return res;
+}
+
+template <class T>
+Matrix<T> operator * (const SparseMatrix<T> & a, const Matrix<T> & b)
+{
+	if (a.ncol() != b.nrow())
+		throw exception("not compatible for operator '*'");
+
+	// Row r of result is combination of rows of b, selected by non-zeros of a[r]
+	Matrix<T> res(a.nrow(), b.ncol(), 0);
+	for (unsigned r = 0; r < a.nrow(); ++r)
+	{
+		auto & res_row = res[r];
+		for (auto e = a.row_begin(r); e != a.row_end(r); ++e)
+		{
+			const auto & b_row = b[a.column(*e)];
+			T value = e->value;
+			for (unsigned c = 0; c < b_row.size(); ++c)
+				res_row[c] += value * b_row[c];
+		}
+	}
+
+	return res;
+}
+
+template <class T>
+Matrix<T> operator * (const Matrix<T> & a, const SparseMatrix<T> & b)
+{
+	if (a.ncol() != b.nrow())
+		throw exception("not compatible for operator '*'");
+
+	// Row r of result is combination of sparse rows of b, weighted by a[r]
+	Matrix<T> res(a.nrow(), b.ncol(), 0);
+	for (unsigned r = 0; r < a.nrow(); ++r)
+	{
+		const auto & a_row = a[r];
+		auto & res_row = res[r];
+		for (unsigned k = 0; k < a_row.size(); ++k)
+		{
+			T value = a_row[k];
+			if (value == 0)
+				continue;
+
+			for (auto e = b.row_begin(k); e != b.row_end(k); ++e)
+				res_row[b.column(*e)] += value * e->value;
+		}
+	}
+
+	return res;
+}
@@ -1,301 +1,805 @@
-/*                                                                 -*- C++ -*-
- * File: matrix_tests.cpp
- * 
- * Author: Ilya Ivensky
- * 
- * Created on: Dec 19, 2013
- *
- * Description:
- *   Boost unit tests for matrix
- *   
- */
-
-#include <boost/assign/list_of.hpp>
-#include <boost/test/unit_test.hpp>
-
-#include <iostream>
-
-#include "LA/matrix.h"
-#include "LA/linear_algebra.h"
-
-using namespace std;
-using boost::unit_test_framework::test_suite;
-
-void gramian_test()
-{
-	Matrix<int> m = { 
-		{  24,   0,  30 },
-		{  24,  30, -30 },
-		{  -6,   0,   0 },
-		{  -6,   0,  30 },
-		{ -36, -30, -30 }
-	};
-
-	Matrix<int> g = {
-		{ 2520, 1800,  900 },
-		{ 1800, 1800,    0 },
-		{  900,    0, 3600 }
-	};
-	
-	BOOST_REQUIRE(gram(m) == g); 
-}
-
-void covariance_test()
-{
-	Matrix<int> m = { 
-		{ 90, 60, 90 },
-		{ 90, 90, 30 },
-		{ 60, 60, 60 },
-		{ 60, 60, 90 },
-		{ 30, 30, 30 }
-	};
-
-	Matrix<int> c = { 
-		{ 504, 360, 180 },
-		{ 360, 360,   0 },
-		{ 180,   0, 720 }
-	};
-
-	BOOST_REQUIRE(cov(m) == c); 
-}
-
-void inverse_test()
-{
-	Matrix<float> a;
-	a.add_row({ 1, 0 });
-	a.add_row({ 2, 2 });
-
-	Matrix<float> a1;
-	a1.add_row(boost::assign::list_of<float>( 1)(  0));
-	a1.add_row(boost::assign::list_of<float>(-1)(0.5));
-
-	BOOST_REQUIRE(inv(a) == a1);
-}
-
-void inverse_test2()
-{
-	Matrix<float> a(2, 2);
-	a[0][0] = 1, a[0][1] = 0;
-	a[1][0] = 2, a[1][1] = 2;
-
-	Matrix<float> a1 = inv(a);
-
-	BOOST_REQUIRE(a * a1 == Matrix<float>::diag(2, 1.0));
-}
-
-void determinant3_test()
-{
-	Matrix<float> m = {
-		{ -2,  2, -3 },
-		{ -1,  1,  3 },
-		{  2,  0, -1 }
-	};
-
-	BOOST_REQUIRE(det(m) == 18);
-}
-
-void determinant4_test()
-{
-	Matrix<int> m = {
-		{  1,  2,  3,  4 },
-		{  5,  6,  7,  8 },
-		{  9, 10, 11, 12 },
-		{ 13, 14, 15, 16 }
-	};
-
-	BOOST_REQUIRE(det(m) == 0);
-}
-
-void determinant5_test()
-{
-	Matrix<double> m(
-		{
-			{ 1,  8, -9,  7,  5 },
-			{ 0,  1,  0,  4,  4 },
-			{ 0,  0,  1,  2,  5 },
-			{ 0,  0,  0,  1, -5 },
-			{ 0,  0,  0,  0,  1 }
-		}
-	);
-
-	BOOST_REQUIRE(det(m) == 1);
-}
-
-void rref_test1()
-{
-	Matrix<double> m = {
-		{  1,  2,  3,  4 },
-		{  5,  6,  7,  8 },
-		{  9, 10, 11, 12 },
-		{ 13, 14, 15, 16 }
-	};
-
-	Matrix<double> ech = {
-		{1,  0, -1, -2},
-		{0,  1,  2,  3}
-	};
-
-	auto res = rref(m);
-
-	BOOST_REQUIRE(res == ech);
-}
-
-void rref_test2()
-{
-	Matrix<int> m(
-		{
-			{ 1,  8, -9,  7,  5 },
-			{ 0,  1,  0,  4,  4 },
-			{ 0,  0,  1,  2,  5 },
-			{ 0,  0,  0,  1, -5 },
-			{ 0,  0,  0,  0,  1 }
-		}
-	);
-
-	BOOST_REQUIRE(rref(m) == Matrix<int>::diag(5, 1));
-}
-
-void linear_solution_test()
-{
-	Matrix<float> a = {
-		{ 1, 2, 2 },
-		{ 2, 2, 2 },
-		{ 2, 2, 1 }
-	};
-
-	Matrix<float> y = {
-		{ 1 },
-		{ 2 },
-		{ 3 }
-	};
-
-	Matrix<float> x = {
-		{ 1 },
-		{ 1 },
-		{ -1 }
-	};
-
-	BOOST_REQUIRE(linear_solution(a, y) == x);
-}
-
-template <class T>
-void eigen_2x2_test(const Matrix<T> & m)
-{
-	Matrix<T> zeros(2, 1, 0);
-	vector<pair<T, vector<T>>> eigens = eigen_2x2(m);
-	for (const auto & eigen : eigens)
-	{
-		auto a = m - Matrix<T>::diag(2, eigen.first);
-		BOOST_REQUIRE(det(a) == 0);
-		BOOST_REQUIRE(a * eigen.second == zeros);
-	}
-}
-
-void eigen_2x2_test1()
-{
-	Matrix<float> m = { 
-		{ 1, 2 },
-		{ 4, 3 }
-	};
- 
-	eigen_2x2_test(m);
-}
-
-void eigen_2x2_test2()
-{
-	Matrix<float> m = {
-		{ 1, -4 },
-		{ 4, -7 }
-	};
-
-	eigen_2x2_test(m);
-}
-
-void characteristic_polynomial_3x3_test()
-{
-	Matrix<double> m = {
-		{ 3, 2, 4 },
-		{ 2, 0, 2 },
-		{ 4, 2, 3 }
-	};
-
-	vector<double> cp = { -1, 6, 15, 8 };
-	BOOST_REQUIRE(characteristic_polynomial(m) == cp);
-}
-
-void square_dist_test()
-{
-	vector<int> v1 = { 1, 2, 3 };
-	vector<int> v2 = { 0, 4, 1 };
-
-	BOOST_REQUIRE(square_dist(v1, v2) == 9);
-}
-
-void norm_test()
-{
-	vector<int> vi = { 3, 4 };
-	BOOST_REQUIRE(norm(vi, 2) == 5);
-
-	vector<float> vf = { 3, 4 };
-	BOOST_REQUIRE(norm(vf, 2) == 5);
-}
-
-void lu_test1()
-{
-	Matrix<double> pasc = {
-		{ 1,  1,  1,  1 },
-		{ 1,  2,  3,  4 },
-		{ 1,  3,  6, 10 },
-		{ 1,  4, 10, 20 }
-	};
-
-	Matrix<double> p, l, u;
-	tie(l, u, p) = lu(pasc);
-
-	BOOST_REQUIRE(l * u == p * pasc);
-}
-
-void lu_test2()
-{
-	Matrix<double> m = {
-		{ 0, 1, 1 },
-		{ 1, 2, 1 },
-		{ 2, 7, 9 }
-	};
-
-	Matrix<double> p, l, u;
-	tie(l, u, p) = lu(m);
-
-	BOOST_REQUIRE(l * u == p * m);
-}
-
-boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
-{
-    test_suite* test = BOOST_TEST_SUITE("Matrix test suite");
-
-    test->add(BOOST_TEST_CASE(&gramian_test));
-	test->add(BOOST_TEST_CASE(&covariance_test));
-	test->add(BOOST_TEST_CASE(&inverse_test));
-	test->add(BOOST_TEST_CASE(&inverse_test2));
-	test->add(BOOST_TEST_CASE(&determinant3_test));
-	test->add(BOOST_TEST_CASE(&determinant4_test));
-	test->add(BOOST_TEST_CASE(&determinant5_test));
-	test->add(BOOST_TEST_CASE(&linear_solution_test));
-	test->add(BOOST_TEST_CASE(&rref_test1));
-	test->add(BOOST_TEST_CASE(&rref_test2));
-	test->add(BOOST_TEST_CASE(&square_dist_test));
-	test->add(BOOST_TEST_CASE(&norm_test));
-	test->add(BOOST_TEST_CASE(&eigen_2x2_test1));
-	test->add(BOOST_TEST_CASE(&eigen_2x2_test2));
-	test->add(BOOST_TEST_CASE(&characteristic_polynomial_3x3_test));
-	test->add(BOOST_TEST_CASE(&lu_test1));
-	test->add(BOOST_TEST_CASE(&lu_test2));
-
-    return test;
-}
-
-int run_test(int argc, char* argv[])
-{
-  boost::unit_test::init_unit_test_func init_func = &init_unit_test_suite;
-  return ::boost::unit_test::unit_test_main(init_func, argc, argv );
-}
+/*                                                                 -*- C++ -*-
+ * File: matrix_tests.cpp
+ * 
+ * Author: Ilya Ivensky
+ * 
+ * Created on: Dec 19, 2013
+ *
+ * Description:
+ *   Boost unit tests for matrix
+ *   
+ */
+
+#include <boost/assign/list_of.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <iostream>
+#include <cstdlib>
+#include <new>
+
+#include "LA/matrix.h"
+#include "LA/linear_algebra.h"
+#include "LA/small_matrix.h"
+#include "LA/sparse_matrix.h"
+#include "LA/fast_math.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+void gramian_test()
+{
+	Matrix<int> m = { 
+		{  24,   0,  30 },
+		{  24,  30, -30 },
+		{  -6,   0,   0 },
+		{  -6,   0,  30 },
+		{ -36, -30, -30 }
+	};
+
+	Matrix<int> g = {
+		{ 2520, 1800,  900 },
+		{ 1800, 1800,    0 },
+		{  900,    0, 3600 }
+	};
+	
+	BOOST_REQUIRE(gram(m) == g); 
+}
+
+void covariance_test()
+{
+	Matrix<int> m = { 
+		{ 90, 60, 90 },
+		{ 90, 90, 30 },
+		{ 60, 60, 60 },
+		{ 60, 60, 90 },
+		{ 30, 30, 30 }
+	};
+
+	Matrix<int> c = { 
+		{ 504, 360, 180 },
+		{ 360, 360,   0 },
+		{ 180,   0, 720 }
+	};
+
+	BOOST_REQUIRE(cov(m) == c); 
+}
+
+void inverse_test()
+{
+	Matrix<float> a;
+	a.add_row({ 1, 0 });
+	a.add_row({ 2, 2 });
+
+	Matrix<float> a1;
+	a1.add_row(boost::assign::list_of<float>( 1)(  0));
+	a1.add_row(boost::assign::list_of<float>(-1)(0.5));
+
+	BOOST_REQUIRE(inv(a) == a1);
+}
+
+void inverse_test2()
+{
+	Matrix<float> a(2, 2);
+	a[0][0] = 1, a[0][1] = 0;
+	a[1][0] = 2, a[1][1] = 2;
+
+	Matrix<float> a1 = inv(a);
+
+	BOOST_REQUIRE(a * a1 == Matrix<float>::diag(2, 1.0));
+}
+
+void determinant3_test()
+{
+	Matrix<float> m = {
+		{ -2,  2, -3 },
+		{ -1,  1,  3 },
+		{  2,  0, -1 }
+	};
+
+	BOOST_REQUIRE(det(m) == 18);
+}
+
+void determinant4_test()
+{
+	Matrix<int> m = {
+		{  1,  2,  3,  4 },
+		{  5,  6,  7,  8 },
+		{  9, 10, 11, 12 },
+		{ 13, 14, 15, 16 }
+	};
+
+	BOOST_REQUIRE(det(m) == 0);
+}
+
+void determinant5_test()
+{
+	Matrix<double> m(
+		{
+			{ 1,  8, -9,  7,  5 },
+			{ 0,  1,  0,  4,  4 },
+			{ 0,  0,  1,  2,  5 },
+			{ 0,  0,  0,  1, -5 },
+			{ 0,  0,  0,  0,  1 }
+		}
+	);
+
+	BOOST_REQUIRE(det(m) == 1);
+}
+
+void rref_test1()
+{
+	Matrix<double> m = {
+		{  1,  2,  3,  4 },
+		{  5,  6,  7,  8 },
+		{  9, 10, 11, 12 },
+		{ 13, 14, 15, 16 }
+	};
+
+	Matrix<double> ech = {
+		{1,  0, -1, -2},
+		{0,  1,  2,  3}
+	};
+
+	auto res = rref(m);
+
+	BOOST_REQUIRE(res == ech);
+}
+
+void rref_test2()
+{
+	Matrix<int> m(
+		{
+			{ 1,  8, -9,  7,  5 },
+			{ 0,  1,  0,  4,  4 },
+			{ 0,  0,  1,  2,  5 },
+			{ 0,  0,  0,  1, -5 },
+			{ 0,  0,  0,  0,  1 }
+		}
+	);
+
+	BOOST_REQUIRE(rref(m) == Matrix<int>::diag(5, 1));
+}
+
+void linear_solution_test()
+{
+	Matrix<float> a = {
+		{ 1, 2, 2 },
+		{ 2, 2, 2 },
+		{ 2, 2, 1 }
+	};
+
+	Matrix<float> y = {
+		{ 1 },
+		{ 2 },
+		{ 3 }
+	};
+
+	Matrix<float> x = {
+		{ 1 },
+		{ 1 },
+		{ -1 }
+	};
+
+	BOOST_REQUIRE(linear_solution(a, y) == x);
+}
+
+template <class T>
+void eigen_2x2_test(const Matrix<T> & m)
+{
+	Matrix<T> zeros(2, 1, 0);
+	vector<pair<T, vector<T>>> eigens = eigen_2x2(m);
+	for (const auto & eigen : eigens)
+	{
+		auto a = m - Matrix<T>::diag(2, eigen.first);
+		BOOST_REQUIRE(det(a) == 0);
+		BOOST_REQUIRE(a * eigen.second == zeros);
+	}
+}
+
+void eigen_2x2_test1()
+{
+	Matrix<float> m = { 
+		{ 1, 2 },
+		{ 4, 3 }
+	};
+ 
+	eigen_2x2_test(m);
+}
+
+void eigen_2x2_test2()
+{
+	Matrix<float> m = {
+		{ 1, -4 },
+		{ 4, -7 }
+	};
+
+	eigen_2x2_test(m);
+}
+
+void characteristic_polynomial_3x3_test()
+{
+	Matrix<double> m = {
+		{ 3, 2, 4 },
+		{ 2, 0, 2 },
+		{ 4, 2, 3 }
+	};
+
+	vector<double> cp = { -1, 6, 15, 8 };
+	BOOST_REQUIRE(characteristic_polynomial(m) == cp);
+}
+
+void square_dist_test()
+{
+	vector<int> v1 = { 1, 2, 3 };
+	vector<int> v2 = { 0, 4, 1 };
+
+	BOOST_REQUIRE(square_dist(v1, v2) == 9);
+}
+
+void norm_test()
+{
+	vector<int> vi = { 3, 4 };
+	BOOST_REQUIRE(norm(vi, 2) == 5);
+
+	vector<float> vf = { 3, 4 };
+	BOOST_REQUIRE(norm(vf, 2) == 5);
+}
+
+void lu_test1()
+{
+	Matrix<double> pasc = {
+		{ 1,  1,  1,  1 },
+		{ 1,  2,  3,  4 },
+		{ 1,  3,  6, 10 },
+		{ 1,  4, 10, 20 }
+	};
+
+	Matrix<double> p, l, u;
+	tie(l, u, p) = lu(pasc);
+
+	BOOST_REQUIRE(l * u == p * pasc);
+}
+
+void lu_test2()
+{
+	Matrix<double> m = {
+		{ 0, 1, 1 },
+		{ 1, 2, 1 },
+		{ 2, 7, 9 }
+	};
+
+	Matrix<double> p, l, u;
+	tie(l, u, p) = lu(m);
+
+	BOOST_REQUIRE(l * u == p * m);
+}
+
+template <class T>
+void eigen_symmetric_check(const Matrix<T> & m, const vector<pair<T, vector<T>>> & eigens, T tolerance)
+{
+	for (unsigned i = 0; i < eigens.size(); ++i)
+	{
+		const auto & eigen = eigens[i];
+
+		if (i > 0)
+			BOOST_REQUIRE(eigens[i - 1].first >= eigen.first);
+
+		BOOST_REQUIRE(fabs(norm(eigen.second, 2) - 1) < tolerance);
+
+		Matrix<T> av = m * eigen.second;
+		for (unsigned r = 0; r < m.nrow(); ++r)
+			BOOST_REQUIRE(fabs(av[r][0] - eigen.first * eigen.second[r]) < tolerance);
+	}
+}
+
+void eigen_symmetric_test()
+{
+	Matrix<double> m = {
+		{ 4, 1, 2, 0 },
+		{ 1, 3, 0, 1 },
+		{ 2, 0, 5, 2 },
+		{ 0, 1, 2, 1 }
+	};
+
+	auto eigens = eigen_symmetric(m);
+
+	BOOST_REQUIRE(eigens.size() == 4);
+	eigen_symmetric_check(m, eigens, 1e-9);
+
+	// Sum of eigenvalues is the trace
+	double sum = 0;
+	for (const auto & eigen : eigens)
+		sum += eigen.first;
+	BOOST_REQUIRE(fabs(sum - tr(m)) < 1e-9);
+
+	Matrix<double> d = Matrix<double>::diag(3, 2);
+	d[1][1] = 7;
+	auto diag_eigens = eigen_symmetric(d);
+	BOOST_REQUIRE(fabs(diag_eigens[0].first - 7) < 1e-12);
+	BOOST_REQUIRE(fabs(diag_eigens[1].first - 2) < 1e-12);
+	BOOST_REQUIRE(fabs(diag_eigens[2].first - 2) < 1e-12);
+}
+
+void eigen_symmetric_top_test()
+{
+	// Covariance of deterministic pseudo-random data (positive semi-definite)
+	Matrix<double> x(200, 40);
+	unsigned seed = 1;
+	for (unsigned r = 0; r < x.nrow(); ++r)
+		for (unsigned c = 0; c < x.ncol(); ++c)
+		{
+			seed = seed * 1103515245 + 12345;
+			x[r][c] = static_cast<double>((seed >> 16) % 1000) / 1000 * (c % 5 + 1);
+		}
+
+	Matrix<double> c = cov(x);
+
+	auto all = eigen_symmetric(c);
+	auto top = eigen_symmetric_top(c, 4, 1000, 1e-10);
+
+	BOOST_REQUIRE(top.size() == 4);
+	eigen_symmetric_check(c, top, 1e-6);
+
+	for (unsigned i = 0; i < top.size(); ++i)
+		BOOST_REQUIRE(fabs(top[i].first - all[i].first) < 1e-8 * all[0].first);
+
+	// Unconverged Ritz pairs are not returned
+	BOOST_REQUIRE_THROW(eigen_symmetric_top(c, 4, 1, 1e-14), exception);
+	BOOST_REQUIRE_THROW(eigen_symmetric_top(c, 4, 0), exception);
+}
+
+void gemm_test()
+{
+	Matrix<double> a = {
+		{ 1, 0, 2 },
+		{ 0, 3, 1 }
+	};
+
+	Matrix<double> b = {
+		{ 1, 2 },
+		{ 0, 1 },
+		{ 4, 0 }
+	};
+
+	Matrix<double> c;
+	gemm(a, b, c);
+	BOOST_REQUIRE(c == a * b);
+
+	gemm(a, b, c, true);
+	Matrix<double> twice = a * b;
+	twice *= 2;
+	BOOST_REQUIRE(c == twice);
+
+	Matrix<double> ctn;
+	gemm_tn(b, b, ctn);
+	BOOST_REQUIRE(ctn == transpose(b) * b);
+	BOOST_REQUIRE(ctn == gram(b));
+}
+
+void randomized_svd_test()
+{
+	// a = 12 * u1 * v1^t + 5 * u2 * v2^t + 1 * u3 * v3^t (rank 3, 300 * 40)
+	unsigned m = 300, n = 40;
+	double sigma[] = { 12, 5, 1 };
+
+	Matrix<double> u(3, m), v(3, n);
+	unsigned seed = 7;
+	for (auto & row : u)
+		for (auto & el : row)
+		{
+			seed = seed * 1103515245 + 12345;
+			el = static_cast<double>((seed >> 16) % 1000) / 1000 - 0.5;
+		}
+	for (auto & row : v)
+		for (auto & el : row)
+		{
+			seed = seed * 1103515245 + 12345;
+			el = static_cast<double>((seed >> 16) % 1000) / 1000 - 0.5;
+		}
+	orthonormalize_rows(u);
+	orthonormalize_rows(v);
+
+	Matrix<double> a(m, n);
+	for (unsigned i = 0; i < 3; ++i)
+		for (unsigned r = 0; r < m; ++r)
+			for (unsigned c = 0; c < n; ++c)
+				a[r][c] += sigma[i] * u[i][r] * v[i][c];
+
+	Matrix<double> left, vt;
+	vector<double> s;
+	tie(left, s, vt) = randomized_svd(a, 3, 5, 1);
+
+	BOOST_REQUIRE(s.size() == 3);
+	for (unsigned i = 0; i < 3; ++i)
+		BOOST_REQUIRE(fabs(s[i] - sigma[i]) < 1e-8);
+
+	// Reconstruction from row blocks
+	MatrixRowBlocks<double> blocks(a, 64);
+	tie(left, s, vt) = randomized_svd_rows(blocks, 2);
+
+	BOOST_REQUIRE(left.nrow() == m && left.ncol() == 2);
+	BOOST_REQUIRE(vt.nrow() == 2 && vt.ncol() == n);
+	for (unsigned r = 0; r < m; ++r)
+		for (unsigned c = 0; c < n; ++c)
+		{
+			double approx = left[r][0] * s[0] * vt[0][c] + left[r][1] * s[1] * vt[1][c];
+			double expected = a[r][c] - sigma[2] * u[2][r] * v[2][c];
+			BOOST_REQUIRE(fabs(approx - expected) < 1e-8);
+		}
+}
+
+// Row blocks of matrix which loses its last row after the first pass
+class ShrinkingRowBlocks
+{
+public:
+	typedef double Value;
+
+	ShrinkingRowBlocks(const Matrix<double> & a) : m(a), blocks(m, 4), passes(0) {}
+
+	unsigned ncol() const { return m.ncol(); }
+
+	void rewind()
+	{
+		if (passes++ == 1)
+			m.pop_back();
+		blocks.rewind();
+	}
+
+	bool read(Matrix<double> & block) { return blocks.read(block); }
+
+private:
+	Matrix<double> m;
+	MatrixRowBlocks<double> blocks;
+	unsigned passes;
+};
+
+void randomized_svd_changed_rows_test()
+{
+	Matrix<double> a(10, 6);
+	for (unsigned r = 0; r < a.nrow(); ++r)
+		for (unsigned c = 0; c < a.ncol(); ++c)
+			a[r][c] = (r * 7 + c * 3) % 5;
+
+	// Rows left uncomputed by the short pass must not go unnoticed
+	ShrinkingRowBlocks blocks(a);
+	BOOST_REQUIRE_THROW(randomized_svd_rows(blocks, 2, 2, 0), exception);
+}
+
+// Counts heap allocations to verify that expression templates do not create temporaries
+static unsigned long allocations = 0;
+
+void * operator new (size_t size)
+{
+	++allocations;
+	void * p = malloc(size ? size : 1);
+	if (!p)
+		throw bad_alloc();
+	return p;
+}
+
+void operator delete (void * p) throw()
+{
+	free(p);
+}
+
+void operator delete (void * p, size_t) throw()
+{
+	free(p);
+}
+
+void expression_vector_test()
+{
+	vector<double> a = { 1, 2, 3, 4 };
+	vector<double> b = { 4, 3, 2, 1 };
+	vector<double> c = { 1, 1, 1, 1 };
+	vector<double> res(4);
+
+	unsigned long before = allocations;
+	assign(res, lazy(a) - lazy(b) * 2.0 + c);
+	a -= lazy(b) * 0.5;
+	BOOST_REQUIRE(allocations == before);
+
+	vector<double> expected = { -6, -3, 0, 3 };
+	BOOST_REQUIRE(res == expected);
+
+	vector<double> expected_a = { -1, 0.5, 2, 3.5 };
+	BOOST_REQUIRE(a == expected_a);
+
+	BOOST_REQUIRE(eval(lazy(b) / 2.0 + lazy(c)) == vector<double>({ 3, 2.5, 2, 1.5 }));
+}
+
+void expression_matrix_test()
+{
+	Matrix<double> a = {
+		{ 1, 2, 3 },
+		{ 4, 5, 6 }
+	};
+
+	Matrix<double> b = {
+		{ 1, 0, 1 },
+		{ 0, 1, 0 }
+	};
+
+	vector<double> mean = { 2, 2, 2 };
+
+	// Only the result is allocated (one vector of rows and one per row)
+	unsigned long before = allocations;
+	Matrix<double> res(lazy(a) - lazy(b) * 2.0 + a - broadcast_rows(mean, 2));
+	BOOST_REQUIRE(allocations == before + 1 + res.nrow());
+
+	Matrix<double> expected = {
+		{ -2, 2, 2 },
+		{ 6, 6, 10 }
+	};
+	BOOST_REQUIRE(res == expected);
+
+	// Evaluation into matrix of the same shape is done in place
+	before = allocations;
+	res = lazy(res) / 2.0;
+	res += lazy(b) * 3.0;
+	res -= broadcast_rows(mean, 2);
+	BOOST_REQUIRE(allocations == before);
+
+	Matrix<double> expected2 = {
+		{ 0, -1, 2 },
+		{ 1, 4, 3 }
+	};
+	BOOST_REQUIRE(res == expected2);
+
+	// Rows read other rows of the target: evaluated into a temporary
+	Matrix<double> m = a;
+	m = lazy(m) - broadcast_rows(m[0], 2);
+	Matrix<double> expected3 = {
+		{ 0, 0, 0 },
+		{ 3, 3, 3 }
+	};
+	BOOST_REQUIRE(m == expected3);
+
+	m = a;
+	m -= broadcast_rows(m[1], 2) * 2.0;
+	Matrix<double> expected4 = {
+		{ -7, -8, -9 },
+		{ -4, -5, -6 }
+	};
+	BOOST_REQUIRE(m == expected4);
+
+	m = a;
+	m += broadcast_rows(m[0], 2);
+	Matrix<double> expected5 = {
+		{ 2, 4, 6 },
+		{ 5, 7, 9 }
+	};
+	BOOST_REQUIRE(m == expected5);
+
+	// Existing operators give the same results
+	BOOST_REQUIRE(a + b == eval(lazy(a) + b));
+	BOOST_REQUIRE(a - b == eval(lazy(a) - b));
+}
+
+template <unsigned N>
+double distance_to_identity(const SmallMatrix<double, N, N> & m)
+{
+	double dist = 0;
+	for (unsigned r = 0; r < N; ++r)
+		for (unsigned c = 0; c < N; ++c)
+			dist = max(dist, fabs(m[r][c] - (r == c ? 1 : 0)));
+
+	return dist;
+}
+
+void small_matrix_test()
+{
+	static_assert(SmallMatrix<double, 2, 3>::nrow() == 2 && SmallMatrix<double, 2, 3>::ncol() == 3, "sizes are constant expressions");
+
+	// Fixed-size operations are evaluated at compile time
+	constexpr SmallMatrix<double, 4, 4> lower = {
+		{ 2, 0, 0, 0 },
+		{ 1, 4, 0, 0 },
+		{ 0, 2, 1, 0 },
+		{ 0, 0, 0, 8 }
+	};
+	constexpr SmallMatrix<double, 2, 2> small = {
+		{ 1, 2 },
+		{ 3, 4 }
+	};
+	static_assert(det(lower) == 64 && tr(lower) == 15, "det and tr are constant expressions");
+	static_assert(inv(lower)[0][0] == 0.5 && inv(lower)[1][0] == -0.125 && inv(lower)[3][3] == 0.125, "inv is a constant expression");
+	static_assert(det(small) == -2 && inv(small)[1][0] == 1.5, "closed forms are constant expressions");
+	static_assert((small * small)[1][1] == 22 && (small * SmallVector<double, 2>({ 1, 1 }))[0] == 3, "products are constant expressions");
+	static_assert(transpose(small + small)[0][1] == 6 && characteristic_polynomial(small)[1] == -5, "constant expressions");
+
+	Matrix<double> m = {
+		{ -2,  2, -3 },
+		{ -1,  1,  3 },
+		{  2,  0, -1 }
+	};
+
+	SmallMatrix<double, 3, 3> s(m);
+	BOOST_REQUIRE(s.to_matrix() == m);
+	BOOST_REQUIRE(det(s) == det(m));
+	BOOST_REQUIRE(distance_to_identity(s * inv(s)) < 1e-12);
+
+	Matrix<double> m5 = {
+		{ 1,  8, -9,  7,  5 },
+		{ 0,  1,  0,  4,  4 },
+		{ 0,  0,  1,  2,  5 },
+		{ 0,  0,  0,  1, -5 },
+		{ 0,  0,  0,  0,  1 }
+	};
+
+	SmallMatrix<double, 5, 5> s5(m5);
+	BOOST_REQUIRE(det(s5) == 1);
+	BOOST_REQUIRE(distance_to_identity(s5 * inv(s5)) < 1e-12);
+
+	SmallMatrix<float, 2, 2> s2 = {
+		{ 1, 2 },
+		{ 4, 3 }
+	};
+
+	auto eigens = eigen_2x2(s2);
+	BOOST_REQUIRE(eigens[0].first == 5);
+	BOOST_REQUIRE(eigens[1].first == -1);
+	for (const auto & e : eigens)
+		BOOST_REQUIRE(square_dist(s2 * e.second, e.second * e.first) < 1e-10);
+}
+
+void small_eigen_symmetric_test()
+{
+	Matrix<double> m = {
+		{ 3, 2, 4 },
+		{ 2, 0, 2 },
+		{ 4, 2, 3 }
+	};
+
+	SmallMatrix<double, 3, 3> s(m);
+	auto eigens = eigen_symmetric(s);
+	auto expected = eigen_symmetric(m);
+
+	for (unsigned i = 0; i < 3; ++i)
+	{
+		BOOST_REQUIRE(fabs(eigens[i].first - expected[i].first) < 1e-9);
+		BOOST_REQUIRE(square_dist(s * eigens[i].second, eigens[i].second * eigens[i].first) < 1e-18);
+	}
+}
+
+void small_matrix_allocation_test()
+{
+	SmallMatrix<double, 2, 2> s = {
+		{ 2, 1 },
+		{ 1, 2 }
+	};
+	SmallVector<double, 2> v = { 1, -1 };
+
+	unsigned long before = allocations;
+
+	auto p = inv(s) * (s * v) + v / 2;
+	auto eigens = eigen_symmetric(s + outer_product(v, v));
+	double d = det(s * transpose(s));
+
+	BOOST_REQUIRE(allocations == before);
+	BOOST_REQUIRE(square_dist(p, v * 1.5) < 1e-20);
+	BOOST_REQUIRE(fabs(eigens[0].first - 3) < 1e-12);
+	BOOST_REQUIRE(d == 9);
+}
+
+void sparse_matrix_test()
+{
+	Matrix<double> m = {
+		{ 1, 0, 0, 2 },
+		{ 0, 0, 0, 0 },
+		{ 0, 3, 0, 4 }
+	};
+
+	SparseMatrix<double> s(m);
+	BOOST_REQUIRE(s.nrow() == 3 && s.ncol() == 4 && s.nnz() == 4);
+	BOOST_REQUIRE(s.to_matrix() == m);
+	BOOST_REQUIRE(transpose(s).to_matrix() == transpose(m));
+	BOOST_REQUIRE(s.rows(1, 3).to_matrix() == Matrix<double>({ m[1], m[2] }));
+
+	vector<double> v = { 1, 2, 3, 4 };
+	BOOST_REQUIRE(s * v == vector<double>({ 9, 0, 22 }));
+	BOOST_REQUIRE(multiply_transposed(s, vector<double>({ 1, 2, 3 })) == vector<double>({ 1, 9, 0, 14 }));
+
+	Matrix<double> b = {
+		{ 1, 2 },
+		{ 3, 4 },
+		{ 5, 6 },
+		{ 7, 8 }
+	};
+
+	BOOST_REQUIRE(s * b == m * b);
+	BOOST_REQUIRE(transpose(b) * transpose(s) == transpose(b) * transpose(m));
+}
+
+// Same layout as svm_node / feature_node
+struct test_node
+{
+	int index;
+	double value;
+};
+
+void sparse_matrix_nodes_test()
+{
+	Matrix<float> m = {
+		{ 1, 0.5, 0, 2 },
+		{ 1, 0, 0, 0 }
+	};
+
+	// Skip constant column, use 1-based indices
+	SparseMatrix<double> s(m, 1, 1);
+	BOOST_REQUIRE(s.ncol() == 3 && s.nnz() == 2);
+
+	const test_node * x = s.nodes<test_node>(0);
+	BOOST_REQUIRE(x[0].index == 1 && x[0].value == 0.5);
+	BOOST_REQUIRE(x[1].index == 3 && x[1].value == 2);
+	BOOST_REQUIRE(x[2].index == -1);
+
+	BOOST_REQUIRE(s.nodes<test_node>(1)[0].index == -1);
+}
+
+void fast_exp_test()
+{
+	vector<float> f;
+	vector<double> d;
+	for (double x = -80; x < 80; x += 0.37)
+		f.push_back(static_cast<float>(x)), d.push_back(x);
+
+	vector<float> ef(f);
+	vector<double> ed(d);
+	exp_inplace(ef.data(), ef.size());
+	exp_inplace(ed.data(), ed.size());
+
+	for (unsigned i = 0; i < f.size(); ++i)
+	{
+		BOOST_REQUIRE(fabs(ef[i] - exp(f[i])) <= 2 * numeric_limits<float>::epsilon() * exp(f[i]));
+		BOOST_REQUIRE(fabs(ed[i] - exp(d[i])) <= 2 * numeric_limits<double>::epsilon() * exp(d[i]));
+	}
+
+	float underflow = -1000;
+	exp_inplace(&underflow, 1);
+	BOOST_REQUIRE(underflow == 0);
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+    test_suite* test = BOOST_TEST_SUITE("Matrix test suite");
+
+    test->add(BOOST_TEST_CASE(&gramian_test));
+	test->add(BOOST_TEST_CASE(&covariance_test));
+	test->add(BOOST_TEST_CASE(&inverse_test));
+	test->add(BOOST_TEST_CASE(&inverse_test2));
+	test->add(BOOST_TEST_CASE(&determinant3_test));
+	test->add(BOOST_TEST_CASE(&determinant4_test));
+	test->add(BOOST_TEST_CASE(&determinant5_test));
+	test->add(BOOST_TEST_CASE(&linear_solution_test));
+	test->add(BOOST_TEST_CASE(&rref_test1));
+	test->add(BOOST_TEST_CASE(&rref_test2));
+	test->add(BOOST_TEST_CASE(&square_dist_test));
+	test->add(BOOST_TEST_CASE(&norm_test));
+	test->add(BOOST_TEST_CASE(&eigen_2x2_test1));
+	test->add(BOOST_TEST_CASE(&eigen_2x2_test2));
+	test->add(BOOST_TEST_CASE(&characteristic_polynomial_3x3_test));
+	test->add(BOOST_TEST_CASE(&lu_test1));
+	test->add(BOOST_TEST_CASE(&lu_test2));
+	test->add(BOOST_TEST_CASE(&eigen_symmetric_test));
+	test->add(BOOST_TEST_CASE(&eigen_symmetric_top_test));
+	test->add(BOOST_TEST_CASE(&gemm_test));
+	test->add(BOOST_TEST_CASE(&randomized_svd_test));
+	test->add(BOOST_TEST_CASE(&randomized_svd_changed_rows_test));
+	test->add(BOOST_TEST_CASE(&expression_vector_test));
+	test->add(BOOST_TEST_CASE(&expression_matrix_test));
+	test->add(BOOST_TEST_CASE(&small_matrix_test));
+	test->add(BOOST_TEST_CASE(&small_eigen_symmetric_test));
+	test->add(BOOST_TEST_CASE(&small_matrix_allocation_test));
+	test->add(BOOST_TEST_CASE(&sparse_matrix_test));
+	test->add(BOOST_TEST_CASE(&sparse_matrix_nodes_test));
+	test->add(BOOST_TEST_CASE(&fast_exp_test));
+
+    return test;
+}
+
+int run_test(int argc, char* argv[])
+{
+  boost::unit_test::init_unit_test_func init_func = &init_unit_test_suite;
+  return ::boost::unit_test::unit_test_main(init_func, argc, argv );
+}
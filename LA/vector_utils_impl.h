@@ -42,7 +42,7 @@ T square_dist(const vector<T> & v1, const vector<T> & v2)
 	T result = 0;
 	for (auto it1 = v1.begin(), it1End = v1.end(),
 		it2 = v2.begin(); it1 != it1End; ++it1, ++it2)
-		result += static_cast<T>(pow(*it1 - *it2, 2));
+		result += (*it1 - *it2) * (*it1 - *it2);
 
 	return result;
 }
@@ -10,90 +10,735 @@
 #ifndef _CLUSTERING_H
 #define _CLUSTERING_H
 
+#include <random>
+#include <limits>
+
 #include "LA/matrix.h"
+#include "LA/parallel.h"
 
 using namespace std;
 
 /************************************************************
-* Implements Lloyd's algorithm
-* Returns matrix of k cluster centers
-* (or empty matrix if fails to create k non-empty clusters)
+* K-means clustering
+*  - k-means++ seeding
+*  - Lloyd's iterations (or mini-batch updates) with
+*    assignment done in parallel, each thread accumulating
+*    its own centroid sums
+*  - Elkan's and Hamerly's variants of Lloyd's iterations
+*    keep bounds on distances to centers (triangle inequality)
+*    and skip distance computations which cannot change
+*    the assignment. Results are the same as of Lloyd's.
+*    Elkan's keeps n*k lower bounds, Hamerly's only one per example,
+*    which is usually faster for low dimensions or small k
+*  - empty clusters are moved to the farthest points
+*  - stops when total squared shift of centers is below
+*    tolerance * (mean variance of features)
 ************************************************************/
 template <class T>
-Matrix<T> k_means_clusterung(const Matrix<T> & x, unsigned k)
+class KMeans
 {
-	// Select initial k points
-	Matrix<T> mu(k, x.col);
-	mu.random_init_0();
+public:
+
+	enum Algorithm { LLOYD, ELKAN, HAMERLY };
+
+	// Creates and configures clustering.
+	// batch_size = 0 runs full-batch iterations, otherwise each
+	// iteration updates centers from batch_size randomly sampled examples.
+	// Single-threaded by default, nthreads = 0 uses all hardware threads
+	KMeans(unsigned k, unsigned max_iter = 300, double tolerance = 1e-4,
+		unsigned batch_size = 0, unsigned nthreads = 1, unsigned seed = 5489) :
+		k(k), max_iter(max_iter), tolerance(tolerance),
+		batch_size(batch_size), nthreads(nthreads), rng(seed), algorithm(LLOYD), niter(0), inertia(0) {}
+
+	// Full-batch algorithm (ignored in mini-batch mode)
+	void set_algorithm(Algorithm a) { algorithm = a; }
+	Algorithm get_algorithm() const { return algorithm; }
+
+	// Clusters rows of x. Returns matrix k*dim of cluster centers
+	const Matrix<T> & fit(const Matrix<T> & x);
+
+	// Returns index of the nearest center
+	unsigned predict(const vector<T> & x) const;
+
+	// Trained
+	const Matrix<T> & get_centers() const { return centers; }
+
+	// Cluster of each example of the last fitted data set
+	const vector<unsigned> & get_labels() const { return labels; }
+
+	// Sum of squared distances to the nearest centers
+	double get_inertia() const { return inertia; }
+
+	unsigned get_niter() const { return niter; }
+
+	// Number of distance computations (example-center and center-center)
+	// of each iteration. The last element is the final assignment pass
+	const vector<unsigned long long> & get_distance_evaluations() const { return evaluations; }
+
+private:
+
+	static T squared_distance(const vector<T> & a, const vector<T> & b);
 
-	unsigned count = 0;
+	// Returns index of the nearest center, dist is set to squared distance to it
+	static unsigned nearest(const vector<T> & x, const Matrix<T> & centers, T & dist);
 
-	while (true)
+	void seed(const Matrix<T> & x);
+
+	// Assignment steps: set labels and dist, return num of distance computations
+	unsigned long long assign(const Matrix<T> & x);
+	unsigned long long init_bounds(const Matrix<T> & x);
+	unsigned long long assign_elkan(const Matrix<T> & x);
+	unsigned long long assign_hamerly(const Matrix<T> & x);
+
+	// Distances between centers and half distance to the nearest other center
+	unsigned long long center_distances();
+
+	// Per-center sums and counts of examples for current labels
+	void accumulate(const Matrix<T> & x, Matrix<double> & sums, vector<unsigned> & counts);
+
+	// Moves each empty cluster to the example farthest from its center
+	void repair_empty(const Matrix<T> & x, vector<unsigned> & counts, Matrix<double> * sums);
+
+	// Moves centers to the means of clusters. Returns total squared shift
+	double update_centers(const Matrix<double> & sums, const vector<unsigned> & counts);
+
+	// Loosens bounds by movement of centers
+	void update_bounds();
+
+	void full_batch(const Matrix<T> & x, double tol);
+	void mini_batch(const Matrix<T> & x, double tol);
+
+	unsigned long long total_evaluations() const;
+
+	// Parameters
+	unsigned k;
+	unsigned max_iter;
+	double tolerance;
+	unsigned batch_size;
+	unsigned nthreads;
+	mt19937 rng;
+	Algorithm algorithm;
+
+	// Trained
+	Matrix<T> centers;
+	vector<unsigned> labels;
+	vector<T> dist;  // squared distance of each example to its center (upper bound in Elkan/Hamerly)
+	unsigned niter;
+	double inertia;
+	vector<unsigned long long> evaluations;
+
+	// Bounds (Elkan, Hamerly)
+	vector<T> upper;         // on distance to assigned center
+	vector<T> lower;         // on distance to the second nearest center (Hamerly)
+	Matrix<T> lower_bounds;  // on distance to each center, n*k (Elkan)
+	Matrix<T> center_dist;   // k*k
+	vector<T> half_min;      // half distance from each center to the nearest other one
+	vector<T> movement;      // of each center during last update
+	vector<unsigned> repaired;
+
+	// Per-thread accumulators
+	vector<Matrix<double> > thread_sums;
+	vector<vector<unsigned> > thread_counts;
+	vector<unsigned long long> thread_evals;
+};
+
+template <class T>
+T KMeans<T>::squared_distance(const vector<T> & a, const vector<T> & b)
+{
+	T dist = 0;
+	for (unsigned i = 0; i < a.size(); ++i)
+		dist += (a[i] - b[i]) * (a[i] - b[i]);
+
+	return dist;
+}
+
+template <class T>
+unsigned KMeans<T>::nearest(const vector<T> & x, const Matrix<T> & centers, T & dist)
+{
+	unsigned nearest = 0;
+	dist = numeric_limits<T>::max();
+
+	for (unsigned c = 0; c < centers.nrow(); ++c)
 	{
-		Matrix<T> mu_next(mu.row, mu.col);
-		// Each cluster contains IDs of examples
-		typedef vector<unsigned> Cluster;
-		vector<Cluster> clusters(k);
+		T curr_dist = squared_distance(x, centers[c]);
+		if (curr_dist < dist)
+		{
+			dist = curr_dist;
+			nearest = c;
+		}
+	}
+
+	return nearest;
+}
+
+template <class T>
+const Matrix<T> & KMeans<T>::fit(const Matrix<T> & x)
+{
+	unsigned n = x.nrow();
+	unsigned dim = x.ncol();
+
+	if (k == 0 || k > n)
+		throw exception("k_means: number of clusters has to be in [1, num of examples]");
+
+	labels.assign(n, 0);
+	dist.assign(n, 0);
+	niter = 0;
+	evaluations.clear();
+
+	unsigned chunks = parallel_chunks(0, n, nthreads);
+	thread_sums.assign(chunks, Matrix<double>(k, dim, 0.0));
+	thread_counts.assign(chunks, vector<unsigned>(k, 0));
+	thread_evals.assign(chunks, 0);
+
+	// Absolute tolerance is relative to the spread of data
+	vector<double> sum(dim, 0.0), sum_sq(dim, 0.0);
+	for (const auto & row : x)
+		for (unsigned c = 0; c < dim; ++c)
+			sum[c] += row[c], sum_sq[c] += static_cast<double>(row[c]) * row[c];
+
+	double mean_variance = 0;
+	for (unsigned c = 0; c < dim; ++c)
+		mean_variance += sum_sq[c] / n - (sum[c] / n) * (sum[c] / n);
+	mean_variance /= dim ? dim : 1;
+
+	seed(x);
+
+	if (batch_size)
+		mini_batch(x, tolerance * mean_variance);
+	else
+		full_batch(x, tolerance * mean_variance);
+
+	inertia = 0;
+	for (unsigned i = 0; i < n; ++i)
+		inertia += dist[i];
+
+	return centers;
+}
+
+template <class T>
+unsigned KMeans<T>::predict(const vector<T> & x) const
+{
+	if (x.size() != centers.ncol())
+		throw exception("k_means: inconsistent num of columns");
+
+	T dist;
+	return nearest(x, centers, dist);
+}
 
-		/******************************************
-		* Create clusters for fixed centers
-		*******************************************/
-		for (unsigned n = 0; n < x.row; ++n)
+template <class T>
+void KMeans<T>::seed(const Matrix<T> & x)
+{
+	/*****************************************************
+	* k-means++: each next center is sampled with
+	* probability proportional to squared distance
+	* to the nearest center chosen so far
+	******************************************************/
+
+	unsigned n = x.nrow();
+	centers = Matrix<T>(k, 0);
+
+	centers[0] = x[uniform_int_distribution<unsigned>(0, n - 1)(rng)];
+
+	parallel_for(0, n, nthreads, [&](unsigned, unsigned begin, unsigned end)
+	{
+		for (unsigned i = begin; i < end; ++i)
+			dist[i] = squared_distance(x[i], centers[0]);
+	});
+
+	for (unsigned c = 1; c < k; ++c)
+	{
+		double total = 0;
+		for (unsigned i = 0; i < n; ++i)
+			total += dist[i];
+
+		unsigned chosen = n - 1;
+		if (total > 0)
 		{
-			unsigned nearest = mu.size();
-			T min_dist = numeric_limits<T>::max();
-			for (unsigned c = 0; c < mu.size(); ++c)
+			double r = uniform_real_distribution<double>(0, total)(rng);
+			for (unsigned i = 0; i < n; ++i)
 			{
-				T curr_dist = euclidian_dist(x[n], mu[c]);
-				if (curr_dist < min_dist)
+				r -= dist[i];
+				if (r < 0)
 				{
-					min_dist = curr_dist;
-					nearest = c;
+					chosen = i;
+					break;
 				}
 			}
-			clusters[nearest].push_back(n);
 		}
+		else
+			// All examples coincide with chosen centers
+			chosen = uniform_int_distribution<unsigned>(0, n - 1)(rng);
+
+		centers[c] = x[chosen];
+
+		const auto & center = centers[c];
+		parallel_for(0, n, nthreads, [&](unsigned, unsigned begin, unsigned end)
+		{
+			for (unsigned i = begin; i < end; ++i)
+				dist[i] = min(dist[i], squared_distance(x[i], center));
+		});
+	}
+}
+
+template <class T>
+unsigned long long KMeans<T>::total_evaluations() const
+{
+	unsigned long long total = 0;
+	for (auto evals : thread_evals)
+		total += evals;
+
+	return total;
+}
+
+template <class T>
+unsigned long long KMeans<T>::assign(const Matrix<T> & x)
+{
+	parallel_for(0, x.nrow(), nthreads, [&](unsigned, unsigned begin, unsigned end)
+	{
+		for (unsigned i = begin; i < end; ++i)
+			labels[i] = nearest(x[i], centers, dist[i]);
+	});
+
+	return static_cast<unsigned long long>(x.nrow()) * k;
+}
+
+template <class T>
+unsigned long long KMeans<T>::init_bounds(const Matrix<T> & x)
+{
+	unsigned n = x.nrow();
+
+	upper.assign(n, 0);
+	if (algorithm == ELKAN)
+		lower_bounds = Matrix<T>(n, k, 0);
+	else
+		lower.assign(n, 0);
 
-		/*******************************************
-		* Update centers for fixed clusters 
-		********************************************/
-		for (unsigned c = 0; c < clusters.size(); ++c)
+	parallel_for(0, n, nthreads, [&](unsigned, unsigned begin, unsigned end)
+	{
+		for (unsigned i = begin; i < end; ++i)
 		{
-			const Cluster & cluster = clusters[c];
+			// The nearest and the second nearest center
+			T d1 = numeric_limits<T>::max(), d2 = numeric_limits<T>::max();
+			unsigned a = 0;
 
-			if (cluster.empty())
+			for (unsigned c = 0; c < k; ++c)
 			{
-				//cerr << "k_means_clustering: cluster is empty" << endl;
-				return Matrix<T>();
+				T d = sqrt(squared_distance(x[i], centers[c]));
+				if (algorithm == ELKAN)
+					lower_bounds[i][c] = d;
+
+				if (d < d1)
+					d2 = d1, d1 = d, a = c;
+				else if (d < d2)
+					d2 = d;
 			}
 
-			vector<T> & mu_c = mu_next[c]; 
-			
-			for (vector<unsigned>::const_iterator itC = cluster.begin(), itCEnd = cluster.end(); 
-				itC != itCEnd; ++itC)
+			labels[i] = a;
+			upper[i] = d1;
+			if (algorithm != ELKAN)
+				lower[i] = d2;
+			dist[i] = d1 * d1;
+		}
+	});
+
+	return static_cast<unsigned long long>(n) * k;
+}
+
+template <class T>
+unsigned long long KMeans<T>::center_distances()
+{
+	if (center_dist.nrow() != k)
+		center_dist = Matrix<T>(k, k, 0);
+
+	// Each chunk fills its rows of upper triangle
+	parallel_for(0, k, nthreads, [&](unsigned, unsigned begin, unsigned end)
+	{
+		for (unsigned c1 = begin; c1 < end; ++c1)
+			for (unsigned c2 = c1 + 1; c2 < k; ++c2)
+				center_dist[c1][c2] = sqrt(squared_distance(centers[c1], centers[c2]));
+	});
+
+	half_min.assign(k, numeric_limits<T>::max());
+	for (unsigned c1 = 0; c1 < k; ++c1)
+		for (unsigned c2 = c1 + 1; c2 < k; ++c2)
+		{
+			T d = center_dist[c2][c1] = center_dist[c1][c2];
+			half_min[c1] = min(half_min[c1], d / 2);
+			half_min[c2] = min(half_min[c2], d / 2);
+		}
+
+	return static_cast<unsigned long long>(k) * (k - 1) / 2;
+}
+
+template <class T>
+unsigned long long KMeans<T>::assign_hamerly(const Matrix<T> & x)
+{
+	unsigned long long evals = center_distances();
+
+	parallel_for(0, x.nrow(), nthreads, [&](unsigned chunk, unsigned begin, unsigned end)
+	{
+		unsigned long long & local_evals = thread_evals[chunk];
+		local_evals = 0;
+
+		for (unsigned i = begin; i < end; ++i)
+		{
+			const unsigned old = labels[i];
+			T bound = max(half_min[old], lower[i]);
+
+			if (upper[i] > bound)
 			{
-				const vector<T> & example = x[*itC];
-				vector<T>::iterator itMu = mu_c.begin(); 
-				for (vector<T>::const_iterator itEx = example.begin(), 
-					itExEnd = example.end(); itEx != itExEnd; ++itEx, ++itMu)
-					*itMu += *itEx;
+				// Tighten upper bound
+				upper[i] = sqrt(squared_distance(x[i], centers[old]));
+				++local_evals;
+
+				if (upper[i] > bound)
+				{
+					// Distance to the old center is already known
+					unsigned best = old;
+					T d1 = numeric_limits<T>::max(), d2 = numeric_limits<T>::max();
+					for (unsigned c = 0; c < k; ++c)
+					{
+						T d = c == old ? upper[i] : sqrt(squared_distance(x[i], centers[c]));
+						if (d < d1)
+							d2 = d1, d1 = d, best = c;
+						else if (d < d2)
+							d2 = d;
+					}
+					local_evals += k - 1;
+
+					labels[i] = best;
+					upper[i] = d1;
+					lower[i] = d2;
+				}
 			}
 
-			// Average each feature
-			for (vector<T>::iterator itMu = mu_c.begin(), itMuEnd = mu_c.end(); itMu != itMuEnd; ++itMu)
-				*itMu /= cluster.size();
+			dist[i] = upper[i] * upper[i];
 		}
+	});
 
-		swap(mu, mu_next);
+	return evals + total_evaluations();
+}
 
-		if (mu == mu_next)
+template <class T>
+unsigned long long KMeans<T>::assign_elkan(const Matrix<T> & x)
+{
+	unsigned long long evals = center_distances();
+
+	parallel_for(0, x.nrow(), nthreads, [&](unsigned chunk, unsigned begin, unsigned end)
+	{
+		unsigned long long & local_evals = thread_evals[chunk];
+		local_evals = 0;
+
+		for (unsigned i = begin; i < end; ++i)
+		{
+			unsigned a = labels[i];
+			T u = upper[i];
+			auto & l = lower_bounds[i];
+
+			if (u > half_min[a])
+			{
+				bool tight = false;
+				for (unsigned c = 0; c < k; ++c)
+				{
+					if (c == a || u <= l[c] || u <= center_dist[a][c] / 2)
+						continue;
+
+					if (!tight)
+					{
+						u = l[a] = sqrt(squared_distance(x[i], centers[a]));
+						++local_evals;
+						tight = true;
+
+						if (u <= l[c] || u <= center_dist[a][c] / 2)
+							continue;
+					}
+
+					T d = l[c] = sqrt(squared_distance(x[i], centers[c]));
+					++local_evals;
+
+					if (d < u)
+						a = c, u = d;
+				}
+			}
+
+			labels[i] = a;
+			upper[i] = u;
+			dist[i] = u * u;
+		}
+	});
+
+	return evals + total_evaluations();
+}
+
+template <class T>
+void KMeans<T>::accumulate(const Matrix<T> & x, Matrix<double> & sums, vector<unsigned> & counts)
+{
+	unsigned dim = x.ncol();
+
+	parallel_for(0, x.nrow(), nthreads, [&](unsigned chunk, unsigned begin, unsigned end)
+	{
+		Matrix<double> & local_sums = thread_sums[chunk];
+		vector<unsigned> & local_counts = thread_counts[chunk];
+
+		for (auto & row : local_sums)
+			fill(row.begin(), row.end(), 0.0);
+		fill(local_counts.begin(), local_counts.end(), 0);
+
+		for (unsigned i = begin; i < end; ++i)
+		{
+			auto & sum = local_sums[labels[i]];
+			const auto & row = x[i];
+			for (unsigned d = 0; d < dim; ++d)
+				sum[d] += row[d];
+			++local_counts[labels[i]];
+		}
+	});
+
+	// Merge per-thread accumulators (in order of chunks, so result does not depend on timing)
+	sums = thread_sums[0];
+	counts = thread_counts[0];
+
+	for (unsigned chunk = 1; chunk < parallel_chunks(0, x.nrow(), nthreads); ++chunk)
+		for (unsigned c = 0; c < k; ++c)
+		{
+			auto & sum = sums[c];
+			const auto & local_sum = thread_sums[chunk][c];
+			for (unsigned d = 0; d < dim; ++d)
+				sum[d] += local_sum[d];
+			counts[c] += thread_counts[chunk][c];
+		}
+}
+
+template <class T>
+void KMeans<T>::repair_empty(const Matrix<T> & x, vector<unsigned> & counts, Matrix<double> * sums)
+{
+	repaired.clear();
+
+	for (unsigned c = 0; c < k; ++c)
+	{
+		if (counts[c])
+			continue;
+
+		// The farthest example among clusters which can spare one
+		unsigned farthest = x.nrow();
+		for (unsigned i = 0; i < x.nrow(); ++i)
+			if (counts[labels[i]] > 1 && (farthest == x.nrow() || dist[i] > dist[farthest]))
+				farthest = i;
+
+		if (farthest == x.nrow())
+			throw exception("k_means: cannot create k non-empty clusters");
+
+		const auto & row = x[farthest];
+		unsigned old = labels[farthest];
+
+		if (sums)
+		{
+			auto & old_sum = (*sums)[old];
+			auto & new_sum = (*sums)[c];
+			for (unsigned d = 0; d < row.size(); ++d)
+				old_sum[d] -= row[d], new_sum[d] = row[d];
+		}
+		else
+			centers[c] = row;
+
+		--counts[old];
+		counts[c] = 1;
+		labels[farthest] = c;
+		dist[farthest] = 0;
+		repaired.push_back(farthest);
+	}
+}
+
+template <class T>
+double KMeans<T>::update_centers(const Matrix<double> & sums, const vector<unsigned> & counts)
+{
+	movement.assign(k, 0);
+
+	double shift = 0;
+	for (unsigned c = 0; c < k; ++c)
+	{
+		auto & center = centers[c];
+		const auto & sum = sums[c];
+
+		double center_shift = 0;
+		for (unsigned d = 0; d < center.size(); ++d)
+		{
+			T updated = static_cast<T>(sum[d] / counts[c]);
+			center_shift += static_cast<double>(updated - center[d]) * (updated - center[d]);
+			center[d] = updated;
+		}
+
+		movement[c] = static_cast<T>(sqrt(center_shift));
+		shift += center_shift;
+	}
+
+	return shift;
+}
+
+template <class T>
+void KMeans<T>::update_bounds()
+{
+	// Examples moved by repair_empty() lost valid bounds
+	for (auto i : repaired)
+	{
+		upper[i] = numeric_limits<T>::infinity();
+		if (algorithm == ELKAN)
+			fill(lower_bounds[i].begin(), lower_bounds[i].end(), T(0));
+		else
+			lower[i] = 0;
+	}
+
+	// Two largest movements (Hamerly)
+	unsigned max_c = 0;
+	T max1 = 0, max2 = 0;
+	for (unsigned c = 0; c < k; ++c)
+		if (movement[c] > max1)
+			max2 = max1, max1 = movement[c], max_c = c;
+		else if (movement[c] > max2)
+			max2 = movement[c];
+
+	parallel_for(0, labels.size(), nthreads, [&](unsigned, unsigned begin, unsigned end)
+	{
+		for (unsigned i = begin; i < end; ++i)
+		{
+			unsigned a = labels[i];
+			upper[i] += movement[a];
+
+			if (algorithm == ELKAN)
+			{
+				auto & l = lower_bounds[i];
+				for (unsigned c = 0; c < k; ++c)
+					l[c] = max(l[c] - movement[c], T(0));
+			}
+			else
+				lower[i] = max(lower[i] - (a == max_c ? max2 : max1), T(0));
+		}
+	});
+}
+
+template <class T>
+void KMeans<T>::full_batch(const Matrix<T> & x, double tol)
+{
+	Matrix<double> sums;
+	vector<unsigned> counts;
+	bool bounds = false;
+
+	while (niter < max_iter)
+	{
+		if (algorithm == LLOYD)
+			evaluations.push_back(assign(x));
+		else if (!bounds)
+			evaluations.push_back(init_bounds(x)), bounds = true;
+		else
+			evaluations.push_back(algorithm == ELKAN ? assign_elkan(x) : assign_hamerly(x));
+
+		accumulate(x, sums, counts);
+		repair_empty(x, counts, &sums);
+
+		double shift = update_centers(sums, counts);
+		++niter;
+
+		if (bounds)
+			update_bounds();
+
+		if (shift <= tol)
 			break;
+	}
+
+	// Labels and distances for final centers
+	if (algorithm == LLOYD)
+		evaluations.push_back(assign(x));
+	else
+	{
+		unsigned long long evals = !bounds ? init_bounds(x) :
+			algorithm == ELKAN ? assign_elkan(x) : assign_hamerly(x);
+
+		// Bounds are not exact distances
+		parallel_for(0, x.nrow(), nthreads, [&](unsigned, unsigned begin, unsigned end)
+		{
+			for (unsigned i = begin; i < end; ++i)
+				dist[i] = squared_distance(x[i], centers[labels[i]]);
+		});
+
+		evaluations.push_back(evals + x.nrow());
+	}
+}
+
+template <class T>
+void KMeans<T>::mini_batch(const Matrix<T> & x, double tol)
+{
+	/*****************************************************
+	* Mini-batch k-means (Sculley, 2010): each center moves
+	* towards assigned examples with learning rate
+	* 1 / (num of examples assigned to it so far)
+	******************************************************/
+
+	unsigned n = x.nrow();
+	unsigned dim = x.ncol();
+	unsigned size = min(batch_size, n);
+
+	vector<unsigned> batch(size), nearest_center(size);
+	vector<double> seen(k, 0);
+	Matrix<T> previous(k, dim);
+	uniform_int_distribution<unsigned> random_example(0, n - 1);
+
+	while (niter < max_iter)
+	{
+		for (auto & i : batch)
+			i = random_example(rng);
+
+		parallel_for(0, size, nthreads, [&](unsigned, unsigned begin, unsigned end)
+		{
+			T dist;
+			for (unsigned b = begin; b < end; ++b)
+				nearest_center[b] = nearest(x[batch[b]], centers, dist);
+		});
+
+		evaluations.push_back(static_cast<unsigned long long>(size) * k);
+
+		for (unsigned c = 0; c < k; ++c)
+			copy(centers[c].begin(), centers[c].end(), previous[c].begin());
+
+		for (unsigned b = 0; b < size; ++b)
+		{
+			unsigned c = nearest_center[b];
+			T eta = static_cast<T>(1.0 / ++seen[c]);
 
-		++count;
+			auto & center = centers[c];
+			const auto & row = x[batch[b]];
+			for (unsigned d = 0; d < dim; ++d)
+				center[d] += eta * (row[d] - center[d]);
+		}
+
+		++niter;
+
+		double shift = 0;
+		for (unsigned c = 0; c < k; ++c)
+			shift += squared_distance(centers[c], previous[c]);
+
+		if (shift <= tol)
+			break;
 	}
 
-	//cerr << "Lloyd's done, count=" << count << endl;
-	return mu;
+	// Labels for all examples, centers which never attracted examples are repaired
+	vector<unsigned> counts(k, 0);
+	evaluations.push_back(assign(x));
+	for (unsigned i = 0; i < n; ++i)
+		++counts[labels[i]];
+
+	repair_empty(x, counts, NULL);
+}
+
+/************************************************************
+* Returns matrix of k cluster centers
+* (k-means++ seeding followed by Lloyd's algorithm,
+* single-threaded)
+************************************************************/
+template <class T>
+Matrix<T> k_means_clusterung(const Matrix<T> & x, unsigned k)
+{
+	KMeans<T> k_means(k);
+	return k_means.fit(x);
 }
 
-#endif
\ No newline at end of file
+#endif
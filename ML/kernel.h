@@ -0,0 +1,537 @@
+/*                                                                 -*- C++ -*-
+ * File: kernel.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Kernels and batched kernel evaluations: Gram (kernel) matrix
+ *   in packed form, LRU cache of kernel rows, RBF feature map
+ *
+ */
+
+#ifndef _KERNEL_H
+#define _KERNEL_H
+
+#include <algorithm>
+#include <list>
+#include <cstddef>
+
+#include "LA/matrix.h"
+#include "LA/linear_algebra.h"
+#include "LA/fast_math.h"
+#include "LA/parallel.h"
+
+using namespace std;
+
+/************************************************************
+* Kernel function: linear, polynomial, RBF or any other
+* function of two examples (evaluated pair by pair).
+* First three are functions of inner product (and norms),
+* so they are evaluated in batches by KernelEvaluator
+************************************************************/
+template <class T>
+class Kernel
+{
+public:
+
+	enum Type { LINEAR, POLYNOMIAL, RBF, CUSTOM };
+
+	typedef T (*Function)(const vector<T> &, const vector<T> &);
+
+	// x * y
+	static Kernel linear() { return Kernel(LINEAR, 1, 1, 0, nullptr); }
+
+	// (gamma * x * y + coef0)^degree
+	static Kernel polynomial(unsigned degree, T gamma = 1, T coef0 = 1) { return Kernel(POLYNOMIAL, degree, gamma, coef0, nullptr); }
+
+	// exp(-gamma * |x - y|^2)
+	static Kernel rbf(T gamma) { return Kernel(RBF, 0, gamma, 0, nullptr); }
+
+	// f(x, y)
+	static Kernel custom(Function f);
+
+	Kernel() : t(LINEAR), degree(1), gamma(1), coef0(0), f(nullptr) {}
+
+	Type type() const { return t; }
+
+	T operator () (const vector<T> & x, const vector<T> & y) const;
+
+	/**
+	 Turns inner products v[j] = x * y_j, j < n, into kernel values.
+	 x_norm = |x|^2 and y_norm[j] = |y_j|^2 are used by RBF only.
+	 Not applicable to CUSTOM kernel
+	 */
+	void finish(T * v, unsigned n, T x_norm, const T * y_norm) const;
+
+private:
+
+	Kernel(Type t, unsigned degree, T gamma, T coef0, Function f) :
+		t(t), degree(degree), gamma(gamma), coef0(coef0), f(f) {}
+
+	Type t;
+	unsigned degree;
+	T gamma;
+	T coef0;
+	Function f;
+};
+
+template <class T>
+Kernel<T> Kernel<T>::custom(Function f)
+{
+	if (!f)
+		throw exception("Kernel: function is not set");
+
+	return Kernel(CUSTOM, 0, 0, 0, f);
+}
+
+template <class T>
+T Kernel<T>::operator () (const vector<T> & x, const vector<T> & y) const
+{
+	if (t == CUSTOM)
+		return f(x, y);
+
+	T v = inner_product(x, y);
+	T x_norm = t == RBF ? inner_product(x, x) : 0;
+	T y_norm = t == RBF ? inner_product(y, y) : 0;
+	finish(&v, 1, x_norm, &y_norm);
+
+	return v;
+}
+
+template <class T>
+void Kernel<T>::finish(T * v, unsigned n, T x_norm, const T * y_norm) const
+{
+	switch (t)
+	{
+	case LINEAR:
+		break;
+
+	case POLYNOMIAL:
+		for (unsigned j = 0; j < n; ++j)
+		{
+			T base = gamma * v[j] + coef0;
+			T p = 1;
+			for (unsigned d = 0; d < degree; ++d)
+				p *= base;
+			v[j] = p;
+		}
+		break;
+
+	case RBF:
+		for (unsigned j = 0; j < n; ++j)
+		{
+			// Expansion may give slightly negative distance for close points
+			T dist = x_norm + y_norm[j] - 2 * v[j];
+			v[j] = (-1) * gamma * (dist > 0 ? dist : 0);
+		}
+		exp_inplace(v, n);
+		break;
+
+	default:
+		throw exception("Kernel: batch evaluation of custom kernel");
+	}
+}
+
+/************************************************************
+* Batched evaluation of kernel against fixed examples y_j.
+* Inner products x * y^t are computed for blocks of rows
+* (zero features of x are skipped, block of y^t is reused
+* by all rows of the block while in cache), then turned
+* into kernel values by whole rows
+************************************************************/
+template <class T>
+class KernelEvaluator
+{
+public:
+
+	KernelEvaluator() : dim(0), n(0) {}
+
+	KernelEvaluator(const Kernel<T> & kernel, const Matrix<T> & y);
+
+	// Number of examples y_j
+	unsigned size() const { return n; }
+
+	const Kernel<T> & get_kernel() const { return kernel; }
+
+	/**
+	 K(x_r, y_j) for r in [rb, re), j in [jb, je) is written to out_row(r)[j].
+	 If upper is set, only j >= r are computed (x and y are the same examples,
+	 upper triangle of kernel matrix). Other elements are not changed
+	 */
+	template <class RowOut>
+	void evaluate(const Matrix<T> & x, unsigned rb, unsigned re, unsigned jb, unsigned je, bool upper, RowOut out_row) const;
+
+private:
+
+	// Columns (examples y_j) processed together
+	enum { BLOCK_COLS = 256 };
+
+	Kernel<T> kernel;
+	unsigned dim;
+	unsigned n;
+	Matrix<T> y;      // CUSTOM kernel only
+	Matrix<T> y_t;    // dim * n
+	vector<T> y_norm; // |y_j|^2, RBF only
+};
+
+template <class T>
+KernelEvaluator<T>::KernelEvaluator(const Kernel<T> & kernel, const Matrix<T> & y) :
+	kernel(kernel), dim(y.ncol()), n(y.nrow())
+{
+	if (kernel.type() == Kernel<T>::CUSTOM)
+	{
+		this->y = y;
+		return;
+	}
+
+	y_t = transpose(y);
+
+	if (kernel.type() == Kernel<T>::RBF)
+	{
+		y_norm.resize(n);
+		for (unsigned j = 0; j < n; ++j)
+			y_norm[j] = inner_product(y[j], y[j]);
+	}
+}
+
+template <class T>
+template <class RowOut>
+void KernelEvaluator<T>::evaluate(const Matrix<T> & x, unsigned rb, unsigned re, unsigned jb, unsigned je, bool upper, RowOut out_row) const
+{
+	if (x.ncol() != dim)
+		throw exception("KernelEvaluator: inconsistent num of columns");
+
+	if (je > n)
+		throw exception("KernelEvaluator: column range is out of bounds");
+
+	if (kernel.type() == Kernel<T>::CUSTOM)
+	{
+		for (unsigned r = rb; r < re; ++r)
+		{
+			T * out = out_row(r);
+			for (unsigned j = upper ? max(jb, r) : jb; j < je; ++j)
+				out[j] = kernel(x[r], y[j]);
+		}
+		return;
+	}
+
+	for (unsigned r = rb; r < re; ++r)
+	{
+		unsigned j0 = upper ? max(jb, r) : jb;
+		if (j0 < je)
+		{
+			T * out = out_row(r);
+			fill(out + j0, out + je, T(0));
+		}
+	}
+
+	// Products x * y^t
+	for (unsigned cb = jb; cb < je; cb += BLOCK_COLS)
+	{
+		unsigned ce = min(cb + BLOCK_COLS, je);
+
+		for (unsigned r = rb; r < re; ++r)
+		{
+			unsigned j0 = upper ? max(cb, r) : cb;
+			if (j0 >= ce)
+				continue;
+
+			const auto & xr = x[r];
+			T * out = out_row(r);
+
+			for (unsigned d = 0; d < dim; ++d)
+			{
+				T xd = xr[d];
+				if (xd == 0)
+					continue;
+
+				const T * yd = &y_t[d][0];
+				for (unsigned j = j0; j < ce; ++j)
+					out[j] += xd * yd[j];
+			}
+		}
+	}
+
+	for (unsigned r = rb; r < re; ++r)
+	{
+		unsigned j0 = upper ? max(jb, r) : jb;
+		if (j0 >= je)
+			continue;
+
+		T x_norm = 0;
+		if (kernel.type() == Kernel<T>::RBF)
+		{
+			const auto & xr = x[r];
+			for (unsigned d = 0; d < dim; ++d)
+				x_norm += xr[d] * xr[d];
+		}
+
+		kernel.finish(out_row(r) + j0, je - j0, x_norm, y_norm.empty() ? nullptr : &y_norm[j0]);
+	}
+}
+
+/************************************************************
+* Kernel (Gram) matrix K[i][j] = K(x_i, x_j).
+* Only upper triangle is computed and stored, packed by rows
+* (n * (n + 1) / 2 elements). Tiles of the triangle are
+* computed in parallel
+************************************************************/
+template <class T>
+class KernelMatrix
+{
+public:
+
+	KernelMatrix() : n(0) {}
+
+	// nthreads == 0 for all hardware threads
+	KernelMatrix(const Matrix<T> & x, const Kernel<T> & kernel, unsigned nthreads = 0);
+
+	unsigned size() const { return n; }
+
+	T operator () (unsigned i, unsigned j) const { return i <= j ? packed[offset(i) + j] : packed[offset(j) + i]; }
+
+	// Row i of (symmetric) matrix, n values are written to out
+	void row(unsigned i, T * out) const;
+
+	// Row i, elements j >= i: upper(i)[j]
+	const T * upper(unsigned i) const { return packed.data() + offset(i); }
+
+private:
+
+	// Tile of rows * columns computed at once
+	enum { TILE_ROWS = 64, TILE_COLS = 256 };
+
+	// Row i of upper triangle starts at offset(i) + i
+	size_t offset(unsigned i) const { return static_cast<size_t>(i) * n - static_cast<size_t>(i) * (i + 1) / 2; }
+
+	unsigned n;
+	vector<T> packed;
+};
+
+template <class T>
+KernelMatrix<T>::KernelMatrix(const Matrix<T> & x, const Kernel<T> & kernel, unsigned nthreads) :
+	n(x.nrow()), packed(static_cast<size_t>(x.nrow()) * (x.nrow() + 1) / 2)
+{
+	KernelEvaluator<T> evaluator(kernel, x);
+
+	// Tiles intersecting upper triangle
+	vector<pair<unsigned, unsigned> > tiles;
+	for (unsigned rb = 0; rb < n; rb += TILE_ROWS)
+		for (unsigned cb = rb / TILE_COLS * TILE_COLS; cb < n; cb += TILE_COLS)
+			tiles.push_back(make_pair(rb, cb));
+
+	T * data = packed.data();
+	parallel_for(0, tiles.size(), nthreads, [&](unsigned, unsigned begin, unsigned end)
+	{
+		for (unsigned t = begin; t < end; ++t)
+		{
+			unsigned rb = tiles[t].first, cb = tiles[t].second;
+			evaluator.evaluate(x, rb, min(rb + TILE_ROWS, n), cb, min(cb + TILE_COLS, n), true,
+				[&](unsigned r) { return data + offset(r); });
+		}
+	});
+}
+
+template <class T>
+void KernelMatrix<T>::row(unsigned i, T * out) const
+{
+	for (unsigned j = 0; j < i; ++j)
+		out[j] = packed[offset(j) + i];
+
+	copy(packed.begin() + offset(i) + i, packed.begin() + offset(i) + n, out + i);
+}
+
+/************************************************************
+* Rows of kernel matrix computed on demand and kept in LRU
+* cache of limited size, for data sets whose kernel matrix
+* does not fit in memory.
+* x is not copied and has to outlive the cache
+************************************************************/
+template <class T>
+class KernelCache
+{
+public:
+
+	/**
+	 cache_size is in bytes, at least two rows are kept anyway.
+	 Each row is computed by nthreads threads (0 for all hardware threads)
+	 */
+	KernelCache(const Matrix<T> & x, const Kernel<T> & kernel, size_t cache_size, unsigned nthreads = 1);
+
+	unsigned size() const { return evaluator.size(); }
+
+	// Max number of rows kept
+	unsigned capacity() const { return max_rows; }
+
+	/**
+	 Row i: K(x_i, x_j), j < size().
+	 The pointer stays valid until a row is evicted: since at least two rows
+	 are kept, rows returned by the last two calls are always valid
+	 */
+	const T * row(unsigned i);
+
+	// K(x_i, x_i)
+	T diagonal(unsigned i) const { return diag[i]; }
+
+	unsigned long long hits() const { return nhits; }
+	unsigned long long misses() const { return nmisses; }
+
+private:
+
+	const Matrix<T> & x;
+	KernelEvaluator<T> evaluator;
+	unsigned nthreads;
+	unsigned max_rows;
+
+	vector<T> diag;
+	Matrix<T> rows;                      // rows[i] is empty if row i is not cached
+	list<unsigned> lru;                  // cached rows, most recently used first
+	vector<list<unsigned>::iterator> where;
+
+	unsigned long long nhits;
+	unsigned long long nmisses;
+};
+
+template <class T>
+KernelCache<T>::KernelCache(const Matrix<T> & x, const Kernel<T> & kernel, size_t cache_size, unsigned nthreads) :
+	x(x), evaluator(kernel, x), nthreads(nthreads), diag(x.nrow()), rows(x.nrow(), 0), where(x.nrow()), nhits(0), nmisses(0)
+{
+	unsigned n = x.nrow();
+	size_t row_size = max<size_t>(static_cast<size_t>(n) * sizeof(T), 1);
+	max_rows = static_cast<unsigned>(min<size_t>(max<size_t>(cache_size / row_size, 2), n));
+
+	for (unsigned i = 0; i < n; ++i)
+		diag[i] = kernel(x[i], x[i]);
+}
+
+template <class T>
+const T * KernelCache<T>::row(unsigned i)
+{
+	if (!rows[i].empty())
+	{
+		++nhits;
+		lru.splice(lru.begin(), lru, where[i]);
+		return rows[i].data();
+	}
+
+	++nmisses;
+
+	unsigned n = size();
+	if (lru.size() >= max_rows)
+	{
+		// Buffer of least recently used row is reused
+		unsigned victim = lru.back();
+		lru.pop_back();
+		rows[i].swap(rows[victim]);
+	}
+	else
+		rows[i].resize(n);
+
+	T * out = rows[i].data();
+	parallel_for(0, n, nthreads, [&](unsigned, unsigned begin, unsigned end)
+	{
+		evaluator.evaluate(x, i, i + 1, begin, end, false, [&](unsigned) { return out; });
+	});
+
+	lru.push_front(i);
+	where[i] = lru.begin();
+
+	return out;
+}
+
+/************************************************************
+* Gaussian (RBF) features of examples with respect to
+* fixed centers: phi[i][j] = exp(-gamma * |x_i - mu_j|^2),
+* evaluated in blocks of rows by KernelEvaluator
+************************************************************/
+template <class T>
+class RBFFeatureMap
+{
+public:
+
+	RBFFeatureMap() {}
+
+	RBFFeatureMap(const Matrix<T> & centers, T gamma) : centers(Kernel<T>::rbf(gamma), centers) {}
+
+	// Number of features (centers)
+	unsigned size() const { return centers.size(); }
+
+	/**
+	 Features of rows [begin, end) of x are written to rows [0, end - begin)
+	 of phi, columns [offset, offset + size()). Other columns are not changed.
+	 phi has to be large enough
+	 */
+	void transform(const Matrix<T> & x, unsigned begin, unsigned end, Matrix<T> & phi, unsigned offset = 0) const;
+
+	/**
+	 Returns features of all rows of x: matrix n * (offset + size()),
+	 first offset columns are 0. Blocks of rows are processed by nthreads threads
+	 (0 for all hardware threads)
+	 */
+	Matrix<T> transform(const Matrix<T> & x, unsigned offset = 0, unsigned nthreads = 1) const;
+
+	// Features of single example
+	vector<T> transform(const vector<T> & x) const;
+
+private:
+
+	// Rows of x processed together, centers are reused while in cache
+	enum { BLOCK_ROWS = 64 };
+
+	KernelEvaluator<T> centers;
+};
+
+template <class T>
+void RBFFeatureMap<T>::transform(const Matrix<T> & x, unsigned begin, unsigned end, Matrix<T> & phi, unsigned offset) const
+{
+	unsigned k = size();
+	if (k == 0)
+		return;
+
+	for (unsigned rb = begin; rb < end; rb += BLOCK_ROWS)
+		centers.evaluate(x, rb, min(rb + BLOCK_ROWS, end), 0, k, false,
+			[&](unsigned r) { return &phi[r - begin][offset]; });
+}
+
+template <class T>
+Matrix<T> RBFFeatureMap<T>::transform(const Matrix<T> & x, unsigned offset, unsigned nthreads) const
+{
+	unsigned n = x.nrow();
+	unsigned ncol = offset + size();
+	Matrix<T> phi(n, ncol, 0);
+
+	parallel_for(0, n, nthreads, [&](unsigned, unsigned begin, unsigned end)
+	{
+		// Rows are computed in place: rows of phi are swapped into the block and back
+		Matrix<T> block(BLOCK_ROWS, 0);
+
+		for (unsigned rb = begin; rb < end; rb += BLOCK_ROWS)
+		{
+			unsigned re = min(rb + BLOCK_ROWS, end);
+
+			for (unsigned r = rb; r < re; ++r)
+				block[r - rb].swap(phi[r]);
+
+			transform(x, rb, re, block, offset);
+
+			for (unsigned r = rb; r < re; ++r)
+				block[r - rb].swap(phi[r]);
+		}
+	});
+
+	return phi;
+}
+
+template <class T>
+vector<T> RBFFeatureMap<T>::transform(const vector<T> & x) const
+{
+	Matrix<T> m(1, 0), phi(1, size());
+	m[0] = x;
+	transform(m, 0, 1, phi);
+
+	return phi[0];
+}
+
+#endif
@@ -5,6 +5,7 @@
  * Created on: Mar 12, 2013
  *
  * Description: implemets SVM using MATLAB quadprog   
+ *              (SMO_SV::learn in smo_svm.h solves the same problem in process)
  */
 
 #ifndef _SVM_H
@@ -12,27 +13,15 @@
 
 #include "engine.h" // MATLAB engine
 #include "matrix.h"
+#include "smo_svm.h"
 
 namespace MATLAB_SV {
 
-template <class T>
-signed label(const T & r)
-{
-	return r > 0 ? 1 : -1;
-}
-
-template <class T> 
-T linear_kernel(const vector<T> & v1, const vector<T> & v2)
-{
-	return dot_product(v1, v2);
-}
-
-template <class T> 
-T second_order_polynomial_kernel(const vector<T> & v1, const vector<T> & v2)
-{
-	return pow(1 + dot_product(v1, v2), 2);
-}
-
+// Kernel functions are shared with the native solver
+using SMO_SV::label;
+using SMO_SV::linear_kernel;
+using SMO_SV::second_order_polynomial_kernel;
+using SMO_SV::to_kernel;
 
 /*******************************************************************************
 * Wrapper for MATLAB quadprog
@@ -51,7 +40,7 @@ unsigned learn(Engine * ep, const Matrix<T> & x_non_scaled,
 	* sanity check
 	***************************************************/
 
-	for (unsigned r = 0; r < x_non_scaled.row; ++r)
+	for (unsigned r = 0; r < x_non_scaled.nrow(); ++r)
 		if (x_non_scaled[r][0] != 1.0)
 			throw exception("Wrong format of input");
 	
@@ -59,30 +48,29 @@ unsigned learn(Engine * ep, const Matrix<T> & x_non_scaled,
 	* Remove x0 and scale
 	*******************************************************/
 
-	Matrix<T> x(x_non_scaled.row, x_non_scaled.col - 1);
-	for (unsigned r = 0; r < x_non_scaled.row; ++r)
-		for (unsigned c = 1; c < x_non_scaled.col; ++c)
+	Matrix<T> x(x_non_scaled.nrow(), x_non_scaled.ncol() - 1);
+	for (unsigned r = 0; r < x_non_scaled.nrow(); ++r)
+		for (unsigned c = 1; c < x_non_scaled.ncol(); ++c)
 			x[r][c - 1] = x_non_scaled[r][c];
 	
 	/***************************************************************************
-	* Create H (quadr matrix)
+	* Create H (quadr matrix): H[i][j] = y_i * y_j * K(x_i, x_j)
 	* The number of rows and columns in H must equal the number of elements of f
+	* Kernel matrix is computed for upper triangle only; H is symmetric, 
+	* so it is filled directly (column-major and row-major layouts coincide)
 	*****************************************************************************/
 
-	Matrix<T> quadr(x.row, x.row);
-	for (unsigned i = 0; i < x.row; ++i)
-		for (unsigned j = 0; j < x.row; ++ j)
-			quadr[i][j] = y[i][0] * y[j][0] * kernel(x[i], x[j]);
-
-	T * buff_H = (T*)malloc(sizeof(T) * quadr.row * quadr.col);
-	
-	for (unsigned r = 0; r < quadr.row; ++r)
-		for (unsigned c = 0; c < quadr.col; ++c)
-			buff_H[(r * quadr.col) + c] = quadr[r][c];
+	KernelMatrix<T> gram(x, to_kernel(kernel));
+	unsigned n = gram.size();
 
-	mxArray * h = mxCreateDoubleMatrix(quadr.row, quadr.col, mxREAL);
-	memcpy((void *)mxGetPr(h), (void *)buff_H,  quadr.row * quadr.col * sizeof(T));
-	delete buff_H;
+	mxArray * h = mxCreateDoubleMatrix(n, n, mxREAL);
+	double * buff_H = mxGetPr(h);
+	for (unsigned i = 0; i < n; ++i)
+	{
+		const T * k = gram.upper(i);
+		for (unsigned j = i; j < n; ++j)
+			buff_H[static_cast<size_t>(i) * n + j] = buff_H[static_cast<size_t>(j) * n + i] = y[i][0] * y[j][0] * k[j];
+	}
 
 	engPutVariable(ep, "H", h);
 
@@ -92,12 +80,12 @@ unsigned learn(Engine * ep, const Matrix<T> & x_non_scaled,
 	* Setting it to '-1'
 	* The number of rows and columns in H must equal the number of elements of f
 	************************************************************************************/
-	T * buff_f = (T*)malloc(sizeof(T) * quadr.row);
-	for (unsigned r = 0; r < quadr.row; ++r)
+	T * buff_f = (T*)malloc(sizeof(T) * n);
+	for (unsigned r = 0; r < n; ++r)
 		buff_f[r] = minus_one;
 	
-	mxArray * f = mxCreateDoubleMatrix(quadr.row, 1, mxREAL);
-	memcpy((void *)mxGetPr(f), (void *)buff_f, quadr.row * sizeof(T));
+	mxArray * f = mxCreateDoubleMatrix(n, 1, mxREAL);
+	memcpy((void *)mxGetPr(f), (void *)buff_f, n * sizeof(T));
 	delete buff_f;
 
 	engPutVariable(ep, "f", f);
@@ -118,14 +106,14 @@ unsigned learn(Engine * ep, const Matrix<T> & x_non_scaled,
 	* Matrix of doubles. Represents the linear coefficients in the constraints Aeq*x = beq
 	* The number of rows and columns in Aeq must be the same as the number of elements of f
 	****************************************************************************************/
-	T * buff_aeq = (T*)malloc(sizeof(T) * quadr.row * quadr.col);
+	T * buff_aeq = (T*)malloc(sizeof(T) * n * n);
 
-	for (unsigned r = 0; r < quadr.row; ++r)
-		for (unsigned c = 0; c < quadr.col; ++c)
-			buff_aeq[(r * quadr.col) + c] = y[r][0];
+	for (unsigned r = 0; r < n; ++r)
+		for (unsigned c = 0; c < n; ++c)
+			buff_aeq[(r * n) + c] = y[r][0];
 
-	mxArray * aeq =  mxCreateDoubleMatrix(quadr.row, quadr.col, mxREAL);
-	memcpy((void *)mxGetPr(aeq), (void *)buff_aeq, quadr.row * quadr.col * sizeof(T));
+	mxArray * aeq =  mxCreateDoubleMatrix(n, n, mxREAL);
+	memcpy((void *)mxGetPr(aeq), (void *)buff_aeq, n * n * sizeof(T));
 	delete buff_aeq;
 
 	engPutVariable(ep, "Aeq", aeq);
@@ -135,13 +123,13 @@ unsigned learn(Engine * ep, const Matrix<T> & x_non_scaled,
 	* Vector of doubles. Represents the constant vector in the constraints Aeq*x = beq.
 	* The number of rows in Aeq must be the same as the number of elements of beq
 	************************************************************************************/
-	T * buff_beq = (T*)malloc(sizeof(T) * x.row);	
-	for (unsigned c = 0; c < quadr.row; ++c)
+	T * buff_beq = (T*)malloc(sizeof(T) * x.nrow());	
+	for (unsigned c = 0; c < n; ++c)
 		buff_beq[c] = 0.0;
 
-	mxArray * beq =  mxCreateDoubleMatrix(1, quadr.row, mxREAL);
+	mxArray * beq =  mxCreateDoubleMatrix(1, n, mxREAL);
 
-	memcpy((void *)mxGetPr(beq), (void *)buff_beq, quadr.row * sizeof(T));
+	memcpy((void *)mxGetPr(beq), (void *)buff_beq, n * sizeof(T));
 	delete buff_beq;
 
 	engPutVariable(ep, "beq", beq);
@@ -150,21 +138,21 @@ unsigned learn(Engine * ep, const Matrix<T> & x_non_scaled,
 	* Create lb and ub
 	* Vectors of doubles. Represent the lower and upper bounds elementwise in lb ≤ x ≤ ub.
 	***************************************************************************************/
-	T * buff_lb = (T*)malloc(sizeof(T) * quadr.col);
-	T * buff_ub = (T*)malloc(sizeof(T) * quadr.col);
+	T * buff_lb = (T*)malloc(sizeof(T) * n);
+	T * buff_ub = (T*)malloc(sizeof(T) * n);
 	
-	for (unsigned c = 0; c < quadr.col; ++c)
+	for (unsigned c = 0; c < n; ++c)
 	{
 		buff_lb[c] = 0.0;
 		buff_ub[c] = c_upper_bound;
 	}
 
-	mxArray * lb =  mxCreateDoubleMatrix(1, quadr.col, mxREAL);
-	memcpy((void *)mxGetPr(lb), (void *)buff_lb, quadr.col * sizeof(T));
+	mxArray * lb =  mxCreateDoubleMatrix(1, n, mxREAL);
+	memcpy((void *)mxGetPr(lb), (void *)buff_lb, n * sizeof(T));
 	delete buff_lb;
 	
-	mxArray * ub =  mxCreateDoubleMatrix(1, quadr.col, mxREAL);
-	memcpy((void *)mxGetPr(ub), (void *)buff_ub, quadr.col * sizeof(T));
+	mxArray * ub =  mxCreateDoubleMatrix(1, n, mxREAL);
+	memcpy((void *)mxGetPr(ub), (void *)buff_ub, n * sizeof(T));
 	delete buff_ub;
 
 	engPutVariable(ep, "lb", lb);
@@ -194,7 +182,7 @@ unsigned learn(Engine * ep, const Matrix<T> & x_non_scaled,
 	if (debug)
 		_getch();
 	 
-	vector<T> alpha(x.row, 0.0);
+	vector<T> alpha(x.nrow(), 0.0);
 	unsigned sv_count = 0;
 	if (debug)
 		printf("\nRetrieving results...\n");
@@ -211,10 +199,10 @@ unsigned learn(Engine * ep, const Matrix<T> & x_non_scaled,
 		/********************************************************************
 		* Recover alpha
 		*********************************************************************/
-		T * buff_res = (T*)malloc(sizeof(T) * x.row);	
-		memcpy((void *)buff_res, (void *)mxGetPr(result), x.row * sizeof(T));
+		T * buff_res = (T*)malloc(sizeof(T) * x.nrow());	
+		memcpy((void *)buff_res, (void *)mxGetPr(result), x.nrow() * sizeof(T));
 
-		for (unsigned i = 0; i < x.row; ++i)
+		for (unsigned i = 0; i < x.nrow(); ++i)
 		{
 			alpha[i] = buff_res[i];
 			if (alpha[i] > 0.00001) // workaround for numerical problem, should be alpha[r] != 0
@@ -252,10 +240,10 @@ unsigned learn(Engine * ep, const Matrix<T> & x_non_scaled,
 	/**********************************************
 	* Recover w 
 	***********************************************/
-	vector<T> w_sv(x.col, 0.0);
-	unsigned sv = x.row;
-	for (unsigned r = 0; r < x.row; ++r)
-		for (unsigned c = 0; c < x.col; ++c)
+	vector<T> w_sv(x.ncol(), 0.0);
+	unsigned sv = x.nrow();
+	for (unsigned r = 0; r < x.nrow(); ++r)
+		for (unsigned c = 0; c < x.ncol(); ++c)
 		{
 			if (alpha[r] > 0.00001) // workaround for numerical problem, should be alpha[r] != 0
 			{
@@ -269,7 +257,7 @@ unsigned learn(Engine * ep, const Matrix<T> & x_non_scaled,
 	***********************************************/
 	w[0] = y[sv][0] - kernel(w_sv, x[sv]);
 
-	for (unsigned c = 0; c < x.col; ++c)
+	for (unsigned c = 0; c < x.ncol(); ++c)
 		w[c + 1] = w_sv[c];
 
 	return sv_count;
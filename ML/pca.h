@@ -0,0 +1,189 @@
+/*                                                                 -*- C++ -*-
+ * File: pca.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Principal component analysis (dimensionality reduction stage
+ *   to be applied to feature matrices before KNN/RBF/SVM)
+ *
+ */
+
+#ifndef _PCA_H
+#define _PCA_H
+
+#include "LA/matrix.h"
+#include "LA/linear_algebra.h"
+
+using namespace std;
+
+template <class T>
+class PCA
+{
+public:
+
+	// Creates and configures transformer to keep k components
+	PCA(unsigned k) : k(k) {}
+
+	// Fits on dataset x (each row is an example).
+	// Uses eigendecomposition of covariance matrix
+	void fit(const Matrix<T> & x);
+
+	// Projects single example
+	vector<T> transform(const vector<T> & x) const;
+
+	// Projects data set (rows are processed in blocks). Returns matrix n*k
+	Matrix<T> transform(const Matrix<T> & x) const;
+
+	// Allows to use PCA as a transform of Matrix::get_transformed/transform_self
+	vector<T> operator () (const vector<T> & x) const { return transform(x); }
+
+	unsigned ncomponents() const { return components.nrow(); }
+
+	// Trained
+	const vector<T> & get_mean() const { return mean; }
+	const Matrix<T> & get_components() const { return components; }
+	const vector<T> & get_explained_variance() const { return variance; }
+
+private:
+
+	// Number of rows projected together (components are reused while in cache)
+	enum { BLOCK_SIZE = 64 };
+
+	// Parameters
+	unsigned k;
+
+	// Trained
+	vector<T> mean;
+	Matrix<T> components; // k*dim, each row is a principal axis
+	vector<T> variance;   // eigenvalues of covariance matrix
+};
+
+template <class T>
+void PCA<T>::fit(const Matrix<T> & x)
+{
+	unsigned n = x.nrow();
+	unsigned dim = x.ncol();
+
+	if (n == 0)
+		throw exception("PCA: empty data set");
+
+	if (k > dim)
+		throw exception("PCA: number of components is greater than dimension");
+
+	/*****************************************************
+	* Covariance via second moments: cov = E[xx^t] - mm^t
+	* Accumulating uncentered products allows skipping
+	* zero features (pixel data is mostly zeros).
+	* Accumulation is done in double, only upper triangle
+	******************************************************/
+
+	vector<double> sum(dim, 0.0);
+	Matrix<double> moments(dim, dim, 0.0);
+	vector<unsigned> nz;
+	nz.reserve(dim);
+
+	for (const auto & row : x)
+	{
+		nz.clear();
+		for (unsigned c = 0; c < dim; ++c)
+			if (row[c] != 0)
+				nz.push_back(c);
+
+		for (unsigned a = 0; a < nz.size(); ++a)
+		{
+			double va = row[nz[a]];
+			sum[nz[a]] += va;
+
+			auto & m_row = moments[nz[a]];
+			for (unsigned b = a; b < nz.size(); ++b)
+				m_row[nz[b]] += va * row[nz[b]];
+		}
+	}
+
+	mean.resize(dim);
+	for (unsigned c = 0; c < dim; ++c)
+		mean[c] = static_cast<T>(sum[c] / n);
+
+	Matrix<T> c(dim, dim);
+	for (unsigned i = 0; i < dim; ++i)
+		for (unsigned j = i; j < dim; ++j)
+			c[i][j] = c[j][i] = static_cast<T>(moments[i][j] / n - (sum[i] / n) * (sum[j] / n));
+
+	/*****************************************************
+	* Principal axes
+	******************************************************/
+
+	auto eigens = eigen_symmetric_top(c, k);
+
+	components = Matrix<T>(k, 0);
+	variance.resize(k);
+	for (unsigned i = 0; i < k; ++i)
+	{
+		variance[i] = eigens[i].first;
+		components[i].swap(eigens[i].second);
+	}
+}
+
+template <class T>
+vector<T> PCA<T>::transform(const vector<T> & x) const
+{
+	if (x.size() != mean.size())
+		throw exception("PCA: inconsistent num of columns");
+
+	vector<T> centered(x);
+	centered -= mean;
+
+	vector<T> projected(components.nrow());
+	for (unsigned i = 0; i < components.nrow(); ++i)
+		projected[i] = inner_product(components[i], centered);
+
+	return projected;
+}
+
+template <class T>
+Matrix<T> PCA<T>::transform(const Matrix<T> & x) const
+{
+	if (x.ncol() != mean.size())
+		throw exception("PCA: inconsistent num of columns");
+
+	unsigned dim = mean.size();
+	Matrix<T> projected(x.nrow(), components.nrow());
+
+	// Centered copy of the current block only
+	Matrix<T> block(BLOCK_SIZE, dim);
+
+	for (unsigned begin = 0; begin < x.nrow(); begin += BLOCK_SIZE)
+	{
+		unsigned end = min(begin + BLOCK_SIZE, x.nrow());
+
+		for (unsigned r = begin; r < end; ++r)
+		{
+			auto & centered = block[r - begin];
+			const auto & row = x[r];
+			for (unsigned c = 0; c < dim; ++c)
+				centered[c] = row[c] - mean[c];
+		}
+
+		for (unsigned i = 0; i < components.nrow(); ++i)
+		{
+			const auto & axis = components[i];
+			for (unsigned r = begin; r < end; ++r)
+			{
+				const auto & centered = block[r - begin];
+
+				T dot = 0;
+				for (unsigned c = 0; c < dim; ++c)
+					dot += axis[c] * centered[c];
+
+				projected[r][i] = dot;
+			}
+		}
+	}
+
+	return projected;
+}
+
+#endif
@@ -15,6 +15,7 @@
 
 #include "linear_solutions.h"
 #include "clustering.h"
+#include "kernel.h"
 #include "LA/matrix.h"
 
 using namespace std;
@@ -24,8 +25,9 @@ class RBF_Classifier
 {
 public:
 
-	// Creates and configures classifier
-	RBF_Classifier(T gamma, unsigned k) : gamma(gamma), k(k){}
+	// Creates and configures classifier.
+	// Features of data sets are computed by nthreads threads (0 for all hardware threads)
+	RBF_Classifier(T gamma, unsigned k, unsigned nthreads = 1) : gamma(gamma), k(k), nthreads(nthreads) {}
 	
 	// Trains using dataset x with labels y. 
 	void train(const Matrix<T> & x, const Matrix<T> & y);
@@ -41,26 +43,24 @@ private:
 	// Parameters
 	T gamma; 
 	unsigned k;
+	unsigned nthreads;
     
 	// Trained 
 	Matrix<T> w;
 	Matrix<T> mu;
+	RBFFeatureMap<T> features;
 };
 
 template <class T>
 void RBF_Classifier<T>::train(const Matrix<T> & x, const Matrix<T> & y)
 {
-	//Matrix<T> mu;
-	while (mu.empty())
-		mu = k_means_clusterung(x, k);
+	mu = k_means_clusterung(x, k);
+	features = RBFFeatureMap<T>(mu, gamma);
 
-	Matrix<T> phi(x.row, k + 1);
-	for (unsigned n = 0; n < phi.row; ++n)
-	{
-		phi[n][0] = 1.0; // adding for calculating bias (aka w[0])
-		for (unsigned k = 1; k < phi.col; ++k)
-			phi[n][k] = exp((-1) * gamma * square_dist(x[n], mu[k - 1])); 
-	}
+	// Column 0 is for calculating bias (aka w[0])
+	Matrix<T> phi = features.transform(x, 1, nthreads);
+	for (auto & row : phi)
+		row[0] = 1.0;
 
 	w = linear_pseudoinverse_solution(phi, y);
 }
@@ -68,9 +68,11 @@ void RBF_Classifier<T>::train(const Matrix<T> & x, const Matrix<T> & y)
 template <class T>
 T RBF_Classifier<T>::predict(const vector<T> & x) const
 {
+	vector<T> phi = features.transform(x);
+
 	T retval = w[0][0]; // bias
-	for (unsigned r = 0; r < mu.row; ++r)
-		retval += w[r + 1][0] * exp((-1) * gamma * square_dist(x, mu[r])); 
+	for (unsigned r = 0; r < phi.size(); ++r)
+		retval += w[r + 1][0] * phi[r];
 
 	return retval /= k;
 }
@@ -78,11 +80,32 @@ T RBF_Classifier<T>::predict(const vector<T> & x) const
 template <class T>
 Matrix<T> RBF_Classifier<T>::predict(const Matrix<T> & x) const
 {
-	Matrix<T> h;
+	const unsigned BLOCK_ROWS = 256;
+
+	Matrix<T> h(x.nrow(), 1);
+
+	// Features of a block of rows at a time, so memory does not grow with x
+	parallel_for(0, x.nrow(), nthreads, [&](unsigned, unsigned begin, unsigned end)
+	{
+		Matrix<T> phi(BLOCK_ROWS, mu.nrow());
+
+		for (unsigned rb = begin; rb < end; rb += BLOCK_ROWS)
+		{
+			unsigned re = min(rb + BLOCK_ROWS, end);
+			features.transform(x, rb, re, phi);
+
+			for (unsigned r = rb; r < re; ++r)
+			{
+				const auto & phi_r = phi[r - rb];
+
+				T retval = w[0][0]; // bias
+				for (unsigned j = 0; j < phi_r.size(); ++j)
+					retval += w[j + 1][0] * phi_r[j];
 
-	// predict each example
-	for (unsigned r = 0; r < x.row; ++r)
-		h.add_row(vector<T>(1, predict(x[r])));
+				h[r][0] = retval / k;
+			}
+		}
+	});
 	
 	return h;
 }
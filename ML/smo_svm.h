@@ -0,0 +1,581 @@
+/*                                                                 -*- C++ -*-
+ * File: smo_svm.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Kernel SVM (C-SVC) dual solved in process by SMO:
+ *   min 1/2 a^t Q a - e^t a,  y^t a = 0,  0 <= a_i <= C,
+ *   Q_ij = y_i y_j K(x_i, x_j).
+ *   Working set selection uses second order information (WSS2,
+ *   Fan, Chen, Lin 2005), bounded variables are shrunk, kernel
+ *   rows come from LRU cache
+ *
+ */
+
+#ifndef _SMO_SVM_H
+#define _SMO_SVM_H
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "matrix.h"
+#include "kernel.h"
+
+using namespace std;
+
+struct SMOParameters
+{
+	double tolerance;   // stop when max KKT violation (m(a) - M(a)) is below it
+	bool shrinking;     // remove bounded variables from active set
+	size_t cache_size;  // kernel row cache, bytes
+	unsigned max_iter;
+	unsigned nthreads;  // threads computing kernel rows, 0 for all hardware threads
+
+	SMOParameters() :
+		tolerance(1e-3), shrinking(true), cache_size(100 << 20), max_iter(10000000), nthreads(1) {}
+};
+
+/************************************************************
+* SMO solver of C-SVC dual.
+* Decision function is sum_i alpha_i y_i K(x_i, x) - rho
+************************************************************/
+template <class T>
+class SMOSolver
+{
+public:
+
+	SMOSolver(const SMOParameters & param = SMOParameters()) :
+		param(param), c(0), rho(0), objective(0), niter(0), hits(0), misses(0), cache(nullptr), unshrink(false) {}
+
+	// y_i is +1 or -1; c may be infinity (hard margin), then data has to be
+	// separable, otherwise dual is unbounded and solver stops at max_iter
+	void solve(const Matrix<T> & x, const vector<signed> & y, const Kernel<T> & kernel, double c);
+
+	const vector<double> & get_alpha() const { return alpha; }
+	double get_rho() const { return rho; }
+	double get_objective() const { return objective; }
+	unsigned get_niter() const { return niter; }
+
+	// Kernel rows served from cache / computed
+	unsigned long long get_cache_hits() const { return hits; }
+	unsigned long long get_cache_misses() const { return misses; }
+
+private:
+
+	enum { SHRINK_PERIOD = 1000 };
+
+	bool is_upper_bound(unsigned i) const { return alpha[i] >= c; }
+	bool is_lower_bound(unsigned i) const { return alpha[i] <= 0; }
+
+	// Returns false if optimal within tolerance
+	bool select_working_set(unsigned & out_i, unsigned & out_j);
+	void update(unsigned i, unsigned j);
+	void shrink();
+	bool be_shrunk(unsigned i, double gmax1, double gmax2) const;
+	void reconstruct_gradient();
+	void calculate_rho();
+
+	SMOParameters param;
+	double c;
+	double rho;
+	double objective;
+	unsigned niter;
+	unsigned long long hits;
+	unsigned long long misses;
+
+	KernelCache<T> * cache;
+	vector<double> y;
+	vector<double> qd;       // K(x_i, x_i)
+	vector<double> alpha;
+	vector<double> g;        // gradient Q a - e
+	vector<double> g_bar;    // C * sum of Q columns of variables at upper bound
+	vector<unsigned> active; // variables not shrunk
+	vector<char> is_active;
+	bool unshrink;
+};
+
+template <class T>
+void SMOSolver<T>::solve(const Matrix<T> & x, const vector<signed> & labels, const Kernel<T> & kernel, double c)
+{
+	unsigned n = x.nrow();
+
+	if (labels.size() != n)
+		throw exception("SMOSolver: inconsistent num of labels");
+
+	if (!(c > 0))
+		throw exception("SMOSolver: upper bound has to be positive");
+
+	this->c = c;
+	y.resize(n);
+	for (unsigned i = 0; i < n; ++i)
+	{
+		if (labels[i] != 1 && labels[i] != -1)
+			throw exception("SMOSolver: labels have to be +1 or -1");
+		y[i] = labels[i];
+	}
+
+	KernelCache<T> rows(x, kernel, param.cache_size, param.nthreads);
+	cache = &rows;
+
+	qd.resize(n);
+	for (unsigned i = 0; i < n; ++i)
+		qd[i] = rows.diagonal(i);
+
+	alpha.assign(n, 0);
+	g.assign(n, -1);
+	g_bar.assign(n, 0);
+	active.resize(n);
+	for (unsigned i = 0; i < n; ++i)
+		active[i] = i;
+	is_active.assign(n, 1);
+	unshrink = false;
+
+	niter = 0;
+	unsigned counter = min<unsigned>(n, SHRINK_PERIOD) + 1;
+
+	while (niter < param.max_iter)
+	{
+		if (param.shrinking && --counter == 0)
+		{
+			counter = min<unsigned>(n, SHRINK_PERIOD);
+			shrink();
+		}
+
+		unsigned i, j;
+		if (!select_working_set(i, j))
+		{
+			// Optimal on active set: check all variables
+			reconstruct_gradient();
+			if (!select_working_set(i, j))
+				break;
+			counter = 1;
+		}
+
+		++niter;
+		update(i, j);
+	}
+
+	reconstruct_gradient();
+	calculate_rho();
+
+	objective = 0;
+	for (unsigned i = 0; i < n; ++i)
+		objective += alpha[i] * (g[i] - 1);
+	objective /= 2;
+
+	hits = rows.hits();
+	misses = rows.misses();
+	cache = nullptr;
+}
+
+template <class T>
+bool SMOSolver<T>::select_working_set(unsigned & out_i, unsigned & out_j)
+{
+	const double tau = 1e-12;
+	const double inf = numeric_limits<double>::infinity();
+
+	// i maximizes -y_t g_t over I_up
+	double gmax = -inf;
+	int gmax_idx = -1;
+	for (unsigned t : active)
+	{
+		if (y[t] > 0)
+		{
+			if (!is_upper_bound(t) && -g[t] >= gmax)
+			{
+				gmax = -g[t];
+				gmax_idx = t;
+			}
+		}
+		else if (!is_lower_bound(t) && g[t] >= gmax)
+		{
+			gmax = g[t];
+			gmax_idx = t;
+		}
+	}
+
+	if (gmax_idx < 0)
+		return false;
+
+	unsigned i = gmax_idx;
+	const T * k_i = cache->row(i);
+
+	// j minimizes second order approximation of objective decrease over I_low
+	double gmax2 = -inf;
+	double obj_diff_min = inf;
+	int gmin_idx = -1;
+	for (unsigned t : active)
+	{
+		double grad_diff;
+		if (y[t] > 0)
+		{
+			if (is_lower_bound(t))
+				continue;
+			grad_diff = gmax + g[t];
+			gmax2 = max(gmax2, g[t]);
+		}
+		else
+		{
+			if (is_upper_bound(t))
+				continue;
+			grad_diff = gmax - g[t];
+			gmax2 = max(gmax2, -g[t]);
+		}
+
+		if (grad_diff > 0)
+		{
+			double quad_coef = qd[i] + qd[t] - 2 * k_i[t];
+			double obj_diff = -(grad_diff * grad_diff) / (quad_coef > 0 ? quad_coef : tau);
+			if (obj_diff <= obj_diff_min)
+			{
+				gmin_idx = t;
+				obj_diff_min = obj_diff;
+			}
+		}
+	}
+
+	if (gmax + gmax2 < param.tolerance || gmin_idx < 0)
+		return false;
+
+	out_i = i;
+	out_j = gmin_idx;
+
+	return true;
+}
+
+template <class T>
+void SMOSolver<T>::update(unsigned i, unsigned j)
+{
+	const double tau = 1e-12;
+
+	// Both rows stay in cache: at least two rows are kept
+	const T * k_i = cache->row(i);
+	const T * k_j = cache->row(j);
+
+	double old_alpha_i = alpha[i];
+	double old_alpha_j = alpha[j];
+
+	double quad_coef = qd[i] + qd[j] - 2 * k_i[j];
+	if (quad_coef <= 0)
+		quad_coef = tau;
+
+	// Two-variable subproblem, clipped to the box along y_i a_i + y_j a_j = const
+	if (y[i] != y[j])
+	{
+		double delta = (-g[i] - g[j]) / quad_coef;
+		double diff = alpha[i] - alpha[j];
+		alpha[i] += delta;
+		alpha[j] += delta;
+
+		if (diff > 0)
+		{
+			if (alpha[j] < 0)
+			{
+				alpha[j] = 0;
+				alpha[i] = diff;
+			}
+			if (alpha[i] > c)
+			{
+				alpha[i] = c;
+				alpha[j] = c - diff;
+			}
+		}
+		else
+		{
+			if (alpha[i] < 0)
+			{
+				alpha[i] = 0;
+				alpha[j] = -diff;
+			}
+			if (alpha[j] > c)
+			{
+				alpha[j] = c;
+				alpha[i] = c + diff;
+			}
+		}
+	}
+	else
+	{
+		double delta = (g[i] - g[j]) / quad_coef;
+		double sum = alpha[i] + alpha[j];
+		alpha[i] -= delta;
+		alpha[j] += delta;
+
+		if (sum > c)
+		{
+			if (alpha[i] > c)
+			{
+				alpha[i] = c;
+				alpha[j] = sum - c;
+			}
+			if (alpha[j] > c)
+			{
+				alpha[j] = c;
+				alpha[i] = sum - c;
+			}
+		}
+		else
+		{
+			if (alpha[j] < 0)
+			{
+				alpha[j] = 0;
+				alpha[i] = sum;
+			}
+			if (alpha[i] < 0)
+			{
+				alpha[i] = 0;
+				alpha[j] = sum;
+			}
+		}
+	}
+
+	// g_k += Q_ki * delta_i + Q_kj * delta_j
+	double d_i = y[i] * (alpha[i] - old_alpha_i);
+	double d_j = y[j] * (alpha[j] - old_alpha_j);
+	for (unsigned k : active)
+		g[k] += y[k] * (k_i[k] * d_i + k_j[k] * d_j);
+
+	// g_bar changes when a variable enters or leaves upper bound
+	unsigned n = alpha.size();
+	if ((old_alpha_i >= c) != is_upper_bound(i))
+	{
+		double s = is_upper_bound(i) ? c * y[i] : -c * y[i];
+		for (unsigned k = 0; k < n; ++k)
+			g_bar[k] += s * y[k] * k_i[k];
+	}
+
+	if ((old_alpha_j >= c) != is_upper_bound(j))
+	{
+		double s = is_upper_bound(j) ? c * y[j] : -c * y[j];
+		for (unsigned k = 0; k < n; ++k)
+			g_bar[k] += s * y[k] * k_j[k];
+	}
+}
+
+template <class T>
+bool SMOSolver<T>::be_shrunk(unsigned i, double gmax1, double gmax2) const
+{
+	if (is_upper_bound(i))
+		return y[i] > 0 ? -g[i] > gmax1 : -g[i] > gmax2;
+
+	if (is_lower_bound(i))
+		return y[i] > 0 ? g[i] > gmax2 : g[i] > gmax1;
+
+	return false;
+}
+
+template <class T>
+void SMOSolver<T>::shrink()
+{
+	const double inf = numeric_limits<double>::infinity();
+
+	// gmax1 = max over I_up of -y g, gmax2 = max over I_low of y g
+	double gmax1 = -inf, gmax2 = -inf;
+	for (unsigned i : active)
+	{
+		if (y[i] > 0)
+		{
+			if (!is_upper_bound(i))
+				gmax1 = max(gmax1, -g[i]);
+			if (!is_lower_bound(i))
+				gmax2 = max(gmax2, g[i]);
+		}
+		else
+		{
+			if (!is_upper_bound(i))
+				gmax2 = max(gmax2, -g[i]);
+			if (!is_lower_bound(i))
+				gmax1 = max(gmax1, g[i]);
+		}
+	}
+
+	// Close to optimum: bring all variables back once, shrinking was possibly too aggressive
+	if (!unshrink && gmax1 + gmax2 <= param.tolerance * 10)
+	{
+		unshrink = true;
+		reconstruct_gradient();
+	}
+
+	for (unsigned a = 0; a < active.size(); )
+	{
+		unsigned i = active[a];
+		if (be_shrunk(i, gmax1, gmax2))
+		{
+			is_active[i] = 0;
+			active[a] = active.back();
+			active.pop_back();
+		}
+		else
+			++a;
+	}
+}
+
+template <class T>
+void SMOSolver<T>::reconstruct_gradient()
+{
+	unsigned n = alpha.size();
+	if (active.size() == n)
+		return;
+
+	// Shrunk variables are at bounds: g = g_bar - e + contribution of free variables
+	vector<unsigned> inactive;
+	for (unsigned k = 0; k < n; ++k)
+		if (!is_active[k])
+		{
+			g[k] = g_bar[k] - 1;
+			inactive.push_back(k);
+		}
+
+	for (unsigned i : active)
+	{
+		if (is_upper_bound(i) || is_lower_bound(i))
+			continue;
+
+		const T * k_i = cache->row(i);
+		double a_i = alpha[i] * y[i];
+		for (unsigned k : inactive)
+			g[k] += a_i * y[k] * k_i[k];
+	}
+
+	for (unsigned k : inactive)
+	{
+		is_active[k] = 1;
+		active.push_back(k);
+	}
+}
+
+template <class T>
+void SMOSolver<T>::calculate_rho()
+{
+	const double inf = numeric_limits<double>::infinity();
+
+	unsigned nr_free = 0;
+	double ub = inf, lb = -inf, sum_free = 0;
+	for (unsigned i = 0; i < alpha.size(); ++i)
+	{
+		double yg = y[i] * g[i];
+
+		if (is_upper_bound(i))
+		{
+			if (y[i] < 0)
+				ub = min(ub, yg);
+			else
+				lb = max(lb, yg);
+		}
+		else if (is_lower_bound(i))
+		{
+			if (y[i] > 0)
+				ub = min(ub, yg);
+			else
+				lb = max(lb, yg);
+		}
+		else
+		{
+			++nr_free;
+			sum_free += yg;
+		}
+	}
+
+	if (nr_free > 0)
+		rho = sum_free / nr_free;
+	else if (ub == inf || lb == -inf)
+		rho = ub == inf ? lb : ub; // single class: one side is unbounded
+	else
+		rho = (ub + lb) / 2;
+}
+
+namespace SMO_SV {
+
+template <class T>
+signed label(const T & r)
+{
+	return r > 0 ? 1 : -1;
+}
+
+template <class T>
+T linear_kernel(const vector<T> & v1, const vector<T> & v2)
+{
+	return inner_product(v1, v2);
+}
+
+template <class T>
+T second_order_polynomial_kernel(const vector<T> & v1, const vector<T> & v2)
+{
+	return pow(1 + inner_product(v1, v2), 2);
+}
+
+// Kernel evaluated in batches, if the function is one of the above
+template <class T>
+Kernel<T> to_kernel(T (*kernel)(const vector<T> &, const vector<T> &))
+{
+	if (kernel == &linear_kernel<T>)
+		return Kernel<T>::linear();
+
+	if (kernel == &second_order_polynomial_kernel<T>)
+		return Kernel<T>::polynomial(2);
+
+	return Kernel<T>::custom(kernel);
+}
+
+/*******************************************************************************
+* Same interface as MATLAB_SV::learn, solved in process.
+* x_non_scaled should include x0 = 1, y is column of +1/-1.
+* w[0] = b, w[1..] = sum_i alpha_i y_i x_i (weights of linear kernel).
+* Returns number of support vectors
+********************************************************************************/
+template <class T>
+unsigned learn(const Matrix<T> & x_non_scaled,
+			   const Matrix<T> & y, vector<T> & w,
+			   T (*kernel)(const vector<T> &, const vector<T> &),
+			   T c_upper_bound = std::numeric_limits<T>::infinity(),
+			   const SMOParameters & param = SMOParameters())
+{
+	for (unsigned r = 0; r < x_non_scaled.nrow(); ++r)
+		if (x_non_scaled[r][0] != 1.0)
+			throw exception("Wrong format of input");
+
+	if (y.nrow() != x_non_scaled.nrow())
+		throw exception("Wrong format of input");
+
+	// Remove x0
+	unsigned n = x_non_scaled.nrow();
+	unsigned dim = x_non_scaled.ncol() - 1;
+	Matrix<T> x(n, dim);
+	vector<signed> labels(n);
+	for (unsigned r = 0; r < n; ++r)
+	{
+		for (unsigned c = 0; c < dim; ++c)
+			x[r][c] = x_non_scaled[r][c + 1];
+		labels[r] = label(y[r][0]);
+	}
+
+	SMOSolver<T> solver(param);
+	solver.solve(x, labels, to_kernel(kernel), c_upper_bound);
+
+	const vector<double> & alpha = solver.get_alpha();
+
+	w.assign(dim + 1, 0);
+	w[0] = static_cast<T>(-solver.get_rho());
+
+	unsigned sv_count = 0;
+	for (unsigned r = 0; r < n; ++r)
+	{
+		if (alpha[r] <= 0)
+			continue;
+
+		++sv_count;
+		T a = static_cast<T>(alpha[r] * labels[r]);
+		for (unsigned c = 0; c < dim; ++c)
+			w[c + 1] += a * x[r][c];
+	}
+
+	return sv_count;
+}
+
+} // namespace
+
+#endif
@@ -0,0 +1,201 @@
+/*                                                                 -*- C++ -*-
+ * File: svm_binary_file.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Binary sparse SVM data file, mapped into memory
+ *   (written by write_SVM_data_file in svm_data_file.h)
+ *
+ */
+
+#ifndef _SVM_BINARY_FILE_H_
+#define _SVM_BINARY_FILE_H_
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+#include "LA/mapped_file.h"
+
+using namespace std;
+
+/************************************************************
+* Binary sparse data file. Rows are stored as svm_node
+* compatible entries (index, value), each row terminated
+* by index -1, so they are used in place after mmap.
+* Layout (native byte order, sections are 8-byte aligned):
+*   SVMBinaryHeader
+*   double   labels[rows]
+*   uint64_t offsets[rows + 1]   (first entry of each row)
+*   SVMBinaryEntry entries[offsets[rows]]
+************************************************************/
+
+// Same layout as svm_node, feature_node and SparseEntry<double>
+struct SVMBinaryEntry
+{
+	int index;
+	double value;
+};
+
+struct SVMBinaryHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t entry_size;
+	uint64_t rows;
+	uint64_t entries;
+	int32_t max_index;
+	int32_t reserved;
+};
+
+static const char SVM_BINARY_MAGIC[8] = { 'S', 'V', 'M', 'B', 'I', 'N', '\0', '\0' };
+static const uint32_t SVM_BINARY_VERSION = 1;
+
+class SVMBinaryFile
+{
+public:
+
+	typedef SVMBinaryEntry Entry;
+
+	SVMBinaryFile() : header(nullptr), y(nullptr), offsets(nullptr), entries(nullptr) {}
+
+	explicit SVMBinaryFile(const string & file_name) : header(nullptr), y(nullptr), offsets(nullptr), entries(nullptr)
+	{
+		open(file_name);
+	}
+
+	// True if the file starts with binary format signature
+	static bool is_binary(const string & file_name);
+
+	/**
+	 Maps the file copy-on-write: labels and rows may be modified in memory
+	 (e.g. by libsvm), the file itself is not changed.
+	 Sizes, offsets and indices of rows are validated, wrong files throw
+	 */
+	void open(const string & file_name);
+	void close();
+
+	unsigned size() const { return header ? static_cast<unsigned>(header->rows) : 0; }
+	int max_index() const { return header ? header->max_index : 0; }
+
+	double * labels() { return y; }
+	const double * labels() const { return y; }
+
+	const Entry * row(unsigned r) const { return entries + offsets[r]; }
+
+	// Row r as array of Node (svm_node, feature_node), terminated by index -1
+	template <class Node>
+	Node * nodes(unsigned r);
+
+private:
+
+	SVMBinaryFile(const SVMBinaryFile &);
+	SVMBinaryFile & operator = (const SVMBinaryFile &);
+
+	// Closes the file, so that no part of it is used
+	void format_error(const string & file_name)
+	{
+		close();
+
+		stringstream msg;
+		msg << "Wrong binary format of " << file_name;
+		throw exception(msg.str().c_str());
+	}
+
+	MappedFile file;
+	const SVMBinaryHeader * header;
+	double * y;
+	const uint64_t * offsets;
+	Entry * entries;
+};
+
+inline bool SVMBinaryFile::is_binary(const string & file_name)
+{
+	ifstream in(file_name.c_str(), ios::binary);
+	char magic[sizeof(SVM_BINARY_MAGIC)];
+	if (!in.read(magic, sizeof(magic)))
+		return false;
+
+	return memcmp(magic, SVM_BINARY_MAGIC, sizeof(magic)) == 0;
+}
+
+inline void SVMBinaryFile::open(const string & file_name)
+{
+	close();
+	file.open(file_name, true);
+
+	char * base = file.data();
+	size_t size = file.size();
+	if (size < sizeof(SVMBinaryHeader))
+		format_error(file_name);
+
+	header = reinterpret_cast<const SVMBinaryHeader *>(base);
+	if (memcmp(header->magic, SVM_BINARY_MAGIC, sizeof(SVM_BINARY_MAGIC)) != 0 ||
+		header->version != SVM_BINARY_VERSION || header->entry_size != sizeof(Entry))
+		format_error(file_name);
+
+	// Sizes are checked before they are multiplied, so that no product wraps around
+	uint64_t rows = header->rows;
+	uint64_t n_entries = header->entries;
+	uint64_t room = size - sizeof(SVMBinaryHeader);
+	if (rows > 0xffffffffu || room < rows * sizeof(double) + (rows + 1) * sizeof(uint64_t))
+		format_error(file_name);
+
+	room -= rows * sizeof(double) + (rows + 1) * sizeof(uint64_t);
+	if (n_entries > room / sizeof(Entry) || n_entries * sizeof(Entry) != room)
+		format_error(file_name);
+
+	y = reinterpret_cast<double *>(base + sizeof(SVMBinaryHeader));
+	offsets = reinterpret_cast<const uint64_t *>(y + rows);
+	entries = reinterpret_cast<Entry *>(const_cast<uint64_t *>(offsets + rows + 1));
+
+	// Offsets are increasing within entries, every row is terminated
+	if (offsets[0] != 0 || offsets[rows] != n_entries)
+		format_error(file_name);
+
+	for (uint64_t r = 0; r < rows; ++r)
+	{
+		if (offsets[r + 1] <= offsets[r] || offsets[r + 1] > n_entries)
+			format_error(file_name);
+
+		// Same checks as of text rows: indices are increasing (0 is allowed,
+		// as in precomputed kernel), the terminator is the last entry
+		int last_index = -1;
+		for (uint64_t e = offsets[r]; e + 1 < offsets[r + 1]; ++e)
+		{
+			if (entries[e].index <= last_index || entries[e].index > header->max_index)
+				format_error(file_name);
+			last_index = entries[e].index;
+		}
+
+		if (entries[offsets[r + 1] - 1].index != -1)
+			format_error(file_name);
+	}
+}
+
+inline void SVMBinaryFile::close()
+{
+	file.close();
+	header = nullptr;
+	y = nullptr;
+	offsets = nullptr;
+	entries = nullptr;
+}
+
+template <class Node>
+Node * SVMBinaryFile::nodes(unsigned r)
+{
+	static_assert(sizeof(Node) == sizeof(Entry), "SVMBinaryFile::nodes(): inconsistent node size");
+	static_assert(offsetof(Node, index) == offsetof(Entry, index), "SVMBinaryFile::nodes(): inconsistent node layout");
+	static_assert(offsetof(Node, value) == offsetof(Entry, value), "SVMBinaryFile::nodes(): inconsistent node layout");
+
+	return reinterpret_cast<Node *>(entries + offsets[r]);
+}
+
+#endif
@@ -7,6 +7,7 @@
  *
  * Description:
  *   Utility to dump features into SVM supported data file
+ *   (libsvm text format or binary sparse format)
  *   
  */
 
@@ -15,35 +16,190 @@
 
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <charconv>
 
 #include "LA/matrix.h"
+#include "LA/parallel.h"
+#include "svm_binary_file.h"
 
+enum SVMDataFormat { SVM_TEXT, SVM_BINARY };
+
+/**
+ Binary sparse file: zero features are skipped, feature i of a row
+ gets index i + 1 (as in text format)
+ */
 template <class D, class L>
-void write_SVM_data_file(const std::string & fileName, Matrix<D> & features, vector<L> & labels)
+void write_SVM_binary_file(const std::string & fileName, const Matrix<D> & features, const vector<L> & labels)
 {
-	std::cerr << "Writing " << fileName << std::endl;
-	// Open output file
-	ofstream of;
-	stringstream str;
-	str << fileName;
-	of.open(str.str(), 'w');
-	
-	unsigned i = 0;
-	auto itL = labels.begin();
-	for (auto itD = features.begin(), itDEnd = features.end(); 
-		itD != itDEnd; ++itD, ++itL, ++i)
+	typedef SVMBinaryFile::Entry Entry;
+
+	if (features.nrow() != labels.size())
+		throw exception("write_SVM_binary_file: inconsistent num of labels");
+
+	unsigned rows = features.nrow();
+
+	// Offsets are written before the rows, so non-zeros are counted first
+	vector<uint64_t> offsets(rows + 1, 0);
+	int max_index = 0;
+	for (unsigned r = 0; r < rows; ++r)
+	{
+		uint64_t nz = 0;
+		const auto & row = features[r];
+		for (unsigned c = 0; c < row.size(); ++c)
+			if (row[c] != 0)
+			{
+				++nz;
+				max_index = max(max_index, static_cast<int>(c + 1));
+			}
+
+		offsets[r + 1] = offsets[r] + nz + 1;
+	}
+
+	SVMBinaryHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SVM_BINARY_MAGIC, sizeof(SVM_BINARY_MAGIC));
+	header.version = SVM_BINARY_VERSION;
+	header.entry_size = sizeof(Entry);
+	header.rows = rows;
+	header.entries = offsets[rows];
+	header.max_index = max_index;
+
+	ofstream of(fileName.c_str(), ios::binary);
+	if (!of)
+	{
+		stringstream msg;
+		msg << "can't open output file " << fileName;
+		throw exception(msg.str().c_str());
+	}
+
+	of.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+	vector<double> y(labels.begin(), labels.end());
+	of.write(reinterpret_cast<const char *>(y.data()), y.size() * sizeof(double));
+	of.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+
+	// Rows are written in blocks of entries
+	vector<Entry> buffer;
+	buffer.reserve(1 << 16);
+	for (unsigned r = 0; r < rows; ++r)
 	{
-		of << *itL << " ";
-		unsigned id = 1;
-		for (auto itF = itD->begin(), itFEnd = itD->end(); itF != itFEnd; ++itF, ++id)
-				of << id << ":" << *itF << " ";
-		of << "\n";
-		if (i % 1000 == 0)
-			cerr << i << endl;
+		const auto & row = features[r];
+		for (unsigned c = 0; c < row.size(); ++c)
+			if (row[c] != 0)
+			{
+				Entry e = { static_cast<int>(c + 1), static_cast<double>(row[c]) };
+				buffer.push_back(e);
+			}
+
+		Entry terminator = { -1, 0 };
+		buffer.push_back(terminator);
+
+		if (buffer.size() >= (1 << 16) || r + 1 == rows)
+		{
+			of.write(reinterpret_cast<const char *>(buffer.data()), buffer.size() * sizeof(Entry));
+			buffer.clear();
+		}
 	}
 
-	of.close();
-	cerr << "Done!" << endl;
+	if (!of)
+		throw exception("write_SVM_binary_file: write error");
+}
+
+/**
+ Appends rows [row_begin, row_end) in libsvm text format:
+ "label index:value ...\n", zero features skipped, numbers in the
+ shortest form which reads back exactly (in the type of features)
+ */
+template <class D, class L>
+void format_SVM_rows(const Matrix<D> & features, const vector<L> & labels, unsigned row_begin, unsigned row_end, std::string & out)
+{
+	// Longest number (long double) with index and separators fits
+	char buf[96];
+	char * const buf_end = buf + sizeof(buf);
+
+	for (unsigned r = row_begin; r < row_end; ++r)
+	{
+		char * p = to_chars(buf, buf_end, labels[r]).ptr;
+		out.append(buf, p);
+
+		const auto & row = features[r];
+		for (unsigned c = 0; c < row.size(); ++c)
+			if (row[c] != 0)
+			{
+				p = buf;
+				*p++ = ' ';
+				p = to_chars(p, buf_end, c + 1).ptr;
+				*p++ = ':';
+				p = to_chars(p, buf_end, row[c]).ptr;
+				out.append(buf, p);
+			}
+
+		out += '\n';
+	}
+}
+
+/**
+ Text file is formatted in blocks of rows, written in large writes.
+ With nthreads != 1 the blocks of each round are formatted in
+ parallel and written in order, so the file does not depend on
+ nthreads (nthreads == 0 for all hardware threads)
+ */
+template <class D, class L>
+void write_SVM_text_file(const std::string & fileName, const Matrix<D> & features, const vector<L> & labels, unsigned nthreads = 1)
+{
+	const unsigned BLOCK_ROWS = 1024;
+
+	if (features.nrow() != labels.size())
+		throw exception("write_SVM_text_file: inconsistent num of labels");
+
+	ofstream of(fileName.c_str(), ios::binary);
+	if (!of)
+	{
+		stringstream msg;
+		msg << "can't open output file " << fileName;
+		throw exception(msg.str().c_str());
+	}
+
+	unsigned rows = features.nrow();
+	unsigned nblocks = resolve_threads(nthreads);
+
+	// Buffers keep their capacity between rounds
+	vector<std::string> blocks(nblocks);
+	for (unsigned r = 0; r < rows; r += nblocks * BLOCK_ROWS)
+	{
+		unsigned round_end = min(rows, r + nblocks * BLOCK_ROWS);
+		unsigned n = (round_end - r + BLOCK_ROWS - 1) / BLOCK_ROWS;
+
+		parallel_for(0, n, nthreads, [&](unsigned, unsigned b, unsigned e)
+		{
+			for (unsigned k = b; k < e; ++k)
+			{
+				blocks[k].clear();
+				format_SVM_rows(features, labels, r + k * BLOCK_ROWS, min(round_end, r + (k + 1) * BLOCK_ROWS), blocks[k]);
+			}
+		});
+
+		for (unsigned k = 0; k < n; ++k)
+			of.write(blocks[k].data(), blocks[k].size());
+	}
+
+	if (!of)
+		throw exception("write_SVM_text_file: write error");
+}
+
+// No progress output: reporting is left to the caller
+template <class D, class L>
+void write_SVM_data_file(const std::string & fileName, const Matrix<D> & features, const vector<L> & labels,
+	SVMDataFormat format = SVM_TEXT, unsigned nthreads = 1)
+{
+	if (format == SVM_BINARY)
+		write_SVM_binary_file(fileName, features, labels);
+	else
+		write_SVM_text_file(fileName, features, labels, nthreads);
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -2,6 +2,7 @@
 #define _SVM_LINEAR_H
 
 #include "matrix.h"
+#include "LA/sparse_matrix.h"
 
 #include <stdlib.h>
 #include <stdio.h>
@@ -19,8 +20,10 @@ signed label(const T & r)
 	return r > 0 ? 1 : -1;
 }
 
+// Rows of prob.x point directly into x_space (zeros are not stored),
+// so x_space has to outlive prob
 template <class T>
-feature_node * init(const Matrix<T> & x, const Matrix<T> & y, 
+void init(const Matrix<T> & x, const Matrix<T> & y, SparseMatrix<double> & x_space,
 						problem & prob, parameter & param)
 {
 	// default values
@@ -32,11 +35,13 @@ feature_node * init(const Matrix<T> & x, const Matrix<T> & y,
 	param.weight_label = NULL;
 	param.weight = NULL;
 
-	//prob.bias = -1;
-	prob.l = x.row;
+	prob.bias = -1;
+	prob.l = x.nrow();
 	prob.y = Malloc(double,prob.l);
 	prob.x = Malloc(struct feature_node *,prob.l);
-	struct feature_node * x_space = Malloc(struct feature_node, x.row * x.col + y.row /*elements+prob.l*/);
+
+	// Column 0 (x0 = 1) is skipped, so column idx gets index idx
+	x_space = SparseMatrix<double>(x, 1, 1);
 
 	if(param.eps == INF)
 	{
@@ -66,38 +71,13 @@ feature_node * init(const Matrix<T> & x, const Matrix<T> & y,
 		}
 	}
 
-	unsigned j = 0;
-	int inst_max_index = 0, max_index = 0;
 	for (signed i = 0; i < prob.l; ++i)
 	{
-		inst_max_index = -1;
-		prob.x[i] = &x_space[j];
+		prob.x[i] = x_space.nodes<feature_node>(i);
 		prob.y[i] = y[i][0];
-		
-		for (unsigned idx = 1; idx < x.col; ++idx)
-		{
-			x_space[j].index = idx;
-			inst_max_index = x_space[j].index;
-			x_space[j].value = x[i][idx];
-			++j;
-		}
-
-		if (inst_max_index > max_index)
-			max_index = inst_max_index;
-		x_space[j++].index = -1;
-	}
-
-	if(prob.bias >= 0)
-	{
-		prob.n=max_index+1;
-		for(signed i=1;i<prob.l;i++)
-			(prob.x[i]-2)->index = prob.n;
-		x_space[j-2].index = prob.n;
 	}
-	else
-		prob.n=max_index;
 
-	return x_space;
+	prob.n = x_space.ncol();
 }
 
 template <class T>
@@ -105,7 +85,8 @@ model * learn(const Matrix<T> & x, const Matrix<T> & y)
 {
 	struct parameter param;
 	struct problem prob;
-	struct feature_node * x_space = init(x, y, prob, param);
+	SparseMatrix<double> x_space;
+	init(x, y, x_space, prob, param);
 	struct model* model_ = train(&prob, &param);
 
 	double err_in = 0.0;
@@ -121,7 +102,6 @@ model * learn(const Matrix<T> & x, const Matrix<T> & y)
 
 	free(prob.y);
 	free(prob.x);
-	free(x_space);
 
 	return model_;
 }
@@ -131,7 +111,8 @@ T predict(const Matrix<T> & x, const Matrix<T> & y, struct model * model)
 {
 	struct parameter param;
 	struct problem prob;		// set by read_problem
-	struct feature_node * x_space = init(x, y, prob, param);
+	SparseMatrix<double> x_space;
+	init(x, y, x_space, prob, param);
 
 	double eout = 0.0;
 	if (model)
@@ -146,7 +127,6 @@ T predict(const Matrix<T> & x, const Matrix<T> & y, struct model * model)
 
 	free(prob.y);
 	free(prob.x);
-	free(x_space);
 
 	eout /= prob.l;
 
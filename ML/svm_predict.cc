@@ -6,16 +6,65 @@
  */
 
 #include "svm_predict.h"
+#include "svm_binary_file.h"
+#include "svm_text_parser.h"
 #include "libsvm-3.16/svm.h"
+#include "LA/parallel.h"
 
 #include <exception>
 #include <sstream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
 #include <errno.h>
 
 namespace SV {
 
 int (*info)(const char *fmt,...) = &printf;
 
+namespace {
+
+// Accuracy (classification) or error (regression) of batch prediction
+struct BatchStats
+{
+  int correct, total;
+  double error, sump, sumt, sumpp, sumtt, sumpt;
+
+  BatchStats() : correct(0), total(0), error(0), sump(0), sumt(0), sumpp(0), sumtt(0), sumpt(0) {}
+
+  void add(double predict_label, double target_label)
+  {
+    if(predict_label == target_label)
+      ++correct;
+    error += (predict_label-target_label)*(predict_label-target_label);
+    sump += predict_label;
+    sumt += target_label;
+    sumpp += predict_label*predict_label;
+    sumtt += target_label*target_label;
+    sumpt += predict_label*target_label;
+    ++total;
+  }
+
+  double report(int svm_type) const
+  {
+    if (svm_type==NU_SVR || svm_type==EPSILON_SVR)
+    {
+      info("Mean squared error = %g (regression)\n",error/total);
+      info("Squared correlation coefficient = %g (regression)\n",
+        ((total*sumpt-sump*sumt)*(total*sumpt-sump*sumt))/
+        ((total*sumpp-sump*sump)*(total*sumtt-sumt*sumt))
+        );
+      return error/total;
+    }
+
+    info("Accuracy = %g%% (%d/%d) (classification)\n",
+      (double)correct/total*100,correct,total);
+    return 1.0 - ((double)correct/total);
+  }
+};
+
+} // namespace
+
 SVM_Predict::SVM_Predict() : 
    model(NULL),
    predict_probability_(false),  
@@ -72,6 +121,192 @@ double SVM_Predict::predict(const svm_node * x, double * prob_estimates) const
   return svm_predict(model,x);
 }
 
+int SVM_Predict::num_classes() const
+{
+  return svm_get_nr_class(model);
+}
+
+unsigned SVM_Predict::num_decision_values() const
+{
+  int svm_type=svm_get_svm_type(model);
+  if (svm_type==ONE_CLASS || svm_type==EPSILON_SVR || svm_type==NU_SVR)
+    return 1;
+
+  unsigned nr_class=svm_get_nr_class(model);
+  return nr_class*(nr_class-1)/2;
+}
+
+bool SVM_Predict::probability_output() const
+{
+  int svm_type=svm_get_svm_type(model);
+  return predict_probability_ && (svm_type==C_SVC || svm_type==NU_SVC);
+}
+
+double SVM_Predict::probability_estimates(const double * dec_values, double * prob_estimates) const
+{
+  // Same as svm_predict_probability of libsvm after svm_predict_values:
+  // pairwise sigmoids, then pairwise coupling (Wu, Lin, Weng, method 2)
+  int nr_class=svm_get_nr_class(model);
+  double min_prob=1e-7;
+  vector<vector<double> > r(nr_class, vector<double>(nr_class));
+  int k=0;
+  for(int i=0;i<nr_class;i++)
+    for(int j=i+1;j<nr_class;j++)
+    {
+      double fApB=dec_values[k]*model->probA[k]+model->probB[k];
+      double p=fApB >= 0 ? exp(-fApB)/(1.0+exp(-fApB)) : 1.0/(1+exp(fApB));
+      r[i][j]=min(max(p,min_prob),1-min_prob);
+      r[j][i]=1-r[i][j];
+      k++;
+    }
+
+  int t,j;
+  int iter, max_iter=max(100,nr_class);
+  vector<vector<double> > Q(nr_class, vector<double>(nr_class));
+  vector<double> Qp(nr_class);
+  double pQp, eps=0.005/nr_class;
+  double *p=prob_estimates;
+
+  for (t=0;t<nr_class;t++)
+  {
+    p[t]=1.0/nr_class;
+    Q[t][t]=0;
+    for (j=0;j<t;j++)
+    {
+      Q[t][t]+=r[j][t]*r[j][t];
+      Q[t][j]=Q[j][t];
+    }
+    for (j=t+1;j<nr_class;j++)
+    {
+      Q[t][t]+=r[j][t]*r[j][t];
+      Q[t][j]=-r[j][t]*r[t][j];
+    }
+  }
+  for (iter=0;iter<max_iter;iter++)
+  {
+    pQp=0;
+    for (t=0;t<nr_class;t++)
+    {
+      Qp[t]=0;
+      for (j=0;j<nr_class;j++)
+        Qp[t]+=Q[t][j]*p[j];
+      pQp+=p[t]*Qp[t];
+    }
+    double max_error=0;
+    for (t=0;t<nr_class;t++)
+    {
+      double error=fabs(Qp[t]-pQp);
+      if (error>max_error)
+        max_error=error;
+    }
+    if (max_error<eps) break;
+
+    for (t=0;t<nr_class;t++)
+    {
+      double diff=(-Qp[t]+pQp)/Q[t][t];
+      p[t]+=diff;
+      pQp=(pQp+diff*(diff*Q[t][t]+2*Qp[t]))/(1+diff)/(1+diff);
+      for (j=0;j<nr_class;j++)
+      {
+        Qp[j]=(Qp[j]+diff*Q[t][j])/(1+diff);
+        p[j]/=(1+diff);
+      }
+    }
+  }
+  if (iter>=max_iter)
+    info("Exceeds max_iter in multiclass_prob\n");
+
+  int prob_max_idx = 0;
+  for(int i=1;i<nr_class;i++)
+    if(p[i] > p[prob_max_idx])
+      prob_max_idx = i;
+
+  return model->label[prob_max_idx];
+}
+
+void SVM_Predict::predict_row(const svm_node * x, unsigned r, double * labels, double * decision_values, 
+    double * probabilities, double * buffer) const
+{
+  // Kernel values are computed once: probabilities are derived from decision values
+  unsigned nr_dec = num_decision_values();
+  double * dec_values = decision_values ? decision_values + (size_t) r*nr_dec : buffer;
+  double predict_label = svm_predict_values(model,x,dec_values);
+
+  if (probability_output())
+    predict_label = probability_estimates(dec_values,
+        probabilities ? probabilities + (size_t) r*svm_get_nr_class(model) : buffer + nr_dec);
+
+  if (labels)
+    labels[r] = predict_label;
+}
+
+void SVM_Predict::predict(unsigned n, const svm_node * const * rows, double * labels, 
+    double * decision_values, double * probabilities, unsigned nthreads) const
+{
+  if (probabilities && !probability_output())
+    throw exception("SVM_Predict::predict: probability estimates are not enabled");
+
+  // svm_predict* functions do not change the model
+  parallel_for(0, n, nthreads, [&](unsigned, unsigned b, unsigned e)
+  {
+    vector<double> buffer(num_decision_values() + svm_get_nr_class(model));
+    for (unsigned r = b; r < e; ++r)
+      predict_row(rows[r], r, labels, decision_values, probabilities, buffer.data());
+  });
+}
+
+void SVM_Predict::predict(unsigned n, unsigned dim, const double * features, double * labels, 
+    double * decision_values, double * probabilities, unsigned nthreads) const
+{
+  if (probabilities && !probability_output())
+    throw exception("SVM_Predict::predict: probability estimates are not enabled");
+
+  parallel_for(0, n, nthreads, [&](unsigned, unsigned b, unsigned e)
+  {
+    vector<double> buffer(num_decision_values() + svm_get_nr_class(model));
+    vector<svm_node> x(dim + 1);
+    for (unsigned r = b; r < e; ++r)
+    {
+      // Sparse copy of the row, feature c gets index c + 1 (as in data files)
+      const double * row = features + (size_t) r*dim;
+      unsigned i = 0;
+      for (unsigned c = 0; c < dim; ++c)
+        if (row[c] != 0)
+        {
+          x[i].index = c + 1;
+          x[i].value = row[c];
+          ++i;
+        }
+      x[i].index = -1;
+
+      predict_row(x.data(), r, labels, decision_values, probabilities, buffer.data());
+    }
+  });
+}
+
+double SVM_Predict::predict(const string & input_file, FILE * output, unsigned nthreads)
+{
+  vector<svm_node *> rows;
+
+  if (SVMBinaryFile::is_binary(input_file))
+  {
+    SVMBinaryFile input(input_file);
+    rows.resize(input.size());
+    for (unsigned r = 0; r < input.size(); ++r)
+      rows[r] = input.nodes<svm_node>(r);
+
+    return batch_predict(input.size(), input.labels(), rows.data(), output, nthreads);
+  }
+
+  SVMTextParser parser(input_file, nthreads);
+  vector<double> labels(parser.size());
+  vector<svm_node> nodes(parser.num_entries());
+  rows.resize(parser.size());
+  parser.parse(labels.data(), rows.data(), nodes.data());
+
+  return batch_predict(parser.size(), labels.data(), rows.data(), output, nthreads);
+}
+
 double SVM_Predict::predict(FILE *input, FILE * output)
 {  
   x = (struct svm_node *) malloc(max_nr_attr*sizeof(struct svm_node));
@@ -99,41 +334,89 @@ char* SVM_Predict::readline(FILE *input)
   return line;
 }
 
-double SVM_Predict::batch_predict(FILE *input, FILE *output)
+double * SVM_Predict::start_output(FILE *output) const
 {
-  int correct = 0;
-  int total = 0;
-  double error = 0;
-  double sump = 0, sumt = 0, sumpp = 0, sumtt = 0, sumpt = 0;
+  if(!predict_probability_)
+    return NULL;
 
   int svm_type=svm_get_svm_type(model);
   int nr_class=svm_get_nr_class(model);
-  double *prob_estimates=NULL;
-  int j;
 
-  if(predict_probability_)
+  if (svm_type==NU_SVR || svm_type==EPSILON_SVR)
   {
-    if (svm_type==NU_SVR || svm_type==EPSILON_SVR)
-      info("Prob. model for test data: target value = predicted value + z,\nz: Laplace distribution e^(-|z|/sigma)/(2sigma),sigma=%g\n",svm_get_svr_probability(model));
-    else
-    {
-      int *labels=(int *) malloc(nr_class*sizeof(int));
-      svm_get_labels(model,labels);
-      prob_estimates = (double *) malloc(nr_class*sizeof(double));
-      fprintf(output,"labels");   
-      for(j=0;j<nr_class;j++)
-        fprintf(output," %d",labels[j]);
-      fprintf(output,"\n");
-      free(labels);
-    }
+    info("Prob. model for test data: target value = predicted value + z,\nz: Laplace distribution e^(-|z|/sigma)/(2sigma),sigma=%g\n",svm_get_svr_probability(model));
+    return NULL;
   }
 
+  int *labels=(int *) malloc(nr_class*sizeof(int));
+  svm_get_labels(model,labels);
+  fprintf(output,"labels");   
+  for(int j=0;j<nr_class;j++)
+    fprintf(output," %d",labels[j]);
+  fprintf(output,"\n");
+  free(labels);
+
+  return (double *) malloc(nr_class*sizeof(double));
+}
+
+double SVM_Predict::predict_and_write(const svm_node * x, double * prob_estimates, FILE *output) const
+{
+  double predict_label;
+  int svm_type=svm_get_svm_type(model);
+
+  if (predict_probability_ && (svm_type==C_SVC || svm_type==NU_SVC))
+  {
+    int nr_class=svm_get_nr_class(model);
+    predict_label = svm_predict_probability(model,x,prob_estimates);
+    fprintf(output,"%g",predict_label);
+    for(int j=0;j<nr_class;j++)
+      fprintf(output," %g",prob_estimates[j]);
+    fprintf(output,"\n");
+  }
+  else
+  {
+    predict_label = svm_predict(model,x);
+    fprintf(output,"%g\n",predict_label);
+  }
+
+  return predict_label;
+}
+
+double SVM_Predict::batch_predict(unsigned n, const double * labels, svm_node * const * rows, FILE *output, unsigned nthreads)
+{
+  BatchStats stats;
+  free(start_output(output));
+
+  // Predicted in parallel, written in order
+  int nr_class=svm_get_nr_class(model);
+  vector<double> predicted(n), prob_estimates(probability_output() ? (size_t) n*nr_class : 0);
+  predict(n, rows, predicted.data(), NULL, prob_estimates.empty() ? NULL : prob_estimates.data(), nthreads);
+
+  for (unsigned r = 0; r < n; ++r)
+  {
+    fprintf(output,"%g",predicted[r]);
+    if (!prob_estimates.empty())
+      for(int j=0;j<nr_class;j++)
+        fprintf(output," %g",prob_estimates[(size_t) r*nr_class+j]);
+    fprintf(output,"\n");
+
+    stats.add(predicted[r], labels[r]);
+  }
+
+  return stats.report(svm_get_svm_type(model));
+}
+
+double SVM_Predict::batch_predict(FILE *input, FILE *output)
+{
+  BatchStats stats;
+  double *prob_estimates = start_output(output);
+
   max_line_len = 1024;
   line = (char *)malloc(max_line_len*sizeof(char));
   while(readline(input) != NULL)
   {
     int i = 0;
-    double target_label, predict_label;
+    double target_label;
     char *idx, *val, *label, *endptr;
     int inst_max_index = -1; // strtol gives 0 if wrong format, and precomputed kernel has <index> start from 0
 
@@ -141,7 +424,7 @@ double SVM_Predict::batch_predict(FILE *input, FILE *output)
     if(label == NULL) // empty line
 	{
 		stringstream msg;
-		msg << "Wrong input format at line " << total+1;
+		msg << "Wrong input format at line " << stats.total+1;
         throw exception(msg.str().c_str());
 	}
 
@@ -149,7 +432,7 @@ double SVM_Predict::batch_predict(FILE *input, FILE *output)
     if(endptr == label || *endptr != '\0')
 	{
 		stringstream msg;
-		msg << "Wrong input format at line " << total+1;
+		msg << "Wrong input format at line " << stats.total+1;
         throw exception(msg.str().c_str());
 	}
     
@@ -171,7 +454,7 @@ double SVM_Predict::batch_predict(FILE *input, FILE *output)
       if(endptr == idx || errno != 0 || *endptr != '\0' || x[i].index <= inst_max_index)
 	  {
 		  stringstream msg;
-		  msg << "Wrong input format at line " << total+1;
+		  msg << "Wrong input format at line " << stats.total+1;
           throw exception(msg.str().c_str());
 	  }
       else
@@ -182,7 +465,7 @@ double SVM_Predict::batch_predict(FILE *input, FILE *output)
       if(endptr == val || errno != 0 || (*endptr != '\0' && !isspace(*endptr)))
 		   {
 		  stringstream msg;
-		  msg << "Wrong input format at line " << total+1;
+		  msg << "Wrong input format at line " << stats.total+1;
           throw exception(msg.str().c_str());
 	  }
 
@@ -190,52 +473,12 @@ double SVM_Predict::batch_predict(FILE *input, FILE *output)
     }
     x[i].index = -1;
 
-    if (predict_probability_ && (svm_type==C_SVC || svm_type==NU_SVC))
-    {
-      predict_label = svm_predict_probability(model,x,prob_estimates);
-      fprintf(output,"%g",predict_label);
-      for(j=0;j<nr_class;j++)
-        fprintf(output," %g",prob_estimates[j]);
-      fprintf(output,"\n");
-    }
-    else
-    {
-      predict_label = svm_predict(model,x);
-      fprintf(output,"%g\n",predict_label);
-    }
-
-    if(predict_label == target_label)
-      ++correct;
-    error += (predict_label-target_label)*(predict_label-target_label);
-    sump += predict_label;
-    sumt += target_label;
-    sumpp += predict_label*predict_label;
-    sumtt += target_label*target_label;
-    sumpt += predict_label*target_label;
-    ++total;
+    stats.add(predict_and_write(x, prob_estimates, output), target_label);
   }
 
-  double retval = 0.0;
-
-  if (svm_type==NU_SVR || svm_type==EPSILON_SVR)
-  {
-    info("Mean squared error = %g (regression)\n",error/total);
-    info("Squared correlation coefficient = %g (regression)\n",
-      ((total*sumpt-sump*sumt)*(total*sumpt-sump*sumt))/
-      ((total*sumpp-sump*sump)*(total*sumtt-sumt*sumt))
-      );
-	retval = error/total;
-  }
-  else
-  {
-	retval = 1.0 - ((double)correct/total);
-    info("Accuracy = %g%% (%d/%d) (classification)\n",
-      (double)correct/total*100,correct,total);
-  }
-  if(predict_probability_)
-    free(prob_estimates);
+  free(prob_estimates);
 
-  return retval;
+  return stats.report(svm_get_svm_type(model));
 }
 
 } // namespace
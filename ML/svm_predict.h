@@ -40,12 +40,59 @@ public:
   // Batch processing. 
   double predict(FILE *input, FILE * output);
   
+  // Batch processing of text or binary (see svm_binary_file.h) file.
+  // Text is parsed and examples are predicted by nthreads (0 for all hardware threads)
+  double predict(const string & input_file, FILE * output, unsigned nthreads = 1);
+  
   // Processing single feature set
   double predict(const svm_node * input, double * prob_estimates = NULL) const;
   
+  /**
+   Processing batch of n in-memory examples by nthreads (nthreads == 0 
+   for all hardware threads). Any output may be NULL, otherwise:
+     labels[n] - predicted labels (as by single predict)
+     decision_values[n * num_decision_values()]
+     probabilities[n * num_classes()] - only if probability estimates
+       are enabled and model is classifier
+   Rows are terminated by index -1
+   */
+  void predict(unsigned n, const svm_node * const * rows, double * labels, 
+      double * decision_values = NULL, double * probabilities = NULL, unsigned nthreads = 1) const;
+  
+  // Same for dense row-major features[n * dim], zero features are skipped
+  void predict(unsigned n, unsigned dim, const double * features, double * labels, 
+      double * decision_values = NULL, double * probabilities = NULL, unsigned nthreads = 1) const;
+  
+  int num_classes() const;
+  
+  // nr_class * (nr_class - 1) / 2 for classification, 1 otherwise
+  unsigned num_decision_values() const;
+  
 private: 
   
   double batch_predict(FILE *input, FILE *output);
+  double batch_predict(unsigned n, const double * labels, svm_node * const * rows, FILE *output, unsigned nthreads);
+  
+  // Writes header of batch output, returns buffer for probability estimates (or NULL)
+  double * start_output(FILE *output) const;
+  
+  // Predicts single example of batch and writes the result
+  double predict_and_write(const svm_node * x, double * prob_estimates, FILE *output) const;
+  
+  // Probability estimates are enabled and model is classifier
+  bool probability_output() const;
+  
+  /**
+   Probability estimates of classes from decision values (as libsvm computes
+   them in svm_predict_probability), returns label of the most probable class
+   */
+  double probability_estimates(const double * dec_values, double * prob_estimates) const;
+  
+  // Predicts example r of in-memory batch. buffer[num_decision_values() + num_classes()]
+  // is used for outputs which are not requested
+  void predict_row(const svm_node * x, unsigned r, double * labels, double * decision_values, 
+      double * probabilities, double * buffer) const;
+  
   int print_null(const char *s,...) {return 0;}
   
 private: 
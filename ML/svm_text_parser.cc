@@ -0,0 +1,306 @@
+/*                                                                 -*- C++ -*-
+ * File: svm_text_parser.cc
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Parallel parser of libsvm text data files
+ *
+ */
+
+#include "svm_text_parser.h"
+#include "LA/parallel.h"
+
+#include <cstdlib>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <sstream>
+#include <exception>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+// Smaller files are not split
+const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+const double POW10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+void input_error(unsigned line_num)
+{
+	stringstream msg;
+	msg << "Wrong input format at line " << line_num;
+	throw exception(msg.str().c_str());
+}
+
+inline bool is_blank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool is_digit(char c)
+{
+	return static_cast<unsigned>(c - '0') < 10;
+}
+
+// With check_range, values out of range of double (errno ERANGE) are rejected
+bool parse_double_strtod(const char * begin, const char * end, double & v, bool check_range)
+{
+	string token(begin, end);
+	char * endptr;
+	errno = 0;
+	v = strtod(token.c_str(), &endptr);
+
+	return endptr != token.c_str() && *endptr == '\0' && (!check_range || errno == 0);
+}
+
+/**
+ Number occupying whole [begin, end). Mantissas up to 2^53 with decimal
+ exponents up to 22 are converted by single correctly rounded multiplication
+ or division (so the result is the same as of strtod), anything else by strtod
+ */
+bool parse_double(const char * begin, const char * end, double & v, bool check_range)
+{
+	const char * p = begin;
+	bool negative = false;
+	if (p != end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	uint64_t mantissa = 0;
+	int digits = 0, exponent = 0;
+	bool any = false, exact = true;
+
+	for (; p != end && is_digit(*p); ++p)
+	{
+		any = true;
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			if (mantissa)
+				++digits;
+		}
+		else
+		{
+			++exponent;
+			exact = exact && *p == '0';
+		}
+	}
+
+	if (p != end && *p == '.')
+		for (++p; p != end && is_digit(*p); ++p)
+		{
+			any = true;
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa)
+					++digits;
+				--exponent;
+			}
+			else
+				exact = exact && *p == '0';
+		}
+
+	if (any && p != end && (*p == 'e' || *p == 'E'))
+	{
+		const char * q = p + 1;
+		bool negative_exponent = false;
+		if (q != end && (*q == '-' || *q == '+'))
+			negative_exponent = *q++ == '-';
+
+		if (q != end && is_digit(*q))
+		{
+			int e = 0;
+			for (; q != end && is_digit(*q); ++q)
+				if (e < 100000)
+					e = e * 10 + (*q - '0');
+
+			exponent += negative_exponent ? -e : e;
+			p = q;
+		}
+	}
+
+	if (any && p == end && exact && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+	{
+		double d = static_cast<double>(mantissa);
+		d = exponent < 0 ? d / POW10[-exponent] : d * POW10[exponent];
+		v = negative ? -d : d;
+		return true;
+	}
+
+	// Long mantissa, large exponent, inf, nan, hex and errors
+	return parse_double_strtod(begin, end, v, check_range);
+}
+
+bool parse_index(const char * begin, const char * end, int & index)
+{
+	const char * p = begin;
+	bool negative = false;
+	if (p != end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	if (p == end)
+		return false;
+
+	long long v = 0;
+	for (; p != end; ++p)
+	{
+		if (!is_digit(*p))
+			return false;
+
+		v = v * 10 + (*p - '0');
+		if (v > INT_MAX)
+			return false;
+	}
+
+	index = static_cast<int>(negative ? -v : v);
+	return true;
+}
+
+} // namespace
+
+SVMTextParser::SVMTextParser(const string & file_name, unsigned nthreads) :
+	file(file_name), nthreads(nthreads), lines(0), entries(0)
+{
+	const char * data = file.data();
+	size_t size = file.size();
+	if (size == 0)
+		return;
+
+	// Chunk boundaries are moved forward to line starts
+	const char * end = data + size;
+	unsigned n = static_cast<unsigned>(min<size_t>(resolve_threads(nthreads), max<size_t>(size / MIN_CHUNK_SIZE, 1)));
+	const char * begin = data;
+	for (unsigned c = 0; c < n && begin != end; ++c)
+	{
+		const char * chunk_end = c + 1 == n ? end : max(begin, data + size / n * (c + 1));
+		if (chunk_end != end)
+		{
+			const char * nl = static_cast<const char *>(memchr(chunk_end, '\n', end - chunk_end));
+			chunk_end = nl ? nl + 1 : end;
+		}
+
+		Chunk chunk = { begin, chunk_end, 0, 0 };
+		chunks.push_back(chunk);
+		begin = chunk_end;
+	}
+
+	// Lines and features (one per ':') of each chunk
+	vector<unsigned> chunk_lines(chunks.size());
+	vector<size_t> chunk_features(chunks.size());
+	parallel_for(0, chunks.size(), nthreads, [&](unsigned, unsigned b, unsigned e)
+	{
+		for (unsigned c = b; c < e; ++c)
+		{
+			unsigned nl = 0;
+			size_t colons = 0;
+			for (const char * p = chunks[c].begin; p != chunks[c].end; ++p)
+			{
+				nl += *p == '\n';
+				colons += *p == ':';
+			}
+
+			// Last line of file may have no newline
+			if (chunks[c].end[-1] != '\n')
+				++nl;
+
+			chunk_lines[c] = nl;
+			chunk_features[c] = colons;
+		}
+	});
+
+	for (unsigned c = 0; c < chunks.size(); ++c)
+	{
+		chunks[c].first_line = lines;
+		chunks[c].first_entry = entries;
+		lines += chunk_lines[c];
+		entries += chunk_features[c] + chunk_lines[c];
+	}
+}
+
+int SVMTextParser::parse(double * labels, Entry ** rows, Entry * nodes) const
+{
+	vector<int> max_index(chunks.size(), 0);
+
+	// Exception of the first failed chunk is rethrown: errors are reported in file order
+	parallel_for(0, chunks.size(), nthreads, [&](unsigned, unsigned b, unsigned e)
+	{
+		for (unsigned c = b; c < e; ++c)
+			max_index[c] = parse_chunk(chunks[c], labels, rows, nodes);
+	});
+
+	return max_index.empty() ? 0 : *max_element(max_index.begin(), max_index.end());
+}
+
+int SVMTextParser::parse_chunk(const Chunk & chunk, double * labels, Entry ** rows, Entry * nodes) const
+{
+	int max_index = 0;
+	unsigned line = chunk.first_line;
+	Entry * out = nodes + chunk.first_entry;
+
+	// Every node written has its ':' (or line for terminator) counted, so out stays in bounds
+	for (const char * p = chunk.begin; p < chunk.end; ++line)
+	{
+		const char * eol = static_cast<const char *>(memchr(p, '\n', chunk.end - p));
+		if (!eol)
+			eol = chunk.end;
+
+		// label
+		while (p != eol && is_blank(*p))
+			++p;
+		const char * q = p;
+		while (q != eol && !is_blank(*q))
+			++q;
+
+		// As in libsvm tools, range is checked for feature values only
+		if (p == q || !parse_double(p, q, labels[line], false))
+			input_error(line + 1);
+
+		rows[line] = out;
+		int inst_max_index = -1; // precomputed kernel has <index> start from 0
+
+		// index:value pairs
+		for (p = q; ; p = q)
+		{
+			while (p != eol && is_blank(*p))
+				++p;
+			if (p == eol)
+				break;
+
+			q = p;
+			while (q != eol && *q != ':' && !is_blank(*q))
+				++q;
+
+			if (q == eol || *q != ':' || !parse_index(p, q, out->index) || out->index <= inst_max_index)
+				input_error(line + 1);
+			inst_max_index = out->index;
+
+			p = q + 1;
+			q = p;
+			while (q != eol && !is_blank(*q))
+				++q;
+
+			if (p == q || !parse_double(p, q, out->value, true))
+				input_error(line + 1);
+
+			++out;
+		}
+
+		max_index = max(max_index, inst_max_index);
+		out->index = -1;
+		out->value = 0;
+		++out;
+
+		p = eol == chunk.end ? eol : eol + 1;
+	}
+
+	return max_index;
+}
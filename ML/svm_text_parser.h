@@ -0,0 +1,92 @@
+/*                                                                 -*- C++ -*-
+ * File: svm_text_parser.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Parallel parser of libsvm text data files
+ *
+ */
+
+#ifndef _SVM_TEXT_PARSER_H_
+#define _SVM_TEXT_PARSER_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "LA/mapped_file.h"
+#include "svm_binary_file.h"
+
+using namespace std;
+
+/************************************************************
+* The file is mapped and split into newline-aligned chunks.
+* Constructor counts lines and features of each chunk (one
+* pass, in parallel), so the caller allocates storage once;
+* parse() fills it, chunks in parallel, each at its offset.
+* Numbers are parsed without strtok/strtod (strtod is the
+* fallback for long mantissas and special values), results
+* are the same as of strtod. Feature values out of range of
+* double are rejected, as by libsvm tools.
+* Errors report exact line numbers, as libsvm tools do
+************************************************************/
+class SVMTextParser
+{
+public:
+
+	typedef SVMBinaryEntry Entry;
+
+	// nthreads == 0 for all hardware threads
+	explicit SVMTextParser(const string & file_name, unsigned nthreads = 1);
+
+	// Number of examples (lines)
+	unsigned size() const { return lines; }
+
+	// Number of nodes of all rows, including terminators
+	size_t num_entries() const { return entries; }
+
+	/**
+	 Fills labels[size()], rows[size()] and nodes[num_entries()]:
+	 rows[r] points to row r in nodes, terminated by index -1.
+	 Returns max feature index
+	 */
+	int parse(double * labels, Entry ** rows, Entry * nodes) const;
+
+	// Same for svm_node (or any node with svm_node layout)
+	template <class Node>
+	int parse(double * labels, Node ** rows, Node * nodes) const;
+
+private:
+
+	struct Chunk
+	{
+		const char * begin;
+		const char * end;
+		unsigned first_line;
+		size_t first_entry;
+	};
+
+	// Parses lines of chunk, returns max feature index
+	int parse_chunk(const Chunk & chunk, double * labels, Entry ** rows, Entry * nodes) const;
+
+	MappedFile file;
+	unsigned nthreads;
+	vector<Chunk> chunks;
+	unsigned lines;
+	size_t entries;
+};
+
+template <class Node>
+int SVMTextParser::parse(double * labels, Node ** rows, Node * nodes) const
+{
+	static_assert(sizeof(Node) == sizeof(Entry), "SVMTextParser::parse(): inconsistent node size");
+	static_assert(offsetof(Node, index) == offsetof(Entry, index), "SVMTextParser::parse(): inconsistent node layout");
+	static_assert(offsetof(Node, value) == offsetof(Entry, value), "SVMTextParser::parse(): inconsistent node layout");
+
+	return parse(labels, reinterpret_cast<Entry **>(rows), reinterpret_cast<Entry *>(nodes));
+}
+
+#endif
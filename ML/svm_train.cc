@@ -11,6 +11,7 @@
  */
 
 #include "svm_train.h"
+#include "svm_text_parser.h"
 #include "libsvm-3.16/svm.h"
 #include <cstdio>
 #include <cctype>
@@ -22,22 +23,11 @@ using namespace std;
 
 namespace SV {
 
-namespace {
-
-void exit_input_error(int line_num)
-{
-	stringstream msg;
-	msg << "Wrong input format at line " << line_num;
-	throw exception(msg.str().c_str());
-}
-
-} // namespace
-
 SVM_Train::SVM_Train() : 
 	model(NULL),
 	x_space(NULL),
 	nr_fold(0),
-	line(NULL)
+	nthreads(1)
 {
 	// default values
 	param.svm_type = C_SVC;
@@ -61,112 +51,16 @@ SVM_Train::~SVM_Train()
 {
 }
 
-char* SVM_Train::readline(FILE *input)
-{
-	int len;
-	
-	if(fgets(line,max_line_len,input) == NULL)
-		return NULL;
-
-	while(strrchr(line,'\n') == NULL)
-	{
-		max_line_len *= 2;
-		line = (char *) realloc(line,max_line_len);
-		len = (int) strlen(line);
-		if(fgets(line+len,max_line_len-len,input) == NULL)
-			break;
-	}
-	return line;
-}
-
 void SVM_Train::read_problem(const char *filename)
 {
-	int elements, max_index, inst_max_index, i, j;
-	FILE *fp = fopen(filename,"r");
-	char *endptr;
-	char *idx, *val, *label;
-
-	if(fp == NULL)
-	{
-		stringstream msg;
-		msg << "can't open input file " << filename;
-		throw exception(msg.str().c_str());
-	}
-
-	prob.l = 0;
-	elements = 0;
-
-	max_line_len = 1024;
-	line = Malloc(char,max_line_len);
-	while(readline(fp)!=NULL)
-	{
-		char *p = strtok(line," \t"); // label
-
-		// features
-		while(1)
-		{
-			p = strtok(NULL," \t");
-			if(p == NULL || *p == '\n') // check '\n' as ' ' may be after the last feature
-				break;
-			++elements;
-		}
-		++elements;
-		++prob.l;
-	}
-	rewind(fp);
-
-	prob.y = Malloc(double,prob.l);
-	prob.x = Malloc(struct svm_node *,prob.l);
-	x_space = Malloc(struct svm_node,elements);
-
-	max_index = 0;
-	j=0;
-	for(i=0;i<prob.l;i++)
-	{
-		inst_max_index = -1; // strtol gives 0 if wrong format, and precomputed kernel has <index> start from 0
-		readline(fp);
-		prob.x[i] = &x_space[j];
-		label = strtok(line," \t\n");
-		if(label == NULL) // empty line
-			exit_input_error(i+1);
-
-		prob.y[i] = strtod(label,&endptr);
-		if(endptr == label || *endptr != '\0')
-			exit_input_error(i+1);
-
-		while(1)
-		{
-			idx = strtok(NULL,":");
-			val = strtok(NULL," \t");
-
-			if(val == NULL)
-				break;
-
-			errno = 0;
-			x_space[j].index = (int) strtol(idx,&endptr,10);
-			if(endptr == idx || errno != 0 || *endptr != '\0' || x_space[j].index <= inst_max_index)
-				exit_input_error(i+1);
-			else
-				inst_max_index = x_space[j].index;
-
-			errno = 0;
-			x_space[j].value = strtod(val,&endptr);
-			if(endptr == val || errno != 0 || (*endptr != '\0' && !isspace(*endptr)))
-				exit_input_error(i+1);
-
-			++j;
-		}
-
-		if(inst_max_index > max_index)
-			max_index = inst_max_index;
-		x_space[j++].index = -1;
-	}
+	int max_index = SVMBinaryFile::is_binary(filename) ? 
+		read_binary_problem(filename) : read_text_problem(filename);
 
 	if(param.gamma == 0 && max_index > 0)
 		param.gamma = 1.0/max_index;
 
 	if(param.kernel_type == PRECOMPUTED)
-		for(i=0;i<prob.l;i++)
+		for(int i=0;i<prob.l;i++)
 		{
 			if (prob.x[i][0].index != 0)
 				throw exception("Wrong input format: first column must be 0:sample_serial_number");	
@@ -174,8 +68,36 @@ void SVM_Train::read_problem(const char *filename)
 			if ((int)prob.x[i][0].value <= 0 || (int)prob.x[i][0].value > max_index)
 				throw exception("Wrong input format: sample_serial_number out of range");		
 		}
+}
+
+int SVM_Train::read_binary_problem(const char *filename)
+{
+	binary.open(filename);
+
+	prob.l = binary.size();
+	prob.y = Malloc(double,prob.l);
+	prob.x = Malloc(struct svm_node *,prob.l);
+	memcpy(prob.y, binary.labels(), prob.l * sizeof(double));
+
+	for(int i=0;i<prob.l;i++)
+		prob.x[i] = binary.nodes<svm_node>(i);
+
+	x_space = NULL;
+
+	return binary.max_index();
+}
+
+int SVM_Train::read_text_problem(const char *filename)
+{
+	// Lines and features are counted first, then parsed in place
+	SVMTextParser parser(filename, nthreads);
+
+	prob.l = parser.size();
+	prob.y = Malloc(double,prob.l);
+	prob.x = Malloc(struct svm_node *,prob.l);
+	x_space = Malloc(struct svm_node,parser.num_entries());
 
-	fclose(fp);
+	return parser.parse(prob.y, prob.x, x_space);
 }
 
 void SVM_Train::do_train(const char * input_file_name, const char * model_file_name)
@@ -200,7 +122,7 @@ void SVM_Train::do_train(const char * input_file_name, const char * model_file_n
 	free(prob.y);
 	free(prob.x);
 	free(x_space);
-	free(line);
+	binary.close();
 }
 
 double SVM_Train::do_cross_validation(const char * input_file_name, int n_fold)
@@ -261,7 +183,7 @@ double SVM_Train::do_cross_validation(const char * input_file_name, int n_fold)
 	free(prob.y);
 	free(prob.x);
 	free(x_space);
-	free(line);
+	binary.close();
 
 	return retval;
 }
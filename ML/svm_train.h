@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "libsvm-3.16/svm.h"
+#include "svm_binary_file.h"
 
 #define Malloc(type,n) (type *)malloc((n)*sizeof(type))
 
@@ -31,25 +32,30 @@ public:
 
 	svm_parameter & parameter() { return param; }
 	const svm_parameter & parameter() const { return param; }
+
+	// Threads parsing text input, 0 for all hardware threads (1 by default)
+	void set_nthreads(unsigned n) { nthreads = n; }
 	
 	double do_cross_validation(const char *filename, int nr_fold);
 	void do_train(const char * input_file_name, const char * model_file_name);
 
 private:
 
-	char* readline(FILE *input);
 	void read_problem(const char *filename);
+
+	// Fill prob, return max feature index
+	int read_text_problem(const char *filename);
+	int read_binary_problem(const char *filename);
 	
 private:
 	svm_parameter param;	
 	svm_problem prob;		// set by read_problem
 	svm_model *model;
 	svm_node *x_space;
+	SVMBinaryFile binary;	// rows of binary input are used in place
 
 	int nr_fold;
-
-	char *line;
-	int max_line_len;
+	unsigned nthreads;
 };
 
 } // namespace
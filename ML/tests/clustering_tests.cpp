@@ -0,0 +1,224 @@
+/*                                                                 -*- C++ -*-
+ * File: clustering_tests.cpp
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Boost unit tests for k-means clustering
+ *
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <cmath>
+
+#include "LA/matrix.h"
+#include "ML/clustering.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+const unsigned NBLOBS = 3;
+const double blob_centers[NBLOBS][2] = { { 0, 0 }, { 20, 0 }, { 0, 20 } };
+
+/**
+ Examples of blob i are rows [i * size, (i + 1) * size).
+ Coordinates are multiples of 1/8, so that sums of coordinates
+ are exact in any order
+ */
+Matrix<double> blobs(unsigned size, unsigned seed)
+{
+	mt19937 gen(seed);
+	uniform_int_distribution<int> offset(-16, 16);
+
+	Matrix<double> x(NBLOBS * size, 2);
+	for (unsigned b = 0; b < NBLOBS; ++b)
+		for (unsigned i = 0; i < size; ++i)
+			for (unsigned d = 0; d < 2; ++d)
+				x[b * size + i][d] = blob_centers[b][d] + offset(gen) / 8.0;
+
+	return x;
+}
+
+// Blob means of x (as produced by blobs())
+Matrix<double> blob_means(const Matrix<double> & x)
+{
+	unsigned size = x.nrow() / NBLOBS;
+
+	Matrix<double> means(NBLOBS, 2, 0.0);
+	for (unsigned i = 0; i < x.nrow(); ++i)
+		for (unsigned d = 0; d < 2; ++d)
+			means[i / size][d] += x[i][d] / size;
+
+	return means;
+}
+
+// Each blob is one cluster, each center is close to the mean of its blob
+void require_blobs_recovered(const KMeans<double> & k_means, const Matrix<double> & x, double tolerance)
+{
+	unsigned size = x.nrow() / NBLOBS;
+	const vector<unsigned> & labels = k_means.get_labels();
+	Matrix<double> means = blob_means(x);
+
+	for (unsigned b = 0; b < NBLOBS; ++b)
+	{
+		unsigned label = labels[b * size];
+		for (unsigned i = b * size; i < (b + 1) * size; ++i)
+			BOOST_REQUIRE(labels[i] == label);
+
+		for (unsigned other = 0; other < b; ++other)
+			BOOST_REQUIRE(labels[other * size] != label);
+
+		const vector<double> & center = k_means.get_centers()[label];
+		BOOST_REQUIRE(fabs(center[0] - means[b][0]) < tolerance);
+		BOOST_REQUIRE(fabs(center[1] - means[b][1]) < tolerance);
+	}
+}
+
+void k_means_blobs_test()
+{
+	Matrix<double> x = blobs(100, 1);
+
+	for (unsigned seed = 1; seed <= 5; ++seed)
+	{
+		KMeans<double> k_means(NBLOBS, 300, 1e-4, 0, 1, seed);
+		k_means.fit(x);
+
+		require_blobs_recovered(k_means, x, 1e-12);
+		BOOST_REQUIRE(k_means.predict(vector<double>({ 19, 1 })) == k_means.get_labels()[100]);
+	}
+}
+
+void k_means_threads_test()
+{
+	Matrix<double> x = blobs(500, 2);
+
+	// Uniform noise and more clusters than blobs, so that
+	// the iterations take several steps
+	mt19937 gen(3);
+	uniform_int_distribution<int> coordinate(0, 160);
+	for (unsigned i = 0; i < 200; ++i)
+	{
+		vector<double> row = { coordinate(gen) / 8.0, coordinate(gen) / 8.0 };
+		x.push_back(row);
+	}
+
+	KMeans<double> single(5, 300, 1e-4, 0, 1, 7);
+	single.fit(x);
+	BOOST_REQUIRE(single.get_niter() > 1);
+
+	for (unsigned nthreads = 2; nthreads <= 8; nthreads *= 2)
+	{
+		KMeans<double> parallel(5, 300, 1e-4, 0, nthreads, 7);
+		parallel.fit(x);
+
+		BOOST_REQUIRE(parallel.get_niter() == single.get_niter());
+		BOOST_REQUIRE(parallel.get_labels() == single.get_labels());
+		BOOST_REQUIRE(parallel.get_centers() == single.get_centers());
+		BOOST_REQUIRE(parallel.get_inertia() == single.get_inertia());
+	}
+}
+
+void k_means_empty_cluster_test()
+{
+	// Only two distinct points: seeding has to choose a center twice, so
+	// the first assignment leaves a cluster without examples. Without
+	// reseeding its center would be 0 / 0
+	Matrix<double> x(6, 1, 0.0);
+	x[5][0] = 10;
+
+	for (unsigned seed = 1; seed <= 10; ++seed)
+	{
+		KMeans<double> k_means(3, 300, 1e-4, 0, 1, seed);
+		k_means.fit(x);
+
+		bool far = false;
+		for (unsigned c = 0; c < 3; ++c)
+		{
+			double center = k_means.get_centers()[c][0];
+			BOOST_REQUIRE(center == 0 || center == 10);
+			far = far || center == 10;
+		}
+
+		BOOST_REQUIRE(far);
+		BOOST_REQUIRE(k_means.get_inertia() == 0);
+	}
+
+	// Not enough examples
+	Matrix<double> few(4, 1, 1.0);
+	KMeans<double> k_means(5);
+	BOOST_REQUIRE_THROW(k_means.fit(few), exception);
+}
+
+void k_means_bounds_test()
+{
+	// Overlapping clusters in 4 dimensions, so that bounds prune only part
+	// of distance computations and labels change for many iterations
+	mt19937 gen(11);
+	normal_distribution<double> normal;
+
+	Matrix<double> x(2000, 4);
+	for (unsigned i = 0; i < x.nrow(); ++i)
+		for (unsigned d = 0; d < 4; ++d)
+			x[i][d] = normal(gen) + (i % 6) * (d % 2 ? 1.5 : -1.0);
+
+	for (unsigned nthreads = 1; nthreads <= 4; nthreads *= 4)
+	{
+		KMeans<double> lloyd(10, 300, 1e-8, 0, nthreads, 3);
+		lloyd.fit(x);
+		BOOST_REQUIRE(lloyd.get_niter() > 5);
+
+		KMeans<double>::Algorithm algorithms[2] = { KMeans<double>::ELKAN, KMeans<double>::HAMERLY };
+		for (auto algorithm : algorithms)
+		{
+			KMeans<double> bounded(10, 300, 1e-8, 0, nthreads, 3);
+			bounded.set_algorithm(algorithm);
+			bounded.fit(x);
+
+			BOOST_REQUIRE(bounded.get_niter() == lloyd.get_niter());
+			BOOST_REQUIRE(bounded.get_labels() == lloyd.get_labels());
+			for (unsigned c = 0; c < 10; ++c)
+				for (unsigned d = 0; d < 4; ++d)
+					BOOST_REQUIRE(fabs(bounded.get_centers()[c][d] - lloyd.get_centers()[c][d]) < 1e-12);
+			BOOST_REQUIRE(fabs(bounded.get_inertia() - lloyd.get_inertia()) < 1e-9 * lloyd.get_inertia());
+
+			// Bounds save distance computations
+			unsigned long long lloyd_evals = 0, bounded_evals = 0;
+			for (auto evals : lloyd.get_distance_evaluations())
+				lloyd_evals += evals;
+			for (auto evals : bounded.get_distance_evaluations())
+				bounded_evals += evals;
+			BOOST_REQUIRE(bounded_evals < lloyd_evals);
+		}
+	}
+}
+
+void k_means_mini_batch_test()
+{
+	Matrix<double> x = blobs(1000, 4);
+
+	for (unsigned seed = 1; seed <= 3; ++seed)
+	{
+		KMeans<double> k_means(NBLOBS, 500, 1e-6, 64, 1, seed);
+		k_means.fit(x);
+
+		// Centers are estimates from samples
+		require_blobs_recovered(k_means, x, 0.2);
+	}
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+	test_suite* test = BOOST_TEST_SUITE("Clustering test suite");
+
+	test->add(BOOST_TEST_CASE(&k_means_blobs_test));
+	test->add(BOOST_TEST_CASE(&k_means_threads_test));
+	test->add(BOOST_TEST_CASE(&k_means_empty_cluster_test));
+	test->add(BOOST_TEST_CASE(&k_means_bounds_test));
+	test->add(BOOST_TEST_CASE(&k_means_mini_batch_test));
+
+	return test;
+}
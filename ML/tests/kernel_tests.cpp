@@ -0,0 +1,232 @@
+/*                                                                 -*- C++ -*-
+ * File: kernel_tests.cpp
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Boost unit tests for kernel matrix, cache of kernel rows,
+ *   RBF features and RBF classifier
+ *
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <cmath>
+
+#include "LA/matrix.h"
+#include "ML/kernel.h"
+#include "ML/rbf.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+// Examples with about half of features zero (zeros are skipped by evaluation)
+Matrix<double> random_examples(unsigned n, unsigned dim, unsigned seed)
+{
+	mt19937 gen(seed);
+	uniform_real_distribution<double> value(-1, 1);
+
+	Matrix<double> x(n, dim);
+	for (auto & row : x)
+		for (auto & el : row)
+			el = gen() % 2 ? value(gen) : 0;
+
+	return x;
+}
+
+double l1_distance(const vector<double> & x, const vector<double> & y)
+{
+	double dist = 0;
+	for (unsigned d = 0; d < x.size(); ++d)
+		dist += fabs(x[d] - y[d]);
+
+	return dist;
+}
+
+// Kernel value computed directly from its definition
+double direct(const Kernel<double> & kernel, const vector<double> & x, const vector<double> & y)
+{
+	double xy = 0, dist = 0;
+	for (unsigned d = 0; d < x.size(); ++d)
+		xy += x[d] * y[d], dist += (x[d] - y[d]) * (x[d] - y[d]);
+
+	switch (kernel.type())
+	{
+	case Kernel<double>::LINEAR:
+		return xy;
+	case Kernel<double>::POLYNOMIAL:
+		return pow(0.5 * xy + 1, 3);
+	case Kernel<double>::RBF:
+		return exp(-0.7 * dist);
+	default:
+		return l1_distance(x, y);
+	}
+}
+
+void kernel_matrix_test()
+{
+	// More rows than a tile in both directions
+	Matrix<double> x = random_examples(300, 20, 1);
+
+	Kernel<double> kernels[4] = {
+		Kernel<double>::linear(),
+		Kernel<double>::polynomial(3, 0.5, 1),
+		Kernel<double>::rbf(0.7),
+		Kernel<double>::custom(&l1_distance)
+	};
+
+	for (const auto & kernel : kernels)
+		for (unsigned nthreads = 1; nthreads <= 4; nthreads += 3)
+		{
+			KernelMatrix<double> k(x, kernel, nthreads);
+			BOOST_REQUIRE(k.size() == x.nrow());
+
+			vector<double> row(x.nrow());
+			for (unsigned i = 0; i < x.nrow(); ++i)
+			{
+				k.row(i, row.data());
+				for (unsigned j = 0; j < x.nrow(); ++j)
+				{
+					double expected = direct(kernel, x[i], x[j]);
+					BOOST_REQUIRE(fabs(k(i, j) - expected) <= 1e-12 * max(1.0, fabs(expected)));
+					BOOST_REQUIRE(fabs(kernel(x[i], x[j]) - expected) <= 1e-12 * max(1.0, fabs(expected)));
+					BOOST_REQUIRE(row[j] == k(i, j));
+					BOOST_REQUIRE(k(i, j) == k(j, i));
+
+					if (j >= i)
+						BOOST_REQUIRE(k.upper(i)[j] == k(i, j));
+				}
+			}
+		}
+}
+
+void kernel_cache_test()
+{
+	Matrix<double> x = random_examples(50, 10, 2);
+	Kernel<double> kernel = Kernel<double>::rbf(0.3);
+	KernelMatrix<double> k(x, kernel, 1);
+
+	// Room for 3 rows
+	KernelCache<double> cache(x, kernel, 3 * 50 * sizeof(double) + 10);
+	BOOST_REQUIRE(cache.capacity() == 3);
+
+	// Row index and whether it is expected to be cached
+	const unsigned requests[][2] = {
+		{ 0, 0 }, { 1, 0 }, { 2, 0 },  // fill the cache
+		{ 0, 1 },                      // 1 becomes least recently used
+		{ 3, 0 },                      // evicts 1
+		{ 2, 1 }, { 0, 1 },
+		{ 1, 0 },                      // evicts 3
+		{ 3, 0 },                      // evicts 2
+		{ 0, 1 }, { 1, 1 }, { 3, 1 }
+	};
+
+	unsigned long long hits = 0, misses = 0;
+	for (const auto & request : requests)
+	{
+		unsigned i = request[0];
+		const double * row = cache.row(i);
+
+		request[1] ? ++hits : ++misses;
+		BOOST_REQUIRE(cache.hits() == hits && cache.misses() == misses);
+
+		for (unsigned j = 0; j < x.nrow(); ++j)
+			BOOST_REQUIRE(row[j] == k(i, j));
+		BOOST_REQUIRE(cache.diagonal(i) == k(i, i));
+	}
+
+	// At least two rows are kept, both returned rows stay valid
+	KernelCache<double> small(x, kernel, 1, 2);
+	BOOST_REQUIRE(small.capacity() == 2);
+
+	const double * first = small.row(5);
+	const double * second = small.row(7);
+	for (unsigned j = 0; j < x.nrow(); ++j)
+		BOOST_REQUIRE(first[j] == k(5, j) && second[j] == k(7, j));
+
+	small.row(9);
+	small.row(7);
+	BOOST_REQUIRE(small.hits() == 1 && small.misses() == 3);
+}
+
+void rbf_feature_map_test()
+{
+	// Several blocks of rows, and a partial last block
+	Matrix<double> x = random_examples(300, 20, 3);
+	Matrix<double> centers = random_examples(70, 20, 4);
+	RBFFeatureMap<double> features(centers, 0.7);
+	BOOST_REQUIRE(features.size() == 70);
+
+	Kernel<double> kernel = Kernel<double>::rbf(0.7);
+
+	for (unsigned offset = 0; offset <= 3; offset += 3)
+		for (unsigned nthreads = 1; nthreads <= 4; nthreads += 3)
+		{
+			Matrix<double> phi = features.transform(x, offset, nthreads);
+			BOOST_REQUIRE(phi.nrow() == 300 && phi.ncol() == offset + 70);
+
+			for (unsigned i = 0; i < x.nrow(); ++i)
+			{
+				vector<double> single = features.transform(x[i]);
+
+				for (unsigned j = 0; j < offset; ++j)
+					BOOST_REQUIRE(phi[i][j] == 0);
+
+				for (unsigned j = 0; j < centers.nrow(); ++j)
+				{
+					double expected = direct(kernel, x[i], centers[j]);
+					BOOST_REQUIRE(fabs(phi[i][offset + j] - expected) <= 1e-12);
+					BOOST_REQUIRE(fabs(single[j] - phi[i][offset + j]) <= 1e-12);
+				}
+			}
+		}
+
+	// Rows [begin, end) only, other columns are kept
+	Matrix<double> all = features.transform(x, 2);
+	Matrix<double> part(50, 75, -1.0);
+	features.transform(x, 100, 150, part, 2);
+	for (unsigned i = 0; i < 50; ++i)
+		for (unsigned j = 0; j < 75; ++j)
+		{
+			if (j < 2 || j >= 72)
+				BOOST_REQUIRE(part[i][j] == -1);
+			else
+				BOOST_REQUIRE(part[i][j] == all[100 + i][j]);
+		}
+}
+
+void rbf_classifier_test()
+{
+	// Several blocks of rows of batch prediction
+	Matrix<double> x = random_examples(700, 6, 5);
+	Matrix<double> y(x.nrow(), 1);
+	for (unsigned i = 0; i < x.nrow(); ++i)
+		y[i][0] = x[i][0] + x[i][1] > 0 ? 1 : -1;
+
+	for (unsigned nthreads = 1; nthreads <= 4; nthreads += 3)
+	{
+		RBF_Classifier<double> rbf(0.5, 12, nthreads);
+		rbf.train(x, y);
+
+		// Batch prediction is the same as one by one
+		Matrix<double> h = rbf.predict(x);
+		BOOST_REQUIRE(h.nrow() == x.nrow() && h.ncol() == 1);
+		for (unsigned i = 0; i < x.nrow(); ++i)
+			BOOST_REQUIRE(fabs(h[i][0] - rbf.predict(x[i])) <= 1e-12 * max(1.0, fabs(h[i][0])));
+	}
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+	test_suite* test = BOOST_TEST_SUITE("Kernel test suite");
+
+	test->add(BOOST_TEST_CASE(&kernel_matrix_test));
+	test->add(BOOST_TEST_CASE(&kernel_cache_test));
+	test->add(BOOST_TEST_CASE(&rbf_feature_map_test));
+	test->add(BOOST_TEST_CASE(&rbf_classifier_test));
+
+	return test;
+}
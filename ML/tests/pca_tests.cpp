@@ -0,0 +1,127 @@
+/*                                                                 -*- C++ -*-
+ * File: pca_tests.cpp
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Boost unit tests for principal component analysis
+ *
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+#include "LA/matrix.h"
+#include "ML/pca.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+/**
+ Points mean + a * u1 + b * u2 for (a, b) in (+-3, 0), (0, +-1),
+ u1 and u2 orthonormal: covariance is 4.5 u1 u1^t + 0.5 u2 u2^t
+ */
+Matrix<double> plane_points(vector<double> & u1, vector<double> & u2, vector<double> & mean)
+{
+	u1 = { 2.0 / 3, 2.0 / 3, 1.0 / 3 };
+	u2 = { 1.0 / sqrt(2.0), -1.0 / sqrt(2.0), 0 };
+	mean = { 1, -2, 5 };
+
+	const double a[4] = { 3, -3, 0, 0 };
+	const double b[4] = { 0, 0, 1, -1 };
+
+	Matrix<double> x(4, 3);
+	for (unsigned r = 0; r < 4; ++r)
+		for (unsigned c = 0; c < 3; ++c)
+			x[r][c] = mean[c] + a[r] * u1[c] + b[r] * u2[c];
+
+	return x;
+}
+
+void pca_known_covariance_test()
+{
+	vector<double> u1, u2, mean;
+	Matrix<double> x = plane_points(u1, u2, mean);
+
+	PCA<double> pca(2);
+	pca.fit(x);
+
+	BOOST_REQUIRE(pca.ncomponents() == 2);
+	for (unsigned c = 0; c < 3; ++c)
+		BOOST_REQUIRE(fabs(pca.get_mean()[c] - mean[c]) < 1e-12);
+
+	BOOST_REQUIRE(fabs(pca.get_explained_variance()[0] - 4.5) < 1e-6);
+	BOOST_REQUIRE(fabs(pca.get_explained_variance()[1] - 0.5) < 1e-6);
+
+	// Axes are u1 and u2 up to sign, and orthonormal
+	const Matrix<double> & axes = pca.get_components();
+	BOOST_REQUIRE(fabs(fabs(inner_product(axes[0], u1)) - 1) < 1e-6);
+	BOOST_REQUIRE(fabs(fabs(inner_product(axes[1], u2)) - 1) < 1e-6);
+	BOOST_REQUIRE(fabs(inner_product(axes[0], axes[0]) - 1) < 1e-6);
+	BOOST_REQUIRE(fabs(inner_product(axes[1], axes[1]) - 1) < 1e-6);
+	BOOST_REQUIRE(fabs(inner_product(axes[0], axes[1])) < 1e-6);
+
+	// Points lie in the plane of the axes: reconstruction is exact
+	Matrix<double> projected = pca.transform(x);
+	BOOST_REQUIRE(projected.nrow() == 4 && projected.ncol() == 2);
+	for (unsigned r = 0; r < 4; ++r)
+	{
+		BOOST_REQUIRE(projected[r] == pca.transform(x[r]));
+
+		for (unsigned c = 0; c < 3; ++c)
+		{
+			double reconstructed = mean[c] + projected[r][0] * axes[0][c] + projected[r][1] * axes[1][c];
+			BOOST_REQUIRE(fabs(reconstructed - x[r][c]) < 1e-5);
+		}
+	}
+}
+
+void pca_reconstruction_error_test()
+{
+	vector<double> u1, u2, mean;
+	Matrix<double> x = plane_points(u1, u2, mean);
+
+	PCA<double> pca(1);
+	pca.fit(x);
+
+	// Mean squared error of reconstruction from one axis is the dropped variance
+	Matrix<double> projected = pca.transform(x);
+	const vector<double> & axis = pca.get_components()[0];
+
+	double error = 0;
+	for (unsigned r = 0; r < x.nrow(); ++r)
+		for (unsigned c = 0; c < 3; ++c)
+		{
+			double d = mean[c] + projected[r][0] * axis[c] - x[r][c];
+			error += d * d;
+		}
+
+	BOOST_REQUIRE(fabs(error / x.nrow() - 0.5) < 1e-5);
+}
+
+void pca_errors_test()
+{
+	PCA<double> pca(4);
+
+	BOOST_REQUIRE_THROW(pca.fit(Matrix<double>()), exception);
+	BOOST_REQUIRE_THROW(pca.fit(Matrix<double>(5, 3, 1.0)), exception);
+
+	vector<double> u1, u2, mean;
+	PCA<double> fitted(2);
+	fitted.fit(plane_points(u1, u2, mean));
+	BOOST_REQUIRE_THROW(fitted.transform(vector<double>(4)), exception);
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+	test_suite* test = BOOST_TEST_SUITE("PCA test suite");
+
+	test->add(BOOST_TEST_CASE(&pca_known_covariance_test));
+	test->add(BOOST_TEST_CASE(&pca_reconstruction_error_test));
+	test->add(BOOST_TEST_CASE(&pca_errors_test));
+
+	return test;
+}
@@ -0,0 +1,114 @@
+/*                                                                 -*- C++ -*-
+ * File: smo_svm_tests.cpp
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Boost unit tests for SMO solver of C-SVC dual.
+ *   Expected alpha, rho and objective are solutions of the libsvm
+ *   solver (the copy bundled with scikit-learn, tolerance 1e-10)
+ *   for the same problems, parameters are given as svm-train options
+ *
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+#include "LA/matrix.h"
+#include "ML/smo_svm.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+const unsigned N = 16;
+
+const double points[N][2] = {
+	{ 0.5, 1.0 }, { 1.0, 2.0 }, { 1.5, 0.5 }, { 2.0, 1.5 }, { 2.5, 2.5 }, { 0.0, 2.5 }, { 1.0, 0.0 }, { 3.0, 1.0 },
+	{ 2.0, 3.0 }, { 3.0, 2.0 }, { 3.5, 3.5 }, { 2.5, 4.0 }, { 4.0, 2.5 }, { 1.5, 3.0 }, { 4.5, 4.0 }, { 3.0, 4.5 }
+};
+
+// Not linearly separable: points 3, 4, 7 and 13 are on the wrong side
+const signed labels[N] = { 1, 1, 1, 1, -1, 1, 1, -1, -1, -1, -1, -1, -1, 1, -1, -1 };
+
+Matrix<double> examples()
+{
+	Matrix<double> x(N, 2);
+	for (unsigned i = 0; i < N; ++i)
+		for (unsigned d = 0; d < 2; ++d)
+			x[i][d] = points[i][d];
+
+	return x;
+}
+
+// Solutions of libsvm
+struct Reference
+{
+	double alpha[N];
+	double rho;
+	double objective;
+};
+
+// svm-train -s 0 -t 2 -g 0.5 -c 2
+const Reference rbf_c_svc = {
+	{ 0, 0, 0, 2, 0.9201552876, 0.6877398691, 0.8923664208, 1.6396669899,
+	  2, 0, 0, 0, 0.0029886654, 2, 0.6481642007, 0.3691311463 },
+	0.1629275290,
+	-7.1163907573
+};
+
+// svm-train -s 0 -t 0 -c 1
+const Reference linear_c_svc = {
+	{ 0, 0, 0, 1, 0.6, 0, 0, 0.4, 1, 0, 0, 0, 0, 1, 0, 0 },
+	-3,
+	-3.2
+};
+
+void require_solution(const SMOSolver<double> & solver, const Reference & expected)
+{
+	for (unsigned i = 0; i < N; ++i)
+		BOOST_REQUIRE(fabs(solver.get_alpha()[i] - expected.alpha[i]) < 1e-6);
+
+	BOOST_REQUIRE(fabs(solver.get_rho() - expected.rho) < 1e-6);
+	BOOST_REQUIRE(fabs(solver.get_objective() - expected.objective) < 1e-8);
+}
+
+void smo_c_svc_test()
+{
+	Matrix<double> x = examples();
+	vector<signed> y(labels, labels + N);
+
+	for (unsigned shrinking = 0; shrinking < 2; ++shrinking)
+	{
+		SMOParameters param;
+		param.tolerance = 1e-10;
+		param.shrinking = shrinking != 0;
+
+		SMOSolver<double> rbf(param);
+		rbf.solve(x, y, Kernel<double>::rbf(0.5), 2);
+		require_solution(rbf, rbf_c_svc);
+
+		SMOSolver<double> linear(param);
+		linear.solve(x, y, Kernel<double>::linear(), 1);
+		require_solution(linear, linear_c_svc);
+	}
+
+	// Default tolerance of libsvm
+	SMOSolver<double> solver;
+	solver.solve(x, y, Kernel<double>::rbf(0.5), 2);
+	BOOST_REQUIRE(fabs(solver.get_objective() - rbf_c_svc.objective) < 1e-3);
+
+	BOOST_REQUIRE_THROW(solver.solve(x, vector<signed>(N, 0), Kernel<double>::linear(), 1), exception);
+	BOOST_REQUIRE_THROW(solver.solve(x, y, Kernel<double>::linear(), 0), exception);
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+	test_suite* test = BOOST_TEST_SUITE("SMO SVM test suite");
+
+	test->add(BOOST_TEST_CASE(&smo_c_svc_test));
+
+	return test;
+}
@@ -0,0 +1,247 @@
+/*                                                                 -*- C++ -*-
+ * File: svm_data_file_tests.cpp
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Boost unit tests for SVM data files: binary files and
+ *   parser of text files
+ *
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "LA/matrix.h"
+#include "ML/svm_data_file.h"
+#include "ML/svm_binary_file.h"
+#include "ML/svm_text_parser.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+const char * const FILE_NAME = "svm_data_file_test.bin";
+
+// Rows with zeros (skipped in file) and an empty row
+void sample(Matrix<double> & features, vector<double> & labels)
+{
+	features = Matrix<double>(4, 5, 0.0);
+	features[0][0] = 1.5;
+	features[0][3] = -2;
+	features[2][4] = 0.25;
+	features[3][1] = 3;
+	features[3][2] = 1e-300;
+	features[3][4] = -7;
+
+	labels = { 1, -1, 2, 1 };
+}
+
+string read_file(const string & file_name)
+{
+	ifstream in(file_name.c_str(), ios::binary);
+	return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+void write_file(const string & file_name, const string & data)
+{
+	ofstream out(file_name.c_str(), ios::binary);
+	out.write(data.data(), data.size());
+}
+
+template <class T>
+void patch(string & data, size_t offset, T value)
+{
+	memcpy(&data[offset], &value, sizeof(value));
+}
+
+void svm_binary_round_trip_test()
+{
+	Matrix<double> features;
+	vector<double> labels;
+	sample(features, labels);
+
+	write_SVM_data_file(FILE_NAME, features, labels, SVM_BINARY);
+	BOOST_REQUIRE(SVMBinaryFile::is_binary(FILE_NAME));
+
+	{
+		SVMBinaryFile file(FILE_NAME);
+		BOOST_REQUIRE(file.size() == 4);
+		BOOST_REQUIRE(file.max_index() == 5);
+
+		for (unsigned r = 0; r < 4; ++r)
+		{
+			BOOST_REQUIRE(file.labels()[r] == labels[r]);
+
+			const SVMBinaryFile::Entry * e = file.row(r);
+			for (unsigned c = 0; c < 5; ++c)
+				if (features[r][c] != 0)
+				{
+					BOOST_REQUIRE(e->index == static_cast<int>(c + 1));
+					BOOST_REQUIRE(e->value == features[r][c]);
+					++e;
+				}
+
+			BOOST_REQUIRE(e->index == -1);
+		}
+	}
+
+	remove(FILE_NAME);
+}
+
+void svm_binary_corrupt_test()
+{
+	Matrix<double> features;
+	vector<double> labels;
+	sample(features, labels);
+
+	write_SVM_data_file(FILE_NAME, features, labels, SVM_BINARY);
+	const string good = read_file(FILE_NAME);
+
+	// Layout of sample: header, 4 labels, 5 offsets (0, 3, 4, 6, 10), 10 entries
+	const size_t rows_at = offsetof(SVMBinaryHeader, rows);
+	const size_t entries_at = offsetof(SVMBinaryHeader, entries);
+	const size_t offsets_at = sizeof(SVMBinaryHeader) + 4 * sizeof(double);
+	const size_t entry_at = offsets_at + 5 * sizeof(uint64_t);
+
+	vector<string> corrupt;
+
+	// Truncated
+	corrupt.push_back(good.substr(0, sizeof(SVMBinaryHeader) - 1));
+	corrupt.push_back(good.substr(0, good.size() - 1));
+	corrupt.push_back(good.substr(0, entry_at));
+
+	// Sizes in header: n_entries * sizeof(Entry) wraps around to the actual size
+	string data = good;
+	patch<uint64_t>(data, entries_at, 10 + (uint64_t(1) << 60));
+	corrupt.push_back(data);
+
+	data = good;
+	patch<uint64_t>(data, rows_at, uint64_t(1) << 62);
+	corrupt.push_back(data);
+
+	// Offsets: not increasing, past entries
+	data = good;
+	patch<uint64_t>(data, offsets_at + 2 * sizeof(uint64_t), 3);
+	corrupt.push_back(data);
+
+	data = good;
+	patch<uint64_t>(data, offsets_at + 3 * sizeof(uint64_t), 11);
+	corrupt.push_back(data);
+
+	// Rows: missing terminator, indices not increasing, beyond max index, negative
+	data = good;
+	patch<int>(data, entry_at + 2 * sizeof(SVMBinaryEntry), 5);
+	corrupt.push_back(data);
+
+	data = good;
+	patch<int>(data, entry_at + sizeof(SVMBinaryEntry), 1);
+	corrupt.push_back(data);
+
+	data = good;
+	patch<int>(data, entry_at + sizeof(SVMBinaryEntry), 6);
+	corrupt.push_back(data);
+
+	data = good;
+	patch<int>(data, entry_at, -2);
+	corrupt.push_back(data);
+
+	for (const auto & bad : corrupt)
+	{
+		write_file(FILE_NAME, bad);
+
+		SVMBinaryFile file;
+		BOOST_REQUIRE_THROW(file.open(FILE_NAME), exception);
+		BOOST_REQUIRE(file.size() == 0);
+	}
+
+	// Unchanged data is still accepted
+	write_file(FILE_NAME, good);
+	SVMBinaryFile file(FILE_NAME);
+	BOOST_REQUIRE(file.size() == 4);
+	file.close();
+
+	remove(FILE_NAME);
+}
+
+// Parses text file into labels and nodes, returns max index
+int parse_text(const string & file_name, unsigned nthreads, vector<double> & labels, vector<SVMBinaryEntry> & nodes)
+{
+	SVMTextParser parser(file_name, nthreads);
+	labels.resize(parser.size());
+	nodes.resize(parser.num_entries());
+
+	vector<SVMBinaryEntry *> rows(parser.size());
+	return parser.parse(labels.data(), rows.data(), nodes.data());
+}
+
+void svm_text_parser_test()
+{
+	const char * const TEXT_FILE_NAME = "svm_data_file_test.txt";
+
+	Matrix<double> features;
+	vector<double> labels;
+	sample(features, labels);
+
+	write_SVM_data_file(TEXT_FILE_NAME, features, labels, SVM_TEXT);
+
+	for (unsigned nthreads = 1; nthreads <= 4; nthreads += 3)
+	{
+		vector<double> parsed;
+		vector<SVMBinaryEntry> nodes;
+		BOOST_REQUIRE(parse_text(TEXT_FILE_NAME, nthreads, parsed, nodes) == 5);
+		BOOST_REQUIRE(parsed == labels);
+
+		// Same rows as in binary file
+		unsigned k = 0;
+		for (unsigned r = 0; r < 4; ++r)
+		{
+			for (unsigned c = 0; c < 5; ++c)
+				if (features[r][c] != 0)
+				{
+					BOOST_REQUIRE(nodes[k].index == static_cast<int>(c + 1) && nodes[k].value == features[r][c]);
+					++k;
+				}
+
+			BOOST_REQUIRE(nodes[k++].index == -1);
+		}
+	}
+
+	// Feature values out of range of double are rejected, labels are not
+	vector<double> parsed;
+	vector<SVMBinaryEntry> nodes;
+
+	write_file(TEXT_FILE_NAME, "1 1:0.5\n1 1:1e400\n");
+	BOOST_REQUIRE_THROW(parse_text(TEXT_FILE_NAME, 1, parsed, nodes), exception);
+
+	write_file(TEXT_FILE_NAME, "1 1:1e-400\n");
+	BOOST_REQUIRE_THROW(parse_text(TEXT_FILE_NAME, 1, parsed, nodes), exception);
+
+	write_file(TEXT_FILE_NAME, "1e400 1:0.5 3:1e300\n");
+	BOOST_REQUIRE(parse_text(TEXT_FILE_NAME, 1, parsed, nodes) == 3);
+	BOOST_REQUIRE(parsed[0] == HUGE_VAL && nodes[1].value == 1e300);
+
+	// Indices are increasing
+	write_file(TEXT_FILE_NAME, "1 2:0.5 2:1\n");
+	BOOST_REQUIRE_THROW(parse_text(TEXT_FILE_NAME, 1, parsed, nodes), exception);
+
+	remove(TEXT_FILE_NAME);
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+	test_suite* test = BOOST_TEST_SUITE("SVM data file test suite");
+
+	test->add(BOOST_TEST_CASE(&svm_binary_round_trip_test));
+	test->add(BOOST_TEST_CASE(&svm_binary_corrupt_test));
+	test->add(BOOST_TEST_CASE(&svm_text_parser_test));
+
+	return test;
+}
@@ -0,0 +1,212 @@
+/*                                                                 -*- C++ -*-
+ * File: svm_predict_tests.cpp
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Boost unit tests for batch prediction of libsvm models
+ *
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdio>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ML/svm_predict.h"
+#include "libsvm-3.16/svm.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+const char * const MODEL_FILE_NAME = "svm_predict_test.model";
+
+const unsigned DIM = 4;
+
+// Three classes, RBF kernel, two support vectors of each class
+void write_model(bool probability)
+{
+	ofstream out(MODEL_FILE_NAME);
+	out << "svm_type c_svc\n"
+		<< "kernel_type rbf\n"
+		<< "gamma 0.5\n"
+		<< "nr_class 3\n"
+		<< "total_sv 6\n"
+		<< "rho 0.1 -0.2 0.3\n"
+		<< "label 1 2 3\n";
+
+	if (probability)
+		out << "probA -1.5 -2 -1.2\n"
+			<< "probB 0.1 -0.05 0.2\n";
+
+	out << "nr_sv 2 2 2\n"
+		<< "SV\n"
+		<< "1 0.5 1:1 2:0.5\n"
+		<< "0.7 1 1:0.8 3:-0.5\n"
+		<< "-1 0.4 2:1 4:0.3\n"
+		<< "-0.7 1 1:-0.2 2:0.9\n"
+		<< "-0.5 -1 3:1 4:-0.4\n"
+		<< "-1 -1 1:0.1 3:0.8 4:1\n";
+}
+
+// Dense examples, about half of features are zero
+vector<double> random_features(unsigned n, unsigned seed)
+{
+	mt19937 gen(seed);
+	uniform_real_distribution<double> value(-1, 1.5);
+
+	vector<double> features(n * DIM);
+	for (auto & f : features)
+		f = gen() % 2 ? value(gen) : 0;
+
+	return features;
+}
+
+// Sparse rows of dense features: feature c gets index c + 1
+vector<vector<svm_node> > sparse_rows(unsigned n, const vector<double> & features)
+{
+	vector<vector<svm_node> > rows(n);
+	for (unsigned r = 0; r < n; ++r)
+	{
+		for (unsigned c = 0; c < DIM; ++c)
+			if (features[r * DIM + c] != 0)
+			{
+				svm_node node = { static_cast<int>(c + 1), features[r * DIM + c] };
+				rows[r].push_back(node);
+			}
+
+		svm_node terminator = { -1, 0 };
+		rows[r].push_back(terminator);
+	}
+
+	return rows;
+}
+
+void svm_batch_predict_test()
+{
+	const unsigned n = 500;
+
+	vector<double> features = random_features(n, 1);
+	vector<vector<svm_node> > rows = sparse_rows(n, features);
+	vector<const svm_node *> row_ptrs(n);
+	for (unsigned r = 0; r < n; ++r)
+		row_ptrs[r] = rows[r].data();
+
+	for (unsigned probability = 0; probability < 2; ++probability)
+	{
+		write_model(probability != 0);
+		SV::SVM_Predict predictor(MODEL_FILE_NAME, probability != 0);
+
+		unsigned nr_class = predictor.num_classes();
+		unsigned nr_dec = predictor.num_decision_values();
+		BOOST_REQUIRE(nr_class == 3 && nr_dec == 3);
+
+		// Per-row results
+		vector<double> labels(n), decision_values(n * nr_dec), probabilities(n * nr_class);
+		for (unsigned r = 0; r < n; ++r)
+		{
+			labels[r] = predictor.predict(row_ptrs[r], &probabilities[r * nr_class]);
+			svm_predict_values(predictor.get_model(), row_ptrs[r], &decision_values[r * nr_dec]);
+		}
+
+		for (unsigned nthreads = 1; nthreads <= 4; nthreads += 3)
+		{
+			vector<double> batch_labels(n), batch_decision_values(n * nr_dec), batch_probabilities(n * nr_class);
+			double * probabilities_out = probability ? batch_probabilities.data() : NULL;
+
+			predictor.predict(n, row_ptrs.data(), batch_labels.data(), batch_decision_values.data(), probabilities_out, nthreads);
+			BOOST_REQUIRE(batch_labels == labels);
+			BOOST_REQUIRE(batch_decision_values == decision_values);
+			if (probability)
+				for (unsigned k = 0; k < n * nr_class; ++k)
+					BOOST_REQUIRE(fabs(batch_probabilities[k] - probabilities[k]) < 1e-12);
+
+			// Labels only, and dense rows
+			vector<double> labels_only(n), dense_labels(n), dense_decision_values(n * nr_dec);
+			predictor.predict(n, row_ptrs.data(), labels_only.data(), NULL, NULL, nthreads);
+			predictor.predict(n, DIM, features.data(), dense_labels.data(), dense_decision_values.data(), NULL, nthreads);
+			BOOST_REQUIRE(labels_only == labels);
+			BOOST_REQUIRE(dense_labels == labels);
+			BOOST_REQUIRE(dense_decision_values == decision_values);
+		}
+
+		if (!probability)
+		{
+			vector<double> batch_probabilities(n * nr_class);
+			BOOST_REQUIRE_THROW(predictor.predict(n, row_ptrs.data(), NULL, NULL, batch_probabilities.data()), exception);
+		}
+	}
+
+	remove(MODEL_FILE_NAME);
+}
+
+string read_output(FILE * f)
+{
+	string out;
+	rewind(f);
+	for (int ch; (ch = fgetc(f)) != EOF; )
+		out += static_cast<char>(ch);
+
+	return out;
+}
+
+void svm_file_predict_test()
+{
+	const char * const DATA_FILE_NAME = "svm_predict_test.txt";
+	const unsigned n = 300;
+
+	vector<double> features = random_features(n, 2);
+	{
+		ofstream data(DATA_FILE_NAME);
+		for (unsigned r = 0; r < n; ++r)
+		{
+			data << 1 + r % 3;
+			for (unsigned c = 0; c < DIM; ++c)
+				if (features[r * DIM + c] != 0)
+					data << ' ' << c + 1 << ':' << features[r * DIM + c];
+			data << '\n';
+		}
+	}
+
+	write_model(true);
+	SV::SVM_Predict predictor(MODEL_FILE_NAME, true);
+
+	// Header, then label and probabilities of each row
+	FILE * single = tmpfile();
+	predictor.predict(DATA_FILE_NAME, single, 1);
+	string expected = read_output(single);
+	fclose(single);
+
+	unsigned lines = 0;
+	for (char ch : expected)
+		lines += ch == '\n';
+	BOOST_REQUIRE(lines == n + 1);
+
+	// Rows are predicted by several threads, written in order
+	for (unsigned nthreads = 2; nthreads <= 8; nthreads *= 2)
+	{
+		FILE * parallel = tmpfile();
+		predictor.predict(DATA_FILE_NAME, parallel, nthreads);
+		BOOST_REQUIRE(read_output(parallel) == expected);
+		fclose(parallel);
+	}
+
+	remove(DATA_FILE_NAME);
+	remove(MODEL_FILE_NAME);
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+	test_suite* test = BOOST_TEST_SUITE("SVM predict test suite");
+
+	test->add(BOOST_TEST_CASE(&svm_batch_predict_test));
+	test->add(BOOST_TEST_CASE(&svm_file_predict_test));
+
+	return test;
+}
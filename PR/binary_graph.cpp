@@ -4,9 +4,39 @@
 #include <exception>
 #include <algorithm>
 #include <iostream>
+#include <cstring>
 
 using namespace std;
 
+namespace {
+
+// Endpoints (src, dest) of 20 circle edges: neighbour codes, 8 for the node itself
+const unsigned CIRCLE20[20][2] = {
+	{ 0, 8 }, { 8, 1 }, { 8, 2 }, { 8, 3 }, { 8, 4 }, { 5, 8 }, { 6, 8 }, { 7, 8 },
+	{ 0, 1 }, { 1, 2 }, { 2, 3 }, { 4, 3 }, { 5, 4 }, { 6, 5 }, { 7, 6 }, { 7, 0 },
+	{ 0, 2 }, { 4, 2 }, { 6, 4 }, { 6, 0 }
+};
+
+// Position (3 * (di + 1) + dj + 1) of neighbour code in 3x3 block
+const unsigned BLOCK_POS[9] = { 3, 6, 7, 8, 5, 2, 1, 0, 4 };
+
+// Circle edge index by positions of src and dest in 3x3 block (-1 if none)
+struct Circle20Table
+{
+	signed char edge[9][9];
+
+	Circle20Table()
+	{
+		memset(edge, -1, sizeof(edge));
+		for (unsigned k = 0; k < 20; ++k)
+			edge[BLOCK_POS[CIRCLE20[k][0]]][BLOCK_POS[CIRCLE20[k][1]]] = static_cast<signed char>(k);
+	}
+};
+
+const Circle20Table circle20_table;
+
+} // namespace
+
 /*****************************************************************
 *
 * Node
@@ -125,6 +155,26 @@ Nodes Nodes::getNeighbours(const Node & node) const
 	return result;
 }
 
+unsigned Nodes::getNeighboursMask(const Node & node) const
+{
+	unsigned mask = 0;
+
+	// Neighbours are searched row by row
+	for (signed i = node.i() - 1; i <= node.i() + 1; ++i)
+	{
+		Node last(i, node.j() + 1);
+		for (const_iterator it = std::lower_bound(begin(), end(), Node(i, node.j() - 1)); 
+			it != end() && *it <= last; ++it)
+		{
+			signed code = node.getAdjacentCode(*it);
+			if (code != -1)
+				mask |= 1u << code;
+		}
+	}
+
+	return mask;
+}
+
 Nodes & Nodes::remove(const vector<Node> & ns)
 {
 	// cerr << "Removing nodes: " << ns << endl;
@@ -327,45 +377,44 @@ Edges Edges::get20CircleEdges(const Node & node) const
 {
 	Edges result(20);
 
-	Nodes adjacent(8);
-	for (unsigned i = 0; i < 8; ++i)
-		adjacent[i] = node.adjacent(i);
+	unsigned mask = get20CircleMask(node);
+	for (unsigned k = 0; k < 20; ++k)
+		if (mask & (1u << k))
+			result[k] = get20CircleEdge(node, k);
 
-	for (const_iterator it = begin(), itEnd = end(); it != itEnd; ++it)
-	{
-		const Edge & e = *it;
+	return result;
+}
 
-		if (e.src() == node)
-			result[node.getAdjacentCode(e.dest())] = e;
-		else if (e.dest() == node)
-			result[node.getAdjacentCode(e.src())] = e;
-		else if (e.src() == adjacent[0] && e.dest() == adjacent[1])
-			result[8] = e;
-		else if (e.src() == adjacent[1] && e.dest() == adjacent[2])
-			result[9] = e;
-		else if (e.src() == adjacent[2] && e.dest() == adjacent[3])
-			result[10] = e;
-		else if (e.src() == adjacent[4] && e.dest() == adjacent[3])
-			result[11] = e;
-		else if (e.src() == adjacent[5] && e.dest() == adjacent[4])
-			result[12] = e;
-		else if (e.src() == adjacent[6] && e.dest() == adjacent[5])
-			result[13] = e;
-		else if (e.src() == adjacent[7] && e.dest() == adjacent[6])
-			result[14] = e;
-		else if (e.src() == adjacent[7] && e.dest() == adjacent[0])
-			result[15] = e;
-		else if (e.src() == adjacent[0] && e.dest() == adjacent[2])
-			result[16] = e;
-		else if (e.src() == adjacent[4] && e.dest() == adjacent[2])
-			result[17] = e;
-		else if (e.src() == adjacent[6] && e.dest() == adjacent[6])
-			result[18] = e;
-		else if (e.src() == adjacent[6] && e.dest() == adjacent[0])
-			result[19] = e;
+unsigned Edges::get20CircleMask(const Node & node) const
+{
+	unsigned mask = 0;
+
+	// Sources of all 20 edges are in 3x3 block around the node, 
+	// so only edges originating there are classified (row by row)
+	for (signed i = node.i() - 1; i <= node.i() + 1; ++i)
+	{
+		Node last(i, node.j() + 1);
+		for (const_iterator it = std::lower_bound(begin(), end(), Edge(Node(i, node.j() - 1), Node())); 
+			it != end() && it->src() <= last; ++it)
+		{
+			signed di = it->dest().i() - node.i(), dj = it->dest().j() - node.j();
+			if (di < -1 || di > 1 || dj < -1 || dj > 1)
+				continue;
+
+			unsigned src_pos = 3 * (it->src().i() - node.i() + 1) + it->src().j() - node.j() + 1;
+			signed k = circle20_table.edge[src_pos][3 * (di + 1) + dj + 1];
+			if (k != -1)
+				mask |= 1u << k;
+		}
 	}
 
-	return result;
+	return mask;
+}
+
+Edge Edges::get20CircleEdge(const Node & node, unsigned k)
+{
+	unsigned src = CIRCLE20[k][0], dest = CIRCLE20[k][1];
+	return Edge(src == 8 ? node : node.adjacent(src), dest == 8 ? node : node.adjacent(dest));
 }
 
 Edges & Edges::remove(const vector<Edge> & es)
@@ -61,8 +61,8 @@ struct Nodes : public std::vector<Node>
 	template <class T>
 	Nodes(const Matrix<T> & img)
 	{
-		for (signed i = 0; i < (signed)img.row; ++i)
-			for (signed j = 0; j < (signed)img.col; ++j)
+		for (signed i = 0; i < (signed)img.nrow(); ++i)
+			for (signed j = 0; j < (signed)img.ncol(); ++j)
 				if (img[i][j])
 					push_back(Node(i, j));
 
@@ -74,6 +74,9 @@ struct Nodes : public std::vector<Node>
 	// then such nodes will be returned as deleted) 
 	Nodes getNeighbours(const Node & node) const;
 
+	// Bit k is set if neighbour k exists in the graph
+	unsigned getNeighboursMask(const Node & node) const;
+
 	// Batch remove
 	Nodes & remove(const vector<Node> &ns);
 
@@ -95,6 +98,12 @@ struct Edges : public std::vector<Edge>
 	Edges get16CircleEdges(const Node & node) const;
 	Edges get20CircleEdges(const Node & node) const;
 
+	// Bit k is set if edge k of get20CircleEdges() exists
+	unsigned get20CircleMask(const Node & node) const;
+
+	// Edge k of get20CircleEdges() (whether it exists or not)
+	static Edge get20CircleEdge(const Node & node, unsigned k);
+
 	// Batch remove
 	Edges & remove(const vector<Edge> & es);
 	bool isRemoved(const Edge & e);
@@ -115,26 +124,26 @@ Edges::Edges(const Matrix<T> & img)
 	// Each two adjacent nodes are connected only by a single one-directional edge
 
 	// Add all horizontal edges (direction left->right)
-	for (signed i = 0; i < (signed)img.row; ++i)
-		for (signed j = 0; j < (signed)img.col - 1; ++j)
+	for (signed i = 0; i < (signed)img.nrow(); ++i)
+		for (signed j = 0; j < (signed)img.ncol() - 1; ++j)
 			if (img[i][j] && img[i][j + 1])
 				push_back(Edge(Node(i, j), Node(i, j + 1)));
 
 	// Add all vertical edges (direction up->down)
-	for (signed j = 0; j < (signed)img.col; ++j)
-		for (signed i = 0; i < (signed)img.row - 1; ++i)
+	for (signed j = 0; j < (signed)img.ncol(); ++j)
+		for (signed i = 0; i < (signed)img.nrow() - 1; ++i)
 			if (img[i][j] && img[i + 1][j])
 				push_back(Edge(Node(i, j), Node(i + 1, j)));
 
 	// Add all left diagonal edges (direction [up, left]->[down,right])
-	for (signed i = 0; i < (signed)img.row - 1; ++i)
-		for (signed j = 0; j < (signed)img.col - 1; ++j)
+	for (signed i = 0; i < (signed)img.nrow() - 1; ++i)
+		for (signed j = 0; j < (signed)img.ncol() - 1; ++j)
 			if (img[i][j] && img[i + 1][j + 1])
 				push_back(Edge(Node(i, j), Node(i + 1, j + 1)));
 
 	// Add all right diagonal edges (direction [up, right]->[down,left])
-	for (signed i = 1; i < (signed)img.row; ++i)
-		for (signed j = 1; j < (signed)img.col; ++j)
+	for (signed i = 1; i < (signed)img.nrow(); ++i)
+		for (signed j = 1; j < (signed)img.ncol(); ++j)
 			if (img[i][j] && img[i + 1][j - 1])
 				push_back(Edge(Node(i, j), Node(i + 1, j - 1)));
 
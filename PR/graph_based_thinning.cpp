@@ -1,9 +1,102 @@
-# include "PR\graph_based_thinning.h"
+# include "PR/graph_based_thinning.h"
 
 #include <iostream>
 
 using namespace std;
 
+namespace {
+
+/************************************************************
+* Rules of delete_intersections() are matched against mask
+* of node: bits 0-19 are edges of get20CircleEdges(), bits
+* 20-27 are neighbours. Rule matches if (mask & care) == value
+* and then replaces edge remove by circle edges add (if any)
+************************************************************/
+struct IntersectionRule
+{
+	unsigned care;
+	unsigned value;
+	unsigned remove;
+	signed add[2];
+};
+
+constexpr unsigned edge_bit(unsigned k) { return 1u << k; }
+constexpr unsigned node_bit(unsigned k) { return 1u << (20 + k); }
+
+// Diagonal edges 16-19: each rule requires one of them
+const unsigned DIAGONAL_EDGES = edge_bit(16) | edge_bit(17) | edge_bit(18) | edge_bit(19);
+
+// Rule for intersection (e[1], e[16]), other intersections are its rotations
+struct BaseIntersectionRule
+{
+	unsigned required;
+	unsigned absent;
+	unsigned remove;
+	signed add[2];
+};
+
+// Rules S1-S5
+const BaseIntersectionRule BASE_INTERSECTION_RULES[5] = {
+	{ edge_bit(1) | edge_bit(16), edge_bit(0) | edge_bit(2) | edge_bit(8) | edge_bit(9), 16, { 8, 9 } },
+	{ edge_bit(1) | edge_bit(2) | edge_bit(16), edge_bit(0) | edge_bit(8) | edge_bit(9), 1, { 9, -1 } },
+	{ edge_bit(1) | edge_bit(8) | edge_bit(16), edge_bit(0) | edge_bit(2) | edge_bit(9), 16, { 9, -1 } },
+	{ edge_bit(1) | edge_bit(9) | edge_bit(16), edge_bit(0) | edge_bit(2) | edge_bit(8), 16, { 8, -1 } },
+	{ edge_bit(0) | edge_bit(1) | edge_bit(16), edge_bit(2) | edge_bit(8) | edge_bit(9), 1, { 8, -1 } }
+};
+
+// Circle edge k rotated by r quarter turns (neighbour codes shift by 2r)
+unsigned rotate_edge(unsigned k, unsigned r)
+{
+	if (k < 8)
+		return (k + 2 * r) % 8;
+	if (k < 16)
+		return 8 + (k - 8 + 2 * r) % 8;
+	return 16 + (k - 16 + r) % 4;
+}
+
+unsigned rotate_edges(unsigned edges, unsigned r)
+{
+	unsigned rotated = 0;
+	for (unsigned k = 0; k < 20; ++k)
+		if (edges & edge_bit(k))
+			rotated |= edge_bit(rotate_edge(k, r));
+	return rotated;
+}
+
+// S1-S5 for intersections (e[1], e[16]), (e[3], e[17]), (e[5], e[18]), (e[7], e[19])
+vector<IntersectionRule> compile_intersection_rules()
+{
+	vector<IntersectionRule> rules;
+	for (unsigned r = 0; r < 4; ++r)
+	{
+		// Neighbours 2r, 2r + 1, 2r + 2 must exist
+		unsigned nodes = node_bit(2 * r) | node_bit(2 * r + 1) | node_bit((2 * r + 2) % 8);
+
+		for (const BaseIntersectionRule & base : BASE_INTERSECTION_RULES)
+		{
+			unsigned required = rotate_edges(base.required, r) | nodes;
+			unsigned absent = rotate_edges(base.absent, r);
+
+			IntersectionRule rule = { required | absent, required, rotate_edge(base.remove, r), { -1, -1 } };
+			for (unsigned a = 0; a < 2; ++a)
+				if (base.add[a] != -1)
+					rule.add[a] = rotate_edge(base.add[a], r);
+
+			rules.push_back(rule);
+		}
+	}
+
+	return rules;
+}
+
+const vector<IntersectionRule> & intersection_rules()
+{
+	static const vector<IntersectionRule> rules = compile_intersection_rules();
+	return rules;
+}
+
+} // namespace
+
 void delete_diag_at_concaves(const Nodes & nodes, Edges & edges)
 {
 	vector<Edge> to_remove;
@@ -244,194 +337,28 @@ void delete_extra_vert_and_hor_edges(const Nodes & nodes, Edges & edges)
 
 bool delete_intersections(const Nodes & nodes, Edges & edges)
 {
+	const vector<IntersectionRule> & rules = intersection_rules();
+
 	vector<Edge> to_add;
 	vector<Edge> to_remove;
 
 	for (Nodes::const_iterator it = nodes.begin(), itEnd = nodes.end(); it != itEnd; ++it)
 	{
 		const Node & curr = *it;
-		Nodes n = nodes.getNeighbours(curr);
-		Edges e = edges.get20CircleEdges(curr);
 
-		// Intersection (e[1], e[16])
-		if (n[0].exist() && n[1].exist() && n[2].exist())
-		{
-			// Rule S1
-			if (e[1].exist() && e[16].exist())
-				if (!e[0].exist() && !e[2].exist() && !e[8].exist() && !e[9].exist())
-				{
-					to_remove.push_back(e[16]);
-					to_add.push_back(Edge(n[0], n[1]));
-					to_add.push_back(Edge(n[1], n[2]));
-				}
-
-			// Rule S2
-			if (e[1].exist() && e[2].exist() && e[16].exist())
-				if (!e[0].exist() && !e[8].exist() && !e[9].exist())
-				{
-					to_remove.push_back(e[1]);
-					to_add.push_back(Edge(n[1], n[2]));
-				}
-
-			// Rule S3
-			if (e[1].exist() && e[8].exist() && e[16].exist())
-				if (!e[0].exist() && !e[2].exist() && !e[9].exist())
-				{
-					to_remove.push_back(e[16]);
-					to_add.push_back(Edge(n[1], n[2]));
-				}
-
-			// Rule S4
-			if (e[1].exist() && e[9].exist() && e[16].exist())
-				if (!e[0].exist() && !e[2].exist() && !e[8].exist())
-				{
-					to_remove.push_back(e[16]);
-					to_add.push_back(Edge(n[0], n[1]));
-				}
-
-			// Rule S5
-			if (e[0].exist() && e[1].exist() && e[16].exist())
-				if (!e[2].exist() && !e[8].exist() && !e[9].exist())
-				{
-					to_remove.push_back(e[1]);
-					to_add.push_back(Edge(n[0], n[1]));
-				}
-		}
-
-		// Intersection (e[3], e[17])
-		if (n[2].exist() && n[3].exist() && n[4].exist())
-		{
-			// Rule S1
-			if (e[3].exist() && e[17].exist())
-				if (!e[2].exist() && !e[4].exist() && !e[10].exist() && !e[11].exist())
-				{
-					to_remove.push_back(e[17]);
-					to_add.push_back(Edge(n[2], n[3]));
-					to_add.push_back(Edge(n[4], n[3]));
-				}
-
-			// Rule S2
-			if (e[3].exist() && e[4].exist() && e[17].exist())
-				if (!e[2].exist() && !e[10].exist() && !e[11].exist())
-				{
-					to_remove.push_back(e[3]);
-					to_add.push_back(Edge(n[4], n[3]));
-				}
-
-			// Rule S3
-			if (e[3].exist() && e[10].exist() && e[17].exist())
-				if (!e[2].exist() && !e[4].exist() && !e[11].exist())
-				{
-					to_remove.push_back(e[17]);
-					to_add.push_back(Edge(n[4], n[3]));
-				}
-
-			// Rule S4
-			if (e[3].exist() && e[11].exist() && e[17].exist())
-				if (!e[2].exist() && !e[4].exist() && !e[10].exist())
-				{
-					to_remove.push_back(e[17]);
-					to_add.push_back(Edge(n[2], n[3]));
-				}
-
-			// Rule S5
-			if (e[2].exist() && e[3].exist() && e[17].exist())
-				if (!e[4].exist() && !e[10].exist() && !e[11].exist())
-				{
-					to_remove.push_back(e[3]);
-					to_add.push_back(Edge(n[2], n[3]));
-				}
-		}
-
-		// Intersection (e[5], e[18])
-		if (n[4].exist() && n[5].exist() && n[6].exist())
-		{
-			// Rule S1
-			if (e[5].exist() && e[18].exist())
-				if (!e[4].exist() && !e[6].exist() && !e[12].exist() && !e[13].exist())
-				{
-					to_remove.push_back(e[18]);
-					to_add.push_back(Edge(n[5], n[4]));
-					to_add.push_back(Edge(n[6], n[5]));
-				}
-
-			// Rule S2
-			if (e[5].exist() && e[6].exist() && e[18].exist())
-				if (!e[4].exist() && !e[12].exist() && !e[13].exist())
-				{
-					to_remove.push_back(e[5]);
-					to_add.push_back(Edge(n[6], n[5]));
-				}
-
-			// Rule S3
-			if (e[5].exist() && e[12].exist() && e[18].exist())
-				if (!e[4].exist() && !e[6].exist() && !e[13].exist())
-				{
-					to_remove.push_back(e[18]);
-					to_add.push_back(Edge(n[6], n[5]));
-				}
-
-			// Rule S4
-			if (e[5].exist() && e[14].exist() && e[18].exist())
-				if (!e[4].exist() && !e[6].exist() && !e[12].exist())
-				{
-					to_remove.push_back(e[18]);
-					to_add.push_back(Edge(n[5], n[4]));
-				}
-
-			// Rule S5
-			if (e[4].exist() && e[5].exist() && e[18].exist())
-				if (!e[6].exist() && !e[12].exist() && !e[13].exist())
-				{
-					to_remove.push_back(e[5]);
-					to_add.push_back(Edge(n[5], n[4]));
-				}
-		}
-
-		// Intersection (e[7], e[19])
-		if (n[6].exist() && n[7].exist() && n[0].exist())
-		{
-			// Rule S1
-			if (e[7].exist() && e[19].exist())
-				if (!e[6].exist() && !e[0].exist() && !e[14].exist() && !e[15].exist())
-				{
-					to_remove.push_back(e[19]);
-					to_add.push_back(Edge(n[7], n[6]));
-					to_add.push_back(Edge(n[7], n[0]));
-				}
-
-			// Rule S2
-			if (e[7].exist() && e[0].exist() && e[19].exist())
-				if (!e[6].exist() && !e[14].exist() && !e[15].exist())
-				{
-					to_remove.push_back(e[7]);
-					to_add.push_back(Edge(n[7], n[0]));
-				}
-
-			// Rule S3
-			if (e[7].exist() && e[14].exist() && e[19].exist())
-				if (!e[6].exist() && !e[0].exist() && !e[15].exist())
-				{
-					to_remove.push_back(e[18]);
-					to_add.push_back(Edge(n[7], n[0]));
-				}
-
-			// Rule S4
-			if (e[7].exist() && e[8].exist() && e[19].exist())
-				if (!e[6].exist() && !e[0].exist() && !e[14].exist())
-				{
-					to_remove.push_back(e[19]);
-					to_add.push_back(Edge(n[7], n[6]));
-				}
-
-			// Rule S5
-			if (e[6].exist() && e[7].exist() && e[19].exist())
-				if (!e[8].exist() && !e[14].exist() && !e[15].exist())
-				{
-					to_remove.push_back(e[7]);
-					to_add.push_back(Edge(n[7], n[6]));
-				}
-		}
+		unsigned mask = edges.get20CircleMask(curr);
+		if (!(mask & DIAGONAL_EDGES))
+			continue;
+		mask |= nodes.getNeighboursMask(curr) << 20;
+
+		for (const IntersectionRule & rule : rules)
+			if ((mask & rule.care) == rule.value)
+			{
+				to_remove.push_back(Edges::get20CircleEdge(curr, rule.remove));
+				for (unsigned a = 0; a < 2; ++a)
+					if (rule.add[a] != -1)
+						to_add.push_back(Edges::get20CircleEdge(curr, rule.add[a]));
+			}
 	}
 
 	make_vector_set(to_remove);
@@ -439,4 +366,4 @@ bool delete_intersections(const Nodes & nodes, Edges & edges)
 	edges.add(to_add);
 
 	return to_remove.size() > 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,238 @@
+/*                                                                 -*- C++ -*-
+ * File: moment_invariants.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Rotation invariant moments of binary images: Hu's seven
+ *   invariants and magnitudes of Zernike moments
+ *
+ */
+
+#ifndef _MOMENT_INVARIANTS_H_
+#define _MOMENT_INVARIANTS_H_
+
+#include <cmath>
+#include <vector>
+#include <utility>
+
+#include "LA/arena.h"
+#include "PR/moments.h"
+
+using namespace std;
+
+/************************************************************
+* Hu's invariants of normalized central moments
+* eta(p, q) = mu(p, q) / mu(0, 0) ^ (1 + (p + q) / 2),
+* invariant to translation, scale and rotation.
+* All zeros for an empty image
+************************************************************/
+template <class Feature>
+void hu_invariants(const Moments & m, Feature * hu);
+
+/************************************************************
+* Zernike moments A(n, m), 0 <= m <= n <= order, n - m even,
+* of image mapped to the unit disk: pixel centres are scaled
+* about the image centre so that the corners lie on the circle.
+* Values of the basis (n + 1) / pi * conj(V(n, m)) (with the
+* pixel area) at each pixel depend only on the image size, so
+* they are kept in the table, pixel by pixel, and the moments
+* are sums of the table rows of black pixels.
+* Magnitudes |A(n, m)| are invariant to rotation about the
+* image centre (images are expected to be centred and size
+* normalized)
+************************************************************/
+class ZernikeTable
+{
+public:
+
+	ZernikeTable() : rows(0), cols(0), max_order(0) {}
+	ZernikeTable(unsigned nrow, unsigned ncol, unsigned order) { build(nrow, ncol, order); }
+
+	void build(unsigned nrow, unsigned ncol, unsigned order);
+
+	unsigned nrow() const { return rows; }
+	unsigned ncol() const { return cols; }
+	unsigned order() const { return max_order; }
+
+	// Number of moments (n, m) in order of n, then m
+	unsigned size() const { return nm.size(); }
+
+	// n and m of moment k
+	unsigned n(unsigned k) const { return nm[k].first; }
+	unsigned m(unsigned k) const { return nm[k].second; }
+
+	// Writes |A(n, m)| to magnitudes[0, size()). img is nrow() * ncol()
+	template <class Image, class Feature>
+	void magnitudes(const Image & img, Feature * magnitudes) const;
+
+	// Table of the calling thread for images nrow * ncol, rebuilt when the
+	// size or order change
+	static const ZernikeTable & local(unsigned nrow, unsigned ncol, unsigned order);
+
+private:
+
+	// Coefficients of radial polynomial R(n, m)(rho) = sum of c[s] * rho ^ (n - 2s)
+	static vector<double> radial_coefficients(unsigned n, unsigned m);
+
+	unsigned rows, cols, max_order;
+	vector<pair<unsigned, unsigned> > nm;
+
+	// Row of pixel (r, c) starts at basis[(r * cols + c) * 2 * size()]:
+	// real and imaginary parts of each moment
+	vector<double> basis;
+};
+
+/******************************************************************************
+*
+* IMPLEMENTATIONS
+*
+*******************************************************************************/
+
+template <class Feature>
+void hu_invariants(const Moments & m, Feature * hu)
+{
+	for (unsigned k = 0; k < 7; ++k)
+		hu[k] = 0;
+
+	if (!m.count())
+		return;
+
+	double xc = m.x_center(), yc = m.y_center();
+	double mu00 = static_cast<double>(m.count());
+
+	double eta[Moments::MAX_ORDER + 1][Moments::MAX_ORDER + 1];
+	for (unsigned p = 0; p <= Moments::MAX_ORDER; ++p)
+		for (unsigned q = 0; p + q <= Moments::MAX_ORDER; ++q)
+			eta[p][q] = m.central(p, q, xc, yc) / pow(mu00, 1.0 + (p + q) / 2.0);
+
+	double a = eta[3][0] - 3 * eta[1][2];
+	double b = 3 * eta[2][1] - eta[0][3];
+	double s = eta[3][0] + eta[1][2];
+	double t = eta[2][1] + eta[0][3];
+	double d = eta[2][0] - eta[0][2];
+
+	hu[0] = static_cast<Feature>(eta[2][0] + eta[0][2]);
+	hu[1] = static_cast<Feature>(d * d + 4 * eta[1][1] * eta[1][1]);
+	hu[2] = static_cast<Feature>(a * a + b * b);
+	hu[3] = static_cast<Feature>(s * s + t * t);
+	hu[4] = static_cast<Feature>(a * s * (s * s - 3 * t * t) + b * t * (3 * s * s - t * t));
+	hu[5] = static_cast<Feature>(d * (s * s - t * t) + 4 * eta[1][1] * s * t);
+	hu[6] = static_cast<Feature>(b * s * (s * s - 3 * t * t) - a * t * (3 * s * s - t * t));
+}
+
+inline vector<double> ZernikeTable::radial_coefficients(unsigned n, unsigned m)
+{
+	// c[s] = (-1)^s (n - s)! / (s! ((n + m) / 2 - s)! ((n - m) / 2 - s)!)
+	vector<double> c((n - m) / 2 + 1);
+	for (unsigned s = 0; s < c.size(); ++s)
+	{
+		double v = s % 2 ? -1.0 : 1.0;
+		for (unsigned k = 2; k <= n - s; ++k)
+			v *= k;
+		for (unsigned k = 2; k <= s; ++k)
+			v /= k;
+		for (unsigned k = 2; k <= (n + m) / 2 - s; ++k)
+			v /= k;
+		for (unsigned k = 2; k <= (n - m) / 2 - s; ++k)
+			v /= k;
+		c[s] = v;
+	}
+
+	return c;
+}
+
+inline void ZernikeTable::build(unsigned nrow, unsigned ncol, unsigned order)
+{
+	rows = nrow;
+	cols = ncol;
+	max_order = order;
+
+	nm.clear();
+	for (unsigned n = 0; n <= order; ++n)
+		for (unsigned m = n % 2; m <= n; m += 2)
+			nm.push_back(make_pair(n, m));
+
+	vector<vector<double> > coefficients;
+	for (const auto & p : nm)
+		coefficients.push_back(radial_coefficients(p.first, p.second));
+
+	unsigned width = 2 * nm.size();
+	basis.assign(rows * cols * width, 0.0);
+	if (!rows || !cols)
+		return;
+
+	// Pixel (r, c) is at ((2c + 1 - ncol) / diameter, (2r + 1 - nrow) / diameter),
+	// the area of a pixel is (2 / diameter)^2
+	double diameter = sqrt(static_cast<double>(rows) * rows + static_cast<double>(cols) * cols);
+	double area = 4.0 / (diameter * diameter);
+	double pi = acos(-1.0);
+
+	vector<double> rho_power(order + 1);
+
+	for (unsigned r = 0; r < rows; ++r)
+		for (unsigned c = 0; c < cols; ++c)
+		{
+			double x = (2.0 * c + 1 - cols) / diameter;
+			double y = (2.0 * r + 1 - rows) / diameter;
+			double rho = sqrt(x * x + y * y);
+			double theta = atan2(y, x);
+
+			rho_power[0] = 1.0;
+			for (unsigned k = 1; k <= order; ++k)
+				rho_power[k] = rho_power[k - 1] * rho;
+
+			double * row = &basis[(r * cols + c) * width];
+			for (unsigned k = 0; k < nm.size(); ++k)
+			{
+				unsigned n = nm[k].first, m = nm[k].second;
+
+				double radial = 0.0;
+				for (unsigned s = 0; s < coefficients[k].size(); ++s)
+					radial += coefficients[k][s] * rho_power[n - 2 * s];
+
+				double w = (n + 1) / pi * area * radial;
+				row[2 * k] = w * cos(m * theta);
+				row[2 * k + 1] = -w * sin(m * theta);
+			}
+		}
+}
+
+template <class Image, class Feature>
+void ZernikeTable::magnitudes(const Image & img, Feature * magnitudes) const
+{
+	typedef vector<double, ArenaAllocator<double> > Sums;
+
+	Arena::Scope scope;
+
+	unsigned width = 2 * nm.size();
+	Sums sums(width);
+
+	for (unsigned r = 0; r < rows; ++r)
+	{
+		const auto & img_row = img[r];
+		for (unsigned c = 0; c < cols; ++c)
+			if (img_row[c])
+			{
+				const double * row = &basis[(r * cols + c) * width];
+				for (unsigned k = 0; k < width; ++k)
+					sums[k] += row[k];
+			}
+	}
+
+	for (unsigned k = 0; k < nm.size(); ++k)
+		magnitudes[k] = static_cast<Feature>(sqrt(sums[2 * k] * sums[2 * k] + sums[2 * k + 1] * sums[2 * k + 1]));
+}
+
+inline const ZernikeTable & ZernikeTable::local(unsigned nrow, unsigned ncol, unsigned order)
+{
+	static thread_local ZernikeTable table;
+	if (table.nrow() != nrow || table.ncol() != ncol || table.order() != order || table.nm.empty())
+		table.build(nrow, ncol, order);
+
+	return table;
+}
+
+#endif
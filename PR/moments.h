@@ -0,0 +1,137 @@
+/*                                                                 -*- C++ -*-
+ * File: moments.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Geometric moments of binary images
+ *
+ */
+
+#ifndef _MOMENTS_H_
+#define _MOMENTS_H_
+
+#include <vector>
+
+using namespace std;
+
+/************************************************************
+* Raw moments m(p, q) = sum of x^p * y^q over black pixels
+* (x is column, y is row), p + q <= 3, accumulated in one
+* pass in integers: each row contributes its sums of x^p
+* (branch-free, vectorized by compiler) multiplied by y^q.
+* Central moments are derived from the raw ones about any
+* centre (exact for integral centres of moderate images)
+************************************************************/
+class Moments
+{
+public:
+
+	enum { MAX_ORDER = 3 };
+
+	Moments() { clear(); }
+
+	template <class Image>
+	explicit Moments(const Image & img) { compute(img); }
+
+	void clear();
+
+	template <class Image>
+	void compute(const Image & img);
+
+	// Adds black pixels of row y
+	template <class Row>
+	void add_row(const Row & row, unsigned ncol, unsigned y);
+
+	// Number of black pixels
+	unsigned long long count() const { return m[0][0]; }
+
+	// p + q <= MAX_ORDER
+	unsigned long long raw(unsigned p, unsigned q) const { return m[p][q]; }
+
+	// Centroid (undefined for an empty image)
+	double x_center() const { return static_cast<double>(m[1][0]) / m[0][0]; }
+	double y_center() const { return static_cast<double>(m[0][1]) / m[0][0]; }
+
+	// Sum of (x - xc)^p * (y - yc)^q over black pixels
+	double central(unsigned p, unsigned q, double xc, double yc) const;
+
+	// Central moment about the centroid
+	double central(unsigned p, unsigned q) const { return central(p, q, x_center(), y_center()); }
+
+private:
+
+	unsigned long long m[MAX_ORDER + 1][MAX_ORDER + 1];
+};
+
+/******************************************************************************
+*
+* IMPLEMENTATIONS
+*
+*******************************************************************************/
+
+inline void Moments::clear()
+{
+	for (unsigned p = 0; p <= MAX_ORDER; ++p)
+		for (unsigned q = 0; q <= MAX_ORDER; ++q)
+			m[p][q] = 0;
+}
+
+template <class Image>
+void Moments::compute(const Image & img)
+{
+	clear();
+	for (unsigned y = 0; y < img.nrow(); ++y)
+		add_row(img[y], img.ncol(), y);
+}
+
+template <class Row>
+void Moments::add_row(const Row & row, unsigned ncol, unsigned y)
+{
+	unsigned long long s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+	for (unsigned x = 0; x < ncol; ++x)
+	{
+		unsigned long long b = row[x] != 0;
+		unsigned long long bx = b * x;
+		s0 += b;
+		s1 += bx;
+		s2 += bx * x;
+		s3 += bx * x * x;
+	}
+
+	if (!s0)
+		return;
+
+	unsigned long long s[MAX_ORDER + 1] = { s0, s1, s2, s3 };
+	unsigned long long yq = 1;
+	for (unsigned q = 0; q <= MAX_ORDER; ++q, yq *= y)
+		for (unsigned p = 0; p + q <= MAX_ORDER; ++p)
+			m[p][q] += s[p] * yq;
+}
+
+inline double Moments::central(unsigned p, unsigned q, double xc, double yc) const
+{
+	static const double binomial[MAX_ORDER + 1][MAX_ORDER + 1] =
+	{
+		{ 1, 0, 0, 0 },
+		{ 1, 1, 0, 0 },
+		{ 1, 2, 1, 0 },
+		{ 1, 3, 3, 1 }
+	};
+
+	// (x - xc)^p * (y - yc)^q expanded by binomial theorem
+	double result = 0.0;
+	double xp = 1.0;
+	for (unsigned i = 0; i <= p; ++i, xp *= -xc)
+	{
+		double yq = 1.0;
+		for (unsigned j = 0; j <= q; ++j, yq *= -yc)
+			result += binomial[p][i] * binomial[q][j] * xp * yq * static_cast<double>(m[p - i][q - j]);
+	}
+
+	return result;
+}
+
+#endif
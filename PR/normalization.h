@@ -1,5 +1,5 @@
 /*                                                                 -*- C++ -*-
- * File: normalozation.h
+ * File: normalization.h
  * 
  * Author: Ilya Ivensky
  * 
@@ -13,14 +13,135 @@
 #ifndef _NORMALIZATION_H_
 #define _NORMALIZATION_H_
 
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
 #include "LA/matrix.h"
+#include "LA/parallel.h"
+#include "PR/moments.h"
+#include "PR/utils.h"
 
 template <class T>
 Matrix<T> linear_normalization(const Matrix<T> & image, unsigned size);
 
 // Aspect Ratio Adaptive Normalization
-template <class T>
-Matrix<T> linear_aran_normalization(const Matrix<T> & image, unsigned size);
+template <class Image>
+Image linear_aran_normalization(const Image & image, unsigned size);
+
+// Same as above, writes to result (resized if needed, must not be image)
+template <class Image>
+void linear_aran_normalization(const Image & image, unsigned size, Image & result);
+
+/************************************************************
+* Resampling of one axis: destination pixel d takes source
+* pixels index[offset[d]], ..., index[offset[d + 1] - 1] with
+* weights weight[...]. Source pixels outside of the image are
+* not listed (they are white)
+************************************************************/
+struct AxisMap
+{
+	vector<unsigned> offset;
+	vector<unsigned> index;
+	vector<float> weight;
+
+	// Destination pixels [0, size) cover source interval 
+	// [begin, begin + length) (pixel i covers [i, i + 1)).
+	// Nearest takes the pixel under the centre of destination pixel, 
+	// bilinear interpolates between the two nearest centres, area 
+	// averages source pixels by their overlap with destination pixel
+	void build(unsigned src_size, unsigned size, double begin, double length, unsigned interpolation);
+
+private:
+
+	void add(signed i, unsigned src_size, double w);
+};
+
+/************************************************************
+* Size normalization by inverse mapping: every pixel of the
+* normalized size * size image is interpolated from the
+* source, so upscaling leaves no holes.
+* Source window mapped onto the normalized image:
+*  - LINEAR: whole image, each axis scaled separately
+*  - ARAN: whole image, aspect ratio kept, centred
+*  - MOMENT: square of side moment_scale * (larger standard
+*    deviation of black pixels) centred at the centroid
+* Axis maps of LINEAR and ARAN depend on the source size only
+* and are reused while it does not change.
+* Each source row is resampled along columns first, then
+* the resampled rows are combined by loops over contiguous
+* floats (vectorized by compiler).
+* Integral pixel types are rounded and clamped
+************************************************************/
+class SizeNormalizer
+{
+public:
+
+	enum Method { LINEAR, ARAN, MOMENT };
+	enum Interpolation { NEAREST, BILINEAR, AREA };
+
+	SizeNormalizer(unsigned size, Method method = ARAN, Interpolation interpolation = BILINEAR, double moment_scale = 4.0) :
+		size(size), method(method), interpolation(interpolation), moment_scale(moment_scale) {}
+
+	unsigned get_size() const { return size; }
+	Method get_method() const { return method; }
+	Interpolation get_interpolation() const { return interpolation; }
+
+	// Per-thread tables and buffers
+	struct Workspace
+	{
+		Workspace() : nrow(0), ncol(0) {}
+
+		// Source size the maps were built for (0 if they depend on image)
+		unsigned nrow, ncol;
+		AxisMap rows, cols;
+		vector<float> tmp;
+		vector<float> acc;
+	};
+
+	// Writes size * size pixels of normalized img to out (row by row)
+	template <class Image, class T>
+	void normalize(const Image & img, T * out, Workspace & ws) const;
+
+	template <class Image, class T>
+	void normalize(const Image & img, T * out) { normalize(img, out, workspace); }
+
+	template <class Image>
+	Image normalize(const Image & img);
+
+	// Normalizes images[k] into out + k * size * size, 
+	// nthreads = 0 uses all hardware threads
+	template <class Image, class T>
+	void normalize_batch(const vector<Image> & images, T * out, unsigned nthreads = 1) const;
+
+private:
+
+	// Builds maps of ws for img
+	template <class Image>
+	void prepare(const Image & img, Workspace & ws) const;
+
+	template <class T>
+	static T pixel_cast(float v) { return pixel_cast<T>(v, is_integral<T>()); }
+
+	template <class T>
+	static T pixel_cast(float v, true_type)
+	{
+		v = min(max(v, static_cast<float>(numeric_limits<T>::min())), static_cast<float>(numeric_limits<T>::max()));
+
+		// Rounds half away from 0 (conversion truncates)
+		return static_cast<T>(v + (v < 0 ? -0.5f : 0.5f));
+	}
+
+	template <class T>
+	static T pixel_cast(float v, false_type) { return static_cast<T>(v); }
+
+	unsigned size;
+	Method method;
+	Interpolation interpolation;
+	double moment_scale;
+
+	Workspace workspace;
+};
 
 /******************************************************************************
 * 
@@ -28,8 +149,8 @@ Matrix<T> linear_aran_normalization(const Matrix<T> & image, unsigned size);
 *
 *******************************************************************************/
 
-template <class T>
-Matrix<T> linear_aran_normalization(const Matrix<T> & image, unsigned size)
+template <class Image>
+void linear_aran_normalization(const Image & image, unsigned size, Image & tmp)
 {
 	double k = static_cast<double>(size) / std::max(image.nrow(), image.ncol());
 
@@ -41,7 +162,7 @@ Matrix<T> linear_aran_normalization(const Matrix<T> & image, unsigned size)
 	unsigned vert_shift = static_cast<unsigned>((dsize - drow * k) / 2 + 0.5);
 	unsigned horiz_shift = static_cast<unsigned>((dsize - dcol * k) / 2 + 0.5);
 
-	Matrix<T> tmp(size);
+	clear_image(tmp, size, size);
 
 	// Read the image into standard pane using forward mapping
 	for (unsigned i = 0; i < image.nrow(); ++i)
@@ -53,14 +174,20 @@ Matrix<T> linear_aran_normalization(const Matrix<T> & image, unsigned size)
 			if (i1 < size && j1 < size)
 				tmp[i1][j1] = image[i][j]; 
 		}
+}
 
-	return tmp;
+template <class Image>
+Image linear_aran_normalization(const Image & image, unsigned size)
+{
+	Image result;
+	linear_aran_normalization(image, size, result);
+	return result;
 }
 
 template <class T>
 Matrix<T> linear_normalization(const Matrix<T> & image, unsigned size)
 {
-	Matrix tmp(size);
+	Matrix<T> tmp(size);
 
 	double alpha = (static_cast<double>(size)) / image.ncol();
 	double beta = (static_cast<double>(size)) / image.nrow();
@@ -79,4 +206,179 @@ Matrix<T> linear_normalization(const Matrix<T> & image, unsigned size)
 	return tmp;
 }
 
+inline void AxisMap::add(signed i, unsigned src_size, double w)
+{
+	if (i < 0 || i >= static_cast<signed>(src_size) || w <= 0)
+		return;
+
+	index.push_back(i);
+	weight.push_back(static_cast<float>(w));
+}
+
+inline void AxisMap::build(unsigned src_size, unsigned size, double begin, double length, unsigned interpolation)
+{
+	offset.resize(size + 1);
+	index.clear();
+	weight.clear();
+
+	double step = length / size;
+
+	for (unsigned d = 0; d < size; ++d)
+	{
+		offset[d] = index.size();
+
+		double centre = begin + (d + 0.5) * step;
+
+		if (interpolation == SizeNormalizer::NEAREST)
+			add(static_cast<signed>(floor(centre)), src_size, 1.0);
+		else if (interpolation == SizeNormalizer::BILINEAR)
+		{
+			double x = centre - 0.5;
+			double i = floor(x);
+			add(static_cast<signed>(i), src_size, 1.0 - (x - i));
+			add(static_cast<signed>(i) + 1, src_size, x - i);
+		}
+		else
+		{
+			double lo = begin + d * step, hi = lo + step;
+			for (double i = floor(lo); i < hi; ++i)
+				add(static_cast<signed>(i), src_size, (min(hi, i + 1) - max(lo, i)) / step);
+		}
+	}
+
+	offset[size] = index.size();
+}
+
+template <class Image>
+void SizeNormalizer::prepare(const Image & img, Workspace & ws) const
+{
+	unsigned nrow = img.nrow(), ncol = img.ncol();
+
+	if (method != MOMENT && ws.nrow == nrow && ws.ncol == ncol)
+		return;
+
+	double row_begin = 0, row_length = nrow;
+	double col_begin = 0, col_length = ncol;
+
+	if (method == ARAN)
+	{
+		double side = max(nrow, ncol);
+		row_begin = (nrow - side) / 2;
+		col_begin = (ncol - side) / 2;
+		row_length = col_length = side;
+	}
+	else if (method == MOMENT)
+	{
+		Moments moments(img);
+
+		// Empty image is mapped as LINEAR
+		if (moments.count())
+		{
+			double xc = moments.x_center(), yc = moments.y_center();
+			double var_x = moments.central(2, 0) / moments.count();
+			double var_y = moments.central(0, 2) / moments.count();
+
+			double side = max(moment_scale * sqrt(max(max(var_x, var_y), 0.0)), 1.0);
+
+			// Pixel centres are at i + 0.5
+			row_begin = yc + 0.5 - side / 2;
+			col_begin = xc + 0.5 - side / 2;
+			row_length = col_length = side;
+		}
+	}
+
+	ws.rows.build(nrow, size, row_begin, row_length, interpolation);
+	ws.cols.build(ncol, size, col_begin, col_length, interpolation);
+
+	ws.nrow = method == MOMENT ? 0 : nrow;
+	ws.ncol = method == MOMENT ? 0 : ncol;
+}
+
+template <class Image, class T>
+void SizeNormalizer::normalize(const Image & img, T * out, Workspace & ws) const
+{
+	prepare(img, ws);
+
+	const AxisMap & rows = ws.rows;
+	const AxisMap & cols = ws.cols;
+
+	if (interpolation == NEAREST)
+	{
+		for (unsigned i = 0; i < size; ++i, out += size)
+		{
+			if (rows.offset[i] == rows.offset[i + 1])
+			{
+				fill(out, out + size, T());
+				continue;
+			}
+
+			const auto & src = img[rows.index[rows.offset[i]]];
+			for (unsigned j = 0; j < size; ++j)
+				out[j] = cols.offset[j] == cols.offset[j + 1] ? T() : static_cast<T>(src[cols.index[cols.offset[j]]]);
+		}
+		return;
+	}
+
+	// Resample columns of each source row
+	ws.tmp.resize(img.nrow() * size);
+	for (unsigned r = 0; r < img.nrow(); ++r)
+	{
+		const auto & src = img[r];
+		float * t = &ws.tmp[r * size];
+		for (unsigned j = 0; j < size; ++j)
+		{
+			float v = 0;
+			for (unsigned k = cols.offset[j]; k < cols.offset[j + 1]; ++k)
+				v += cols.weight[k] * static_cast<float>(src[cols.index[k]]);
+			t[j] = v;
+		}
+	}
+
+	// Combine resampled rows
+	ws.acc.resize(size);
+	float * acc = ws.acc.data();
+	for (unsigned i = 0; i < size; ++i, out += size)
+	{
+		fill(acc, acc + size, 0.0f);
+		for (unsigned k = rows.offset[i]; k < rows.offset[i + 1]; ++k)
+		{
+			const float * t = &ws.tmp[rows.index[k] * size];
+			float w = rows.weight[k];
+			for (unsigned j = 0; j < size; ++j)
+				acc[j] += w * t[j];
+		}
+
+		for (unsigned j = 0; j < size; ++j)
+			out[j] = pixel_cast<T>(acc[j]);
+	}
+}
+
+template <class Image>
+Image SizeNormalizer::normalize(const Image & img)
+{
+	typedef typename remove_const<typename remove_reference<decltype(img[0][0])>::type>::type T;
+
+	vector<T> pixels(size * size);
+	normalize(img, pixels.data(), workspace);
+
+	Image result(size, size);
+	for (unsigned i = 0; i < size; ++i)
+		copy(pixels.begin() + i * size, pixels.begin() + (i + 1) * size, result[i].begin());
+
+	return result;
+}
+
+template <class Image, class T>
+void SizeNormalizer::normalize_batch(const vector<Image> & images, T * out, unsigned nthreads) const
+{
+	unsigned n = images.size();
+	vector<Workspace> workspaces(parallel_chunks(0, n, nthreads));
+
+	parallel_for(0, n, nthreads, [&](unsigned chunk, unsigned b, unsigned e)
+	{
+		for (unsigned k = b; k < e; ++k)
+			normalize(images[k], out + static_cast<size_t>(k) * size * size, workspaces[chunk]);
+	});
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,150 @@
+/*                                                                 -*- C++ -*-
+ * File: packed_image.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Binary image packed into 64 bit words (one bit per pixel)
+ *
+ */
+
+#ifndef _PACKED_IMAGE_H_
+#define _PACKED_IMAGE_H_
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+inline unsigned popcount(uint64_t x)
+{
+#ifdef __GNUC__
+	return __builtin_popcountll(x);
+#else
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return static_cast<unsigned>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/************************************************************
+* Pixel c of row r is bit c % 64 of word c / 64 of row r.
+* Rows are surrounded by white pixels: rows -1 and nrow()
+* exist, and each row has white word before the first and
+* after the last one, so neighbours of any pixel can be
+* read (as shifted words) without checking boundaries.
+* Bits beyond ncol() are always 0
+************************************************************/
+class PackedImage
+{
+public:
+
+	typedef uint64_t Word;
+	enum { WORD_BITS = 64 };
+
+	PackedImage() { resize(0, 0); }
+
+	PackedImage(unsigned nrow, unsigned ncol) { resize(nrow, ncol); }
+
+	// Pixel is black if it is not 0
+	template <class Image>
+	explicit PackedImage(const Image & img) { assign(img); }
+
+	// Resizes and clears
+	void resize(unsigned nrow, unsigned ncol)
+	{
+		rows = nrow;
+		cols = ncol;
+		nwords = (ncol + WORD_BITS - 1) / WORD_BITS;
+		stride = nwords + 2;
+		bits.assign((rows + 2) * stride, 0);
+	}
+
+	template <class Image>
+	void assign(const Image & img);
+
+	// Black pixels of img are set to value, white to 0
+	template <class Image, class T>
+	void unpack(Image & img, const T & value) const;
+
+	unsigned nrow() const { return rows; }
+	unsigned ncol() const { return cols; }
+
+	// Number of words in a row
+	unsigned words() const { return nwords; }
+
+	// Row r in [-1, nrow()], rows -1 and nrow() are white
+	Word * row(signed r) { return &bits[(r + 1) * stride + 1]; }
+	const Word * row(signed r) const { return &bits[(r + 1) * stride + 1]; }
+
+	Word * operator[](unsigned r) { return row(r); }
+	const Word * operator[](unsigned r) const { return row(r); }
+
+	bool get(unsigned r, unsigned c) const { return (row(r)[c / WORD_BITS] >> (c % WORD_BITS)) & 1; }
+
+	void set(unsigned r, unsigned c, bool black)
+	{
+		Word & w = row(r)[c / WORD_BITS];
+		Word bit = Word(1) << (c % WORD_BITS);
+		w = black ? w | bit : w & ~bit;
+	}
+
+	// Bit k of result is the pixel left (west) of pixel k of word w of row
+	static Word west(const Word * row, unsigned w) { const Word * p = row + w; return (p[0] << 1) | (p[-1] >> (WORD_BITS - 1)); }
+
+	// Bit k of result is the pixel right (east) of pixel k of word w of row
+	static Word east(const Word * row, unsigned w) { const Word * p = row + w; return (p[0] >> 1) | (p[1] << (WORD_BITS - 1)); }
+
+	// Bits of word w for columns [begin, end)
+	static Word columns(unsigned w, unsigned begin, unsigned end)
+	{
+		unsigned first = w * WORD_BITS;
+		if (end <= first || begin >= first + WORD_BITS)
+			return 0;
+
+		Word mask = ~Word(0);
+		if (begin > first)
+			mask &= ~Word(0) << (begin - first);
+		if (end < first + WORD_BITS)
+			mask &= ~(~Word(0) << (end - first));
+		return mask;
+	}
+
+private:
+
+	unsigned rows;
+	unsigned cols;
+	unsigned nwords;
+	unsigned stride;
+	vector<Word> bits;
+};
+
+template <class Image>
+void PackedImage::assign(const Image & img)
+{
+	resize(img.nrow(), img.ncol());
+	for (unsigned r = 0; r < rows; ++r)
+	{
+		Word * p = row(r);
+		const auto & src = img[r];
+		for (unsigned c = 0; c < cols; ++c)
+			p[c / WORD_BITS] |= Word(src[c] != 0) << (c % WORD_BITS);
+	}
+}
+
+template <class Image, class T>
+void PackedImage::unpack(Image & img, const T & value) const
+{
+	for (unsigned r = 0; r < rows; ++r)
+	{
+		const Word * p = row(r);
+		auto & dst = img[r];
+		for (unsigned c = 0; c < cols; ++c)
+			dst[c] = (p[c / WORD_BITS] >> (c % WORD_BITS)) & 1 ? value : 0;
+	}
+}
+
+#endif
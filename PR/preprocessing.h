@@ -0,0 +1,162 @@
+/*                                                                 -*- C++ -*-
+ * File: preprocessing.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Configurable chain of preprocessing steps (slant correction,
+ *   normalization, thinning) applied to batches of images
+ *
+ */
+
+#ifndef _PREPROCESSING_H_
+#define _PREPROCESSING_H_
+
+#include "LA/matrix.h"
+#include "LA/parallel.h"
+#include "PR/utils.h"
+#include "PR/slant_correction.h"
+#include "PR/normalization.h"
+#include "PR/thinning.h"
+
+/************************************************************
+* Steps are applied to each image in the order they were
+* added. Each step writes to a buffer of per-thread workspace
+* (the last one to the output image), buffers are reused from
+* image to image, so no images are allocated once they have
+* grown. Result is the same as of calling the step functions
+* in sequence.
+* Steps are fused only inside (slant correction shears and
+* centres in one pass, thinning works on packed rows): each
+* step rounds pixel positions, so composing them into one
+* affine map would change the result
+************************************************************/
+class Preprocessing
+{
+public:
+
+	enum Step { SLANT_CORRECTION, MOMENT_NORMALIZATION, ARAN_NORMALIZATION, THINNING };
+
+	// Appends step. size is the size of ARAN normalization
+	Preprocessing & add(Step step, unsigned size = 0);
+
+	unsigned nsteps() const { return stages.size(); }
+
+	// Per-thread buffers
+	template <class Image>
+	struct Workspace
+	{
+		Image buffers[2];
+		PackedScratch packed;
+	};
+
+	// out must not be img
+	template <class Image>
+	void process(const Image & img, Image & out, Workspace<Image> & ws) const;
+
+	template <class Image>
+	Image process(const Image & img) const;
+
+	// out[k] is processed images[k] (images of out are reused).
+	// nthreads = 0 uses all hardware threads
+	template <class Image>
+	void process_batch(const vector<Image> & images, vector<Image> & out, unsigned nthreads = 1) const;
+
+private:
+
+	struct Stage
+	{
+		Step step;
+		unsigned size;
+	};
+
+	template <class Image>
+	void apply(const Stage & stage, const Image & in, Image & out, Workspace<Image> & ws) const;
+
+	vector<Stage> stages;
+};
+
+/******************************************************************************
+*
+* IMPLEMENTATIONS
+*
+*******************************************************************************/
+
+inline Preprocessing & Preprocessing::add(Step step, unsigned size)
+{
+	if (step == ARAN_NORMALIZATION && !size)
+		throw exception("Preprocessing::add: size of ARAN normalization is 0");
+
+	Stage stage = { step, size };
+	stages.push_back(stage);
+
+	return *this;
+}
+
+template <class Image>
+void Preprocessing::apply(const Stage & stage, const Image & in, Image & out, Workspace<Image> & ws) const
+{
+	switch (stage.step)
+	{
+	case SLANT_CORRECTION:
+		slant_correction(in, out);
+		break;
+	case MOMENT_NORMALIZATION:
+		moment_based_normalization(in, out);
+		break;
+	case ARAN_NORMALIZATION:
+		linear_aran_normalization(in, stage.size, out);
+		break;
+	case THINNING:
+		zhang_suen_thinning(in, out, ws.packed);
+		break;
+	}
+}
+
+template <class Image>
+void Preprocessing::process(const Image & img, Image & out, Workspace<Image> & ws) const
+{
+	if (stages.empty())
+	{
+		out = img;
+		return;
+	}
+
+	// Steps alternate between the buffers
+	const Image * src = &img;
+	for (unsigned k = 0; k < stages.size(); ++k)
+	{
+		Image & dst = k + 1 == stages.size() ? out : ws.buffers[k % 2];
+		apply(stages[k], *src, dst, ws);
+		src = &dst;
+	}
+}
+
+template <class Image>
+Image Preprocessing::process(const Image & img) const
+{
+	Workspace<Image> ws;
+	Image out;
+	process(img, out, ws);
+
+	return out;
+}
+
+template <class Image>
+void Preprocessing::process_batch(const vector<Image> & images, vector<Image> & out, unsigned nthreads) const
+{
+	unsigned n = images.size();
+	out.resize(n);
+
+	vector<Workspace<Image> > workspaces(parallel_chunks(0, n, nthreads));
+
+	parallel_for(0, n, nthreads, [&](unsigned chunk, unsigned b, unsigned e)
+	{
+		for (unsigned k = b; k < e; ++k)
+			process(images[k], out[k], workspaces[chunk]);
+	});
+}
+
+#endif
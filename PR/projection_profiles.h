@@ -0,0 +1,139 @@
+/*                                                                 -*- C++ -*-
+ * File: projection_profiles.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Horizontal, vertical and diagonal projection profiles
+ *   (histograms of black pixels) of image zones
+ *
+ */
+
+#ifndef _PROJECTION_PROFILES_H_
+#define _PROJECTION_PROFILES_H_
+
+#include "LA/matrix.h"
+#include "PR/zoning.h"
+
+/************************************************************
+* Profiles of a zone with rows * cols pixels are, in order:
+*  - horizontal: rows bins, by row
+*  - vertical: cols bins, by column
+*  - left-right diagonal: rows + cols - 1 bins, by c - r
+*    (from the bottom-left corner to the top-right one)
+*  - right-left diagonal: rows + cols - 1 bins, by r + c
+*    (from the top-left corner to the bottom-right one)
+* where r, c are coordinates inside of the zone.
+* All four are accumulated in one raster pass: a row of a
+* zone has fixed horizontal bin, and vertical and diagonal
+* bins of its pixels are consecutive, so each black pixel
+* adds to the bins at its column in the zone
+************************************************************/
+
+// Number of profile bins of zone
+inline unsigned profiles_size(const Zone & z)
+{
+	return 3 * (z.rowsEnd() - z.rowsBegin() + z.colsEnd() - z.colsBegin()) - 2;
+}
+
+inline unsigned profiles_size(const Matrix<Zone> & zones)
+{
+	unsigned size = 0;
+	for (const auto & zones_row : zones)
+		for (const auto & z : zones_row)
+			size += profiles_size(z);
+
+	return size;
+}
+
+// Zones of each row of grid have the same rows,
+// zones of each column of grid have the same columns
+inline bool is_zone_grid(const Matrix<Zone> & zones)
+{
+	for (unsigned i = 0; i < zones.nrow(); ++i)
+		for (unsigned j = 0; j < zones.ncol(); ++j)
+		{
+			const Zone & z = zones[i][j];
+			if (z.rowsBegin() != zones[i][0].rowsBegin() || z.rowsEnd() != zones[i][0].rowsEnd() ||
+				z.colsBegin() != zones[0][j].colsBegin() || z.colsEnd() != zones[0][j].colsEnd())
+				return false;
+		}
+
+	return true;
+}
+
+// Adds black pixels of row r of zone z to profiles
+template <class Row, class Feature>
+void add_profiles_row(const Row & row, const Zone & z, unsigned r, Feature * profiles)
+{
+	unsigned rows = z.rowsEnd() - z.rowsBegin();
+	unsigned cols = z.colsEnd() - z.colsBegin();
+	unsigned r_loc = r - z.rowsBegin();
+
+	Feature & hp = profiles[r_loc];
+
+	// Bins of pixel c of the zone row are [c - colsBegin()]
+	Feature * vp = profiles + rows;
+	Feature * lrd = profiles + rows + cols + (rows - 1 - r_loc);
+	Feature * rld = profiles + 2 * (rows + cols) - 1 + r_loc;
+
+	for (unsigned c = z.colsBegin(), c_loc = 0; c < z.colsEnd(); ++c, ++c_loc)
+		if (row[c])
+		{
+			hp += 1;
+			vp[c_loc] += 1;
+			lrd[c_loc] += 1;
+			rld[c_loc] += 1;
+		}
+}
+
+// Profiles of zone z of img are added to profiles[0, profiles_size(z))
+template <class Image, class Feature>
+void zone_profiles(const Image & img, const Zone & z, Feature * profiles)
+{
+	for (unsigned r = z.rowsBegin(); r < z.rowsEnd(); ++r)
+		add_profiles_row(img[r], z, r, profiles);
+}
+
+// Profiles of all zones (one after another, row by row of zones) are
+// added to profiles[0, profiles_size(zones)). Grid of zones is scanned
+// row by row of image, otherwise zones are scanned one by one
+template <class Image, class Feature>
+void zone_grid_profiles(const Image & img, const Matrix<Zone> & zones, Feature * profiles)
+{
+	if (!is_zone_grid(zones))
+	{
+		for (const auto & zones_row : zones)
+			for (const auto & z : zones_row)
+			{
+				zone_profiles(img, z, profiles);
+				profiles += profiles_size(z);
+			}
+		return;
+	}
+
+	for (const auto & zones_row : zones)
+	{
+		if (zones_row.empty())
+			continue;
+
+		for (unsigned r = zones_row.front().rowsBegin(); r < zones_row.front().rowsEnd(); ++r)
+		{
+			const auto & row = img[r];
+
+			Feature * p = profiles;
+			for (const auto & z : zones_row)
+			{
+				add_profiles_row(row, z, r, p);
+				p += profiles_size(z);
+			}
+		}
+
+		for (const auto & z : zones_row)
+			profiles += profiles_size(z);
+	}
+}
+
+#endif
@@ -0,0 +1,164 @@
+/*                                                                 -*- C++ -*-
+ * File: radial_histograms.h
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Counts of black pixels along rays from the centroid of image,
+ *   with pixel offsets of rays precomputed per image size
+ *
+ */
+
+#ifndef _RADIAL_HISTOGRAMS_H_
+#define _RADIAL_HISTOGRAMS_H_
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+/************************************************************
+* There are granularity rays in each quadrant. Ray k of the
+* first quadrant goes by unit steps in direction
+* (sqrt(1 - k / granularity), sqrt(k / granularity)) (rows,
+* columns), rays of the other quadrants are its mirrors:
+* (+, -), (-, +) and (-, -). Point t of a ray is at the
+* rounded offsets of t * direction, so offsets of all rays
+* are the same for every image of the same size and are kept
+* in the table. The table also keeps, for each distance to the
+* image border, how many points of a ray are within it, so
+* walking a ray from a pixel needs neither floating point nor
+* bounds checks
+************************************************************/
+class RayTable
+{
+public:
+
+	RayTable() : rows(0), cols(0), nrays(0) {}
+	RayTable(unsigned nrow, unsigned ncol, unsigned granularity = 8) { build(nrow, ncol, granularity); }
+
+	void build(unsigned nrow, unsigned ncol, unsigned granularity);
+
+	unsigned nrow() const { return rows; }
+	unsigned ncol() const { return cols; }
+	unsigned granularity() const { return nrays; }
+
+	// Number of histograms (rays)
+	unsigned size() const { return 4 * nrays; }
+
+	// Adds black pixels of the rays from pixel (r, c) to histograms[0, size()).
+	// img is nrow() * ncol()
+	template <class Image, class Feature>
+	void add(const Image & img, unsigned r, unsigned c, Feature * histograms) const;
+
+	// Table of the calling thread for images nrow * ncol, rebuilt when the
+	// size or granularity change
+	static const RayTable & local(unsigned nrow, unsigned ncol, unsigned granularity);
+
+private:
+
+	// Number of points of ray k within dr rows and dc columns from its start
+	unsigned length(unsigned k, unsigned dr, unsigned dc) const
+	{
+		return min(row_limit[k * rows + dr], col_limit[k * cols + dc]);
+	}
+
+	unsigned rows, cols, nrays;
+
+	// Offsets of points of ray k are [begin[k], begin[k + 1])
+	vector<unsigned> begin;
+	vector<unsigned> row_offset, col_offset;
+
+	// row_limit[k * rows + d]: number of points of ray k with row offset <= d
+	vector<unsigned> row_limit, col_limit;
+};
+
+/******************************************************************************
+*
+* IMPLEMENTATIONS
+*
+*******************************************************************************/
+
+inline void RayTable::build(unsigned nrow, unsigned ncol, unsigned granularity)
+{
+	if (!granularity)
+		throw exception("RayTable::build: granularity is 0");
+
+	rows = nrow;
+	cols = ncol;
+	nrays = granularity;
+
+	begin.assign(1, 0);
+	row_offset.clear();
+	col_offset.clear();
+	row_limit.assign(nrays * rows, 0);
+	col_limit.assign(nrays * cols, 0);
+
+	for (unsigned k = 0; k < nrays; ++k)
+	{
+		double dr = sqrt(1.0 - static_cast<double>(k) / nrays);
+		double dc = sqrt(static_cast<double>(k) / nrays);
+
+		// Points until the ray leaves the image from its corner
+		for (unsigned t = 0;; ++t)
+		{
+			unsigned r = static_cast<unsigned>(floor(t * dr + 0.5));
+			unsigned c = static_cast<unsigned>(floor(t * dc + 0.5));
+			if (r >= rows || c >= cols)
+				break;
+
+			row_offset.push_back(r);
+			col_offset.push_back(c);
+
+			++row_limit[k * rows + r];
+			++col_limit[k * cols + c];
+		}
+
+		begin.push_back(row_offset.size());
+
+		// Offsets grow along the ray, so the points within a distance
+		// are the first ones
+		for (unsigned d = 1; d < rows; ++d)
+			row_limit[k * rows + d] += row_limit[k * rows + d - 1];
+		for (unsigned d = 1; d < cols; ++d)
+			col_limit[k * cols + d] += col_limit[k * cols + d - 1];
+	}
+}
+
+template <class Image, class Feature>
+void RayTable::add(const Image & img, unsigned r, unsigned c, Feature * histograms) const
+{
+	// Direction and room to the border of each quadrant
+	const int sign_r[4] = { 1, 1, -1, -1 };
+	const int sign_c[4] = { 1, -1, 1, -1 };
+	const unsigned room_r[4] = { rows - 1 - r, rows - 1 - r, r, r };
+	const unsigned room_c[4] = { cols - 1 - c, c, cols - 1 - c, c };
+
+	for (unsigned q = 0; q < 4; ++q)
+		for (unsigned k = 0; k < nrays; ++k)
+		{
+			const unsigned * pr = row_offset.data() + begin[k];
+			const unsigned * pc = col_offset.data() + begin[k];
+			unsigned n = length(k, room_r[q], room_c[q]);
+
+			unsigned count = 0;
+			for (unsigned t = 0; t < n; ++t)
+				count += img[r + sign_r[q] * static_cast<int>(pr[t])][c + sign_c[q] * static_cast<int>(pc[t])] != 0;
+
+			histograms[q * nrays + k] += count;
+		}
+}
+
+inline const RayTable & RayTable::local(unsigned nrow, unsigned ncol, unsigned granularity)
+{
+	static thread_local RayTable table;
+	if (table.nrow() != nrow || table.ncol() != ncol || table.granularity() != granularity)
+		table.build(nrow, ncol, granularity);
+
+	return table;
+}
+
+#endif
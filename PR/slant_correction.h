@@ -15,6 +15,8 @@
 #define _SLANT_CORRECTION_H_
 
 #include "LA/matrix.h"
+#include "PR/moments.h"
+#include "PR/utils.h"
 
 template <class T>
 double moment(const Matrix<T> & m, unsigned p, unsigned q)
@@ -37,41 +39,42 @@ double central_moment(const Matrix<T> & m, unsigned xc, unsigned yc, unsigned p,
 	for (unsigned y = 0;  y < m.nrow(); ++y)
 		for (unsigned x = 0; x < m.ncol(); ++x)
 			if (m[y][x] != 0)
-				result += pow(x - xc, p) * pow(y - yc, q);
+				result += pow(static_cast<double>(x) - xc, p) * pow(static_cast<double>(y) - yc, q);
 			
 	return result;
 }
 
-template <class T>
-Matrix<T> moment_based_normalization(const Matrix<T> & m)
+// Moments are taken in one pass, the shear is written directly to result
+// (resized if needed, must not be m)
+template <class Image>
+void moment_based_normalization(const Image & m, Image & result)
 {
-	//cerr << "moment_based_normalization: m.row=" << m.row << " m.col=" << m.col << endl;
-	double m00 = moment(m, 0, 0);
-	double m10 = moment(m, 1, 0);
-	double m01 = moment(m, 0, 1);
+	clear_image(result, m.nrow(), m.ncol());
 
-	//cerr << "m00=" << m00 << " m10=" << m10 << " m01=" << m01 << endl;
+	Moments moments(m);
+	if (!moments.count())
+		return;
 
-	unsigned xc = static_cast<unsigned>(m10 / m00 + 0.5);
-	unsigned yc = static_cast<unsigned>(m01 / m00 + 0.5);
-	
-	//cerr << "xc=" << xc << " yc=" << yc << endl;
-	
-	double mu11 = central_moment(m, xc, yc, 1, 1);
-	double mu02 = central_moment(m, xc, yc, 0, 2);
+	unsigned xc = static_cast<unsigned>(moments.x_center() + 0.5);
+	unsigned yc = static_cast<unsigned>(moments.y_center() + 0.5);
 	
-	//cerr << "mu11=" << mu11 << " m02=" << mu02 << endl;
+	double mu11 = moments.central(1, 1, xc, yc);
+	double mu02 = moments.central(0, 2, xc, yc);
 	
-	double tan = -(mu11 / mu02); 
+	// Pixels of a single row have no slant
+	double tan = mu02 != 0 ? -(mu11 / mu02) : 0.0; 
 	
-	Matrix<T> result(m.nrow(), m.ncol());
-		
 	for (unsigned y = 0; y < m.nrow(); ++y)
 	{
+		signed y_tmp = static_cast<signed>(y) - static_cast<signed>(yc);
+		signed shift = static_cast<signed>(y_tmp * tan + 0.5);
+
 		for (unsigned x = 0; x < m.ncol(); ++x)
 		{
-			signed y_tmp = y - yc;
-			signed x1 = x - static_cast<signed>(y_tmp * tan + 0.5);
+			if (m[y][x] == 0)
+				continue;
+
+			signed x1 = static_cast<signed>(x) - shift;
 
 			// If are we out of the range due to rotation?
 			if (x1 < 0 || x1 >= static_cast<signed>(result.ncol()))
@@ -80,117 +83,87 @@ Matrix<T> moment_based_normalization(const Matrix<T> & m)
 			result[y][x1] = m[y][x];
 		}
 	}
+}
 
+template <class Image>
+Image moment_based_normalization(const Image & m)
+{
+	Image result;
+	moment_based_normalization(m, result);
 	return result;
 }
 
+/**
+ One pass collects rows and bounding diagonals of black pixels, 
+ the second one the centroid of the corrected image, the third one
+ writes corrected pixels directly to their centred positions.
+ Corrected column of a pixel is non-decreasing along a row, so 
+ pixels falling into the same column (the last one wins) are 
+ consecutive.
+ result is resized if needed, it must not be m
+ */
 template <class Image>
-Image slant_correction(const Image & m)
+void slant_correction(const Image & m, Image & result)
 {
-	// Step 1. Calculate bounding diagonals
+	clear_image(result, m.nrow(), m.ncol());
 
-	unsigned b1 = 0;
-	bool found_b1 = false;
-	for (; b1 < m.nrow() + m.ncol() - 1 && !found_b1; ++b1)
-	{
-		unsigned r = (b1 > m.nrow() ? m.nrow() : b1 + 1);
-		unsigned c = (b1 < m.nrow() ? 0 : b1 - m.nrow() + 1);
+	signed nrow = m.nrow(), ncol = m.ncol();
 
-		// scan right_up-left_down diagonal
-		for (; r > 0 && c < m.ncol() && !found_b1; --r, ++c)
-		{
-			if (m[r - 1][c])
-				found_b1 = true;
-		}
-	}
+	// Step 1. Calculate rows and bounding diagonals (r + c and c - r)
 
-	unsigned b2 = m.nrow() + m.ncol() - 1;
-	bool found_b2 = false;
-	for (; b2 > 0 && !found_b2; --b2)
-	{
-		unsigned r = (b2 > m.nrow() ? m.nrow() : b2);
-		unsigned c = (b2 > m.nrow() ? b2 - m.nrow() : 0);
-
-		// scan right_up-left_down diagonal
-		for (; r > 0 && c < m.ncol() && !found_b2; --r, ++c)
-		{
-			if (m[r - 1][c])
-				found_b2 = true;
-		}
-	}
+	signed min_r = nrow, max_r = -1;
+	signed min_sum = nrow + ncol, max_sum = -1;
+	signed min_diff = ncol, max_diff = -nrow;
 
-	unsigned b3 = 0;
-	bool found_b3 = false;
-	for (; b3 < m.nrow() + m.ncol() - 1 && !found_b3; ++b3)
+	for (signed r = 0; r < nrow; ++r)
 	{
-		unsigned r = (b3 < m.ncol() ? 0 : b3 - m.ncol() + 1);
-		unsigned c = (b3 < m.ncol() ? m.ncol() - b3 - 1 : 0);
-		
-		// scan left_down-right_up diagonal
-		for (; r < m.nrow() && c < m.ncol() && !found_b3; ++r, ++c)
-		{
-			if (m[r][c])
-				found_b3 = true;
-		}
+		const auto & row = m[r];
+		for (signed c = 0; c < ncol; ++c)
+			if (row[c])
+			{
+				min_r = min(min_r, r);
+				max_r = r;
+				min_sum = min(min_sum, r + c);
+				max_sum = max(max_sum, r + c);
+				min_diff = min(min_diff, c - r);
+				max_diff = max(max_diff, c - r);
+			}
 	}
 
-	unsigned b4 = m.nrow() + m.ncol() - 1;
-	bool found_b4 = false;
-	for (; b4 > 0 && !found_b4; --b4)
-	{
-		unsigned r = (b4 > m.ncol() ? b4 - m.ncol() : 0);
-		unsigned c = (b4 > m.ncol() ? 0 : m.ncol() - b4);
-
-		// scan left_down-right_up diagonal
-		for (; r < m.nrow() && c < m.ncol() && !found_b4; ++r, ++c)
-		{
-			if (m[r][c])
-				found_b4 = true;
-		}
-	}
+	if (max_r < 0)
+		return;
 
 	// Step 2: Calculate angle of slant
 
 	// Calculate A
-	unsigned min_r = m.nrow(), max_r = 0;
-
-	for (unsigned r = 0; r < m.nrow(); ++r)
-		for (unsigned c = 0; c < m.ncol(); ++c)
-			if (m[r][c])
-			{
-				if (r > max_r) max_r = r;
-				if (r < min_r) min_r = r;
-			}
-
 	double a = max_r - min_r;
 
 	// Calculate B
-	signed b = b4 + b1 - b3 - b2;
+	signed b = (max_diff - min_diff) - (max_sum - min_sum);
 	double b_double = static_cast<double>(b) / 2;
 
-	double theta = b_double / a;
-
-	// Step 3. Apply correction
+	// Pixels of a single row have no slant
+	double theta = a != 0 ? b_double / a : 0.0;
 
-	Image sl_corrected(m.nrow(), m.ncol());
+	// Step 3. Calculate center of corrected image
 
-	for (unsigned r = 0; r < m.nrow(); ++r)
-		for (unsigned c = 0; c < m.ncol(); ++c)
-			if (m[r][c])
+	unsigned r_total = 0, c_total = 0, total = 0;
+	
+	for (signed r = 0; r < nrow; ++r)
+	{
+		const auto & row = m[r];
+		signed last = -1;
+		for (signed c = 0; c < ncol; ++c)
+			if (row[c])
 			{
 				signed c_res = static_cast<signed>(static_cast<double>(c) + r * theta + 0.5);
-				if (c_res >= 0 && c_res < static_cast<signed>(m.ncol()))
-					sl_corrected[r][c_res] = m[r][c];
+				if (c_res >= 0 && c_res < ncol && c_res != last)
+					r_total += r, c_total += c_res, ++total, last = c_res;
 			}
-	
-	// Step 4. Align with the center of frame
+	}
 
-	unsigned r_total = 0, c_total = 0, total = 0;
-	
-	for (unsigned r = 0; r < sl_corrected.nrow(); ++r)
-		for (unsigned c = 0; c < sl_corrected.ncol(); ++c)
-			if (sl_corrected[r][c])
-				r_total += r, c_total += c, ++total;
+	if (!total)
+		return;
 
 	double r_center = static_cast<double>(r_total);
 	r_center /= total;
@@ -201,19 +174,33 @@ Image slant_correction(const Image & m)
 	signed r_shift = static_cast<signed>(r_center - m.nrow() / 2);
 	signed c_shift = static_cast<signed>(c_center - m.ncol() / 2);
 
-	Image result(m.nrow(), m.ncol());
-	for (unsigned r = 0; r < sl_corrected.nrow(); ++r)
-		for (unsigned c = 0; c < sl_corrected.ncol(); ++c)
-			if (sl_corrected[r][c])
+	// Step 4. Apply correction aligned with the center of frame
+
+	for (signed r = 0; r < nrow; ++r)
+	{
+		signed res_r = r - r_shift;
+		if (res_r < 0 || res_r >= nrow)
+			continue;
+
+		const auto & row = m[r];
+		auto & res_row = result[res_r];
+		for (signed c = 0; c < ncol; ++c)
+			if (row[c])
 			{
-				signed res_r = r - r_shift;
-				signed res_c = c - c_shift;
+				signed c_res = static_cast<signed>(static_cast<double>(c) + r * theta + 0.5);
+				signed res_c = c_res - c_shift;
 
-				if (res_r >= 0 && res_r < static_cast<signed>(result.nrow()) &&
-					res_c >= 0 && res_c < static_cast<signed>(result.ncol()))
-					result[res_r][res_c] = sl_corrected[r][c];
+				if (c_res >= 0 && c_res < ncol && res_c >= 0 && res_c < ncol)
+					res_row[res_c] = row[c];
 			}
+	}
+}
 
+template <class Image>
+Image slant_correction(const Image & m)
+{
+	Image result;
+	slant_correction(m, result);
 	return result;
 }
 
@@ -15,13 +15,19 @@
 #define _STATISTICAL_FEATURES_H_
 #include "LA/matrix.h"
 #include "LA/linear_algebra.h"
+#include "LA/small_matrix.h"
 #include "PR/zoning.h"
+#include "PR/projection_profiles.h"
+#include "PR/radial_histograms.h"
+#include "PR/moments.h"
+#include "PR/moment_invariants.h"
 #include "PR/utils.h"
 
-template <class Image, class Feature>
-vector<Feature> raw_binary_pixels(const Image & image)
+template <class Image, class Feature, class Alloc = allocator<Feature> >
+vector<Feature, Alloc> raw_binary_pixels(const Image & image)
 {
-	vector<Feature> features;
+	vector<Feature, Alloc> features;
+	features.reserve(image.nrow() * image.ncol());
 
 	for (const auto & row : image)
 		features.insert(features.end(), row.begin(), row.end());
@@ -29,227 +35,113 @@ vector<Feature> raw_binary_pixels(const Image & image)
 	return features;
 }
 
-template <class Image, class Feature>
-vector<Feature> histograms(const Image & image, const Matrix<Zone> & zones)
+// For each zone: horizontal, vertical, left-right and right-left diagonal
+// histograms (see PR/projection_profiles.h)
+template <class Image, class Feature, class Alloc = allocator<Feature> >
+vector<Feature, Alloc> histograms(const Image & image, const Matrix<Zone> & zones)
 {
-	vector<Feature> features;
+	vector<Feature, Alloc> features(profiles_size(zones));
+	zone_grid_profiles(image, zones, features.data());
 
-	// Calculate features separately for each zone
-	for (const auto & zones_row : zones)
-		for (const auto & z : zones_row)
-		{
-			unsigned rows = z.rowsEnd() - z.rowsBegin();
-			unsigned cols = z.colsEnd() - z.colsBegin();
-
-			// Extracts vertical and horizontal histograms
-			vector<Feature> vp(cols), hp(rows);
-
-			for (unsigned r = z.rowsBegin(), r_loc = 0; r < z.rowsEnd(); ++r, ++r_loc)
-				for (unsigned c = z.colsBegin(), c_loc = 0; c < z.colsEnd(); ++c, ++c_loc)
-					if (image[r][c])
-						++hp[r_loc], ++vp[c_loc]; 
-
-			features.insert(features.end(), hp.begin(), hp.end());
-			features.insert(features.end(), vp.begin(), vp.end());
-#if 1
-			// Extracts left-right diagonal histograms
-			vector<Feature> lrd(rows + cols - 1);
-			for (unsigned k = 0; k < lrd.size(); ++k)
-			{
-				// Set the break point in intioalization of row idx and col idx
-				// Before break point the driver (i.e. the index defining diagonal)
-				// is row idx, after - col idx
-				// Therefore the break point is defined by rows
-				unsigned bp = rows;
-
-				unsigned r = k < bp ? z.rowsEnd() - k - 1 : z.rowsBegin();
-				unsigned c = k < bp ? z.colsBegin() : z.colsBegin() + k - bp + 1;
-
-				for (; r < z.rowsEnd() && c < z.colsEnd(); ++r, ++c)
-				{
-					if (image[r][c])
-						++lrd[k];
-				}
-			}
-			features.insert(features.end(), lrd.begin(), lrd.end());
-
-			// Extracts right-left diagonal histograms
-			vector<Feature> rld(rows + cols - 1);
-			for (unsigned k = 0; k < rld.size(); ++k)
-			{
-				// Set the break point in intioalization of row idx and col idx
-				// Before break point the driver (i.e. the index defining diagonal)
-				// is col idx, after - row idx
-				// Therefore the break point is defined by cols
-				unsigned bp = cols;
-
-				unsigned r = k < bp ? z.rowsBegin() : z.rowsBegin() + k - bp + 1;
-				unsigned c = k < bp ? z.colsBegin() + k + 1 : z.colsEnd();
-
-				for (; r < z.rowsEnd() && c > z.colsBegin(); ++r, --c)
-				{
-					if (image[r][c - 1])
-						++lrd[k];
-				}
-			}
-
-			features.insert(features.end(), rld.begin(), rld.end());
-#endif
-		}
-	
 	return features;
 }
 
-template <class Image, class Feature>
-vector<Feature> radial_histograms(const Image & img)
+// Counts of black pixels along 4 * granularity rays from the centroid
+// (rounded to pixel), see PR/radial_histograms.h. Zeros for an empty image
+template <class Image, class Feature, class Alloc = allocator<Feature> >
+vector<Feature, Alloc> radial_histograms(const Image & img, unsigned granularity = 8)
 {
-	vector<Feature> features(32);
-
-	unsigned total_r = 0, total_c = 0, total = 0;
+	const RayTable & rays = RayTable::local(img.nrow(), img.ncol(), granularity);
+	vector<Feature, Alloc> features(rays.size());
 
-	for (unsigned r = 0; r < img.nrow(); ++r)
-		for (unsigned c = 0; c < img.ncol(); ++c)
-		{
-			if (img[r][c])
-			{
-				++total;
-				total_r += r;
-				total_c += c;
-			}
-		}
+	Moments m(img);
+	if (!m.count())
+		return features;
 
-	float fmean_r = static_cast<float>(total_r) / total;
-	float fmean_c = static_cast<float>(total_c) / total;
+	unsigned r = static_cast<unsigned>((2 * m.raw(0, 1) + m.count()) / (2 * m.count()));
+	unsigned c = static_cast<unsigned>((2 * m.raw(1, 0) + m.count()) / (2 * m.count()));
+	rays.add(img, r, c, features.data());
 
-	unsigned granularity = 8;
+	return features;
+}
 
-	float step = (float) 1 / granularity;
+// Hu's seven moment invariants, see PR/moment_invariants.h
+template <class Image, class Feature, class Alloc = allocator<Feature> >
+vector<Feature, Alloc> hu_moments(const Image & img)
+{
+	vector<Feature, Alloc> features(7);
+	hu_invariants(Moments(img), features.data());
 
-	for (unsigned k = 0; k < granularity; ++k)
-	{
-		float k_step = k * step;
+	return features;
+}
 
-		for (float r = fmean_r, c = fmean_c; 
-			static_cast<unsigned>(r + 0.5) < img.nrow() && static_cast<unsigned>(c + 0.5) < img.ncol(); 
-			r = r + sqrt(1 - k_step), c = c + sqrt(k_step))
-		{
-			if (img[static_cast<unsigned>(r + 0.5)][static_cast<unsigned>(c + 0.5)])
-				features[k] += 1;
-		}
-	}
+// Magnitudes of Zernike moments up to order, see PR/moment_invariants.h
+template <class Image, class Feature, class Alloc = allocator<Feature> >
+vector<Feature, Alloc> zernike_moments(const Image & img, unsigned order = 8)
+{
+	const ZernikeTable & table = ZernikeTable::local(img.nrow(), img.ncol(), order);
+	vector<Feature, Alloc> features(table.size());
+	table.magnitudes(img, features.data());
 
-	for (unsigned k = 0; k < granularity; ++k)
-	{
-		float k_step = k * step;
+	return features;
+}
 
-		for (float r = fmean_r, c = fmean_c; 
-			static_cast<unsigned>(r + 0.5) < img.nrow() && static_cast<signed>(c + 0.5) >= 0; 
-			r = r + sqrt(1 - k_step), c = c - sqrt(k_step))
-		{
-			if (img[static_cast<unsigned>(r + 0.5)][static_cast<unsigned>(c + 0.5)])
-				features[k + granularity] += 1;
-		}
-	}
+/**
+ Codes of contour pixels are counted for 64 pixels at once: pixels
+ outside of packed image are white, so no frame is needed
+ */
+template <class Image, class Feature, class Alloc = allocator<Feature> >
+vector<Feature, Alloc> chain_codes(const Image & img, PackedScratch & scratch)
+{
+	typedef PackedImage::Word Word;
+	typedef PackedNeighbours PN;
 
-	for (unsigned k = 0; k < granularity; ++k)
-	{
-		float k_step = k * step;
+	PackedImage & contour = scratch.image;
+	contour.assign(img);
 
-		for (float r = fmean_r, c = fmean_c; 
-			static_cast<signed>(r + 0.5) >= 0 && static_cast<unsigned>(c + 0.5) < img.ncol(); 
-			r = r - sqrt(1 - k_step), c = c + sqrt(k_step))
+	unsigned codes[8] = { 0 };
+	for (unsigned r = 0; r < contour.nrow(); ++r)
+		for (unsigned w = 0; w < contour.words(); ++w)
 		{
-			if (img[static_cast<unsigned>(r + 0.5)][static_cast<unsigned>(c + 0.5)])
-				features[k + (granularity * 2)] += 1;
-		}
-	}
+			Word p = contour[r][w];
+			if (!p)
+				continue;
 
-	for (unsigned k = 0; k < granularity; ++k)
-	{
-		float k_step = k * step;
+			PackedNeighbours n(contour, r, w);
 
-		for (float r = fmean_r, c = fmean_c; 
-			static_cast<signed>(r + 0.5) >= 0 && static_cast<signed>(c + 0.5) >= 0; 
-			r = r - sqrt(1 - k_step), c = c - sqrt(k_step))
-		{
-			if (img[static_cast<unsigned>(r + 0.5)][static_cast<unsigned>(c + 0.5)])
-				features[k + (granularity * 3)] += 1;
-		}
-	}
+			Word e = p & ~n[PN::E];
+			codes[1] += popcount(e & n[PN::NE]);
+			codes[2] += popcount(e & ~n[PN::NE] & n[PN::N]);
 
-	return features;
-}
+			Word north = p & ~n[PN::N];
+			codes[3] += popcount(north & n[PN::NW]);
+			codes[4] += popcount(north & ~n[PN::NW] & n[PN::W]);
 
-template <class Image, class Feature>
-vector<Feature> _chain_codes(const Image & contour)
-{
-	vector<Feature> codes(8);
+			Word west = p & ~n[PN::W];
+			codes[5] += popcount(west & n[PN::SW]);
+			codes[6] += popcount(west & ~n[PN::SW] & n[PN::S]);
 
-	for (unsigned r = 1; r < contour.nrow() - 1; ++r)
-		for (unsigned c = 1; c < contour.ncol() - 1; ++c)
-		{
-			if (!contour[r][c])
-				continue;
-			
-			if (!contour[r][c + 1])
-			{
-				if (contour[r - 1][c + 1])
-					codes[1] += 1;
-				else if (contour[r - 1][c])
-					codes[2] += 1;
-			}
-			if (!contour[r - 1][c])
-			{
-				if (contour[r - 1][c - 1])
-					codes[3] += 1;
-				else if (contour[r][c - 1])
-					codes[4] += 1;
-			}
-			if (!contour[r][c - 1])
-			{
-				if (contour[r + 1][c - 1])
-					codes[5] += 1;
-				else if (contour[r + 1][c])
-					codes[6] += 1;
-			}
-			if (!contour[r + 1][c])
-			{
-				if (contour[r + 1][c + 1])
-					codes[7] += 1;
-				else if (contour[r][c + 1])
-					codes[0] += 1;
-			}
+			Word south = p & ~n[PN::S];
+			codes[7] += popcount(south & n[PN::SE]);
+			codes[0] += popcount(south & ~n[PN::SE] & n[PN::E]);
 		}
 
-	return codes;
+	return vector<Feature, Alloc>(codes, codes + 8);
 }
 
-template <class Image, class Feature>
-vector<Feature> chain_codes(const Image & img)
+template <class Image, class Feature, class Alloc = allocator<Feature> >
+vector<Feature, Alloc> chain_codes(const Image & img)
 {
-	bool frame = true;
-	for (unsigned c = 0; frame && c < img.ncol(); ++c)
-		if (img[0][c] || img[img.nrow() - 1][c])
-			frame = false;
-
-	for (unsigned r = 0; frame && r < img.nrow(); ++r)
-		if (img[r][0] || img[r][img.ncol() - 1])
-			frame = false;
-
-	if (frame)
-		return _chain_codes<Image, Feature>(img);
-
-	Image framed = make_frame(img);
-	
-	return _chain_codes<Image, Feature>(framed);
+	PackedScratch scratch;
+	return chain_codes<Image, Feature, Alloc>(img, scratch);
 }
 
 // For each zone in zones, calculates distance from global centroid to zone's centroid 
 // Each distance to local centroid is accompanied by the number of black pixels in that zone
-template <class Image, class Feature>
-vector<Feature> fourier_centroid_distances(const Image & contour, const Matrix<Zone> & zones)
+template <class Image, class Feature, class Alloc = allocator<Feature> >
+vector<Feature, Alloc> fourier_centroid_distances(const Image & contour, const Matrix<Zone> & zones)
 {
-	vector<Feature> retval(zones.nrow() * zones.ncol() * 2);
+	vector<Feature, Alloc> retval(zones.nrow() * zones.ncol() * 2);
 
 	unsigned x_acc = 0, y_acc = 0, total = 0;
 	
@@ -262,11 +154,7 @@ vector<Feature> fourier_centroid_distances(const Image & contour, const Matrix<Z
 	if (!total)
 		return retval;
 
-	float x_centr = static_cast<float>(x_acc) / total;
-	float y_centr = static_cast<float>(y_acc) / total;
-
-	vector<float> centr(2);
-	centr[0] = x_centr, centr[1] = y_centr;
+	SmallVector<float, 2> centr = { static_cast<float>(x_acc) / total, static_cast<float>(y_acc) / total };
 
 	// offset in the retval
 	unsigned zone_offset = 0;
@@ -287,12 +175,8 @@ vector<Feature> fourier_centroid_distances(const Image & contour, const Matrix<Z
 			// This zone is empty
 			if (!total_z) continue;
 
-			float zx_centr = static_cast<float>(zx_acc) / total_z;
-			float zy_centr = static_cast<float>(zy_acc) / total_z;
+			SmallVector<float, 2> centr_z = { static_cast<float>(zx_acc) / total_z, static_cast<float>(zy_acc) / total_z };
 
-			vector<float> centr_z(2);
-			centr_z[0] = zx_centr, centr_z[1] = zy_centr;
-	
 			float dist_z = square_dist(centr, centr_z);
 			retval[zone_offset] = dist_z;
 			retval[zone_offset + 1] = static_cast<float>(total_z);
@@ -308,25 +192,34 @@ float label(const T & r)
 	return static_cast<float>(r > 0 ? 1 : 0);
 }
 
-template <class Image, class Feature>
-vector<Feature> covarience(const Image & img)
+template <class Image, class Feature, class Alloc = allocator<Feature> >
+vector<Feature, Alloc> covarience(const Image & img)
 {
-	// Create matrix of pixel coordinates 
-	Matrix<Feature> pixels;
+	// Accumulate first and second moments of pixel coordinates
+	// (instead of building matrix of coordinates)
+	unsigned total = 0;
+	SmallVector<double, 2> sum;
+	SmallMatrix<double, 2, 2> moments;
+
 	for (unsigned r = 0; r < img.nrow(); ++r)
 		for (unsigned c = 0; c < img.ncol(); ++c)
 			if (img[r][c])
 			{
-				vector<Feature> pixel(2);
-				pixel[0] = static_cast<Feature>(r), pixel[1] = static_cast<Feature>(c);
-				pixels.add_row(pixel);
+				SmallVector<double, 2> pixel = { static_cast<double>(r), static_cast<double>(c) };
+				sum += pixel;
+				moments += outer_product(pixel, pixel);
+				++total;
 			}
 
-	// Get covariance (2x2 matrix)
-	Matrix<Feature> c = cov(pixels);
+	if (!total)
+		return vector<Feature, Alloc>(3, 0);
+
+	// Covariance (2x2 matrix): E[pp^t] - mm^t
+	SmallVector<double, 2> mean = sum / total;
+	SmallMatrix<double, 2, 2> c = moments / total - outer_product(mean, mean);
 
 	// Put down to the feature vector (only 3 features since c is symmetric)
-	vector<Feature> features = { c[0][0], c[0][1], c[1][1] };
+	vector<Feature, Alloc> features = { static_cast<Feature>(c[0][0]), static_cast<Feature>(c[0][1]), static_cast<Feature>(c[1][1]) };
 
 	return features;
 }
@@ -0,0 +1,386 @@
+/*                                                                 -*- C++ -*-
+ * File: graph_based_thinning_tests.cpp
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Boost unit tests for graph based thinning
+ *
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <iostream>
+#include <cstdlib>
+
+#include "PR/binary_graph.h"
+#include "PR/graph_based_thinning.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+/**
+ 20 circle edges by scan of the whole graph
+ (as get20CircleEdges used to do)
+ */
+Edges reference_20_circle_edges(const Edges & edges, const Node & node)
+{
+	Edges result(20);
+
+	Nodes adjacent(8);
+	for (unsigned i = 0; i < 8; ++i)
+		adjacent[i] = node.adjacent(i);
+
+	for (Edges::const_iterator it = edges.begin(), itEnd = edges.end(); it != itEnd; ++it)
+	{
+		const Edge & e = *it;
+
+		if (e.src() == node)
+			result[node.getAdjacentCode(e.dest())] = e;
+		else if (e.dest() == node)
+			result[node.getAdjacentCode(e.src())] = e;
+		else if (e.src() == adjacent[0] && e.dest() == adjacent[1])
+			result[8] = e;
+		else if (e.src() == adjacent[1] && e.dest() == adjacent[2])
+			result[9] = e;
+		else if (e.src() == adjacent[2] && e.dest() == adjacent[3])
+			result[10] = e;
+		else if (e.src() == adjacent[4] && e.dest() == adjacent[3])
+			result[11] = e;
+		else if (e.src() == adjacent[5] && e.dest() == adjacent[4])
+			result[12] = e;
+		else if (e.src() == adjacent[6] && e.dest() == adjacent[5])
+			result[13] = e;
+		else if (e.src() == adjacent[7] && e.dest() == adjacent[6])
+			result[14] = e;
+		else if (e.src() == adjacent[7] && e.dest() == adjacent[0])
+			result[15] = e;
+		else if (e.src() == adjacent[0] && e.dest() == adjacent[2])
+			result[16] = e;
+		else if (e.src() == adjacent[4] && e.dest() == adjacent[2])
+			result[17] = e;
+		else if (e.src() == adjacent[6] && e.dest() == adjacent[4])
+			result[18] = e;
+		else if (e.src() == adjacent[6] && e.dest() == adjacent[0])
+			result[19] = e;
+	}
+
+	return result;
+}
+
+/**
+ Rules S1-S5 of delete_intersections written out for intersection
+ (e[a], e[d]) with sides e[s0], e[s1] and circle edges e[c0], e[c1],
+ neighbours n[a - 1], n[a], n[a + 1]. Counts matches of each rule
+ */
+bool reference_delete_intersections(const Nodes & nodes, Edges & edges, vector<unsigned> & hits)
+{
+	vector<Edge> to_add;
+	vector<Edge> to_remove;
+
+	for (Nodes::const_iterator it = nodes.begin(), itEnd = nodes.end(); it != itEnd; ++it)
+	{
+		const Node & curr = *it;
+		Nodes n = nodes.getNeighbours(curr);
+		Edges e = reference_20_circle_edges(edges, curr);
+
+		for (unsigned r = 0; r < 4; ++r)
+		{
+			unsigned a = 2 * r + 1, s0 = 2 * r, s1 = (2 * r + 2) % 8, c0 = 8 + 2 * r, c1 = 9 + 2 * r, d = 16 + r;
+			if (!n[s0].exist() || !n[a].exist() || !n[s1].exist())
+				continue;
+
+			// Rule S1
+			if (e[a].exist() && e[d].exist() && !e[s0].exist() && !e[s1].exist() && !e[c0].exist() && !e[c1].exist())
+			{
+				to_remove.push_back(e[d]);
+				to_add.push_back(Edges::get20CircleEdge(curr, c0));
+				to_add.push_back(Edges::get20CircleEdge(curr, c1));
+				++hits[5 * r];
+			}
+
+			// Rule S2
+			if (e[a].exist() && e[s1].exist() && e[d].exist() && !e[s0].exist() && !e[c0].exist() && !e[c1].exist())
+			{
+				to_remove.push_back(e[a]);
+				to_add.push_back(Edges::get20CircleEdge(curr, c1));
+				++hits[5 * r + 1];
+			}
+
+			// Rule S3
+			if (e[a].exist() && e[c0].exist() && e[d].exist() && !e[s0].exist() && !e[s1].exist() && !e[c1].exist())
+			{
+				to_remove.push_back(e[d]);
+				to_add.push_back(Edges::get20CircleEdge(curr, c1));
+				++hits[5 * r + 2];
+			}
+
+			// Rule S4
+			if (e[a].exist() && e[c1].exist() && e[d].exist() && !e[s0].exist() && !e[s1].exist() && !e[c0].exist())
+			{
+				to_remove.push_back(e[d]);
+				to_add.push_back(Edges::get20CircleEdge(curr, c0));
+				++hits[5 * r + 3];
+			}
+
+			// Rule S5
+			if (e[s0].exist() && e[a].exist() && e[d].exist() && !e[s1].exist() && !e[c0].exist() && !e[c1].exist())
+			{
+				to_remove.push_back(e[a]);
+				to_add.push_back(Edges::get20CircleEdge(curr, c0));
+				++hits[5 * r + 4];
+			}
+		}
+	}
+
+	make_vector_set(to_remove);
+	edges.remove(to_remove);
+	edges.add(to_add);
+
+	return to_remove.size() > 0;
+}
+
+// Random image (with empty border) and its graph with part of edges removed
+void random_graph(unsigned size, Nodes & nodes, Edges & edges)
+{
+	Matrix<int> img(size, size, 0);
+	for (unsigned i = 1; i + 1 < size; ++i)
+		for (unsigned j = 1; j + 1 < size; ++j)
+			img[i][j] = rand() % 4 != 0;
+
+	nodes = Nodes(img);
+	edges = Edges(img);
+
+	Edges kept;
+	for (Edges::const_iterator it = edges.begin(), itEnd = edges.end(); it != itEnd; ++it)
+		if (rand() % 5 < 2)
+			kept.push_back(*it);
+	edges.swap(kept);
+}
+
+void circle_edges_test()
+{
+	srand(7);
+	for (unsigned t = 0; t < 50; ++t)
+	{
+		Nodes nodes;
+		Edges edges;
+		random_graph(12, nodes, edges);
+
+		for (Nodes::const_iterator it = nodes.begin(), itEnd = nodes.end(); it != itEnd; ++it)
+		{
+			BOOST_REQUIRE(edges.get20CircleEdges(*it) == reference_20_circle_edges(edges, *it));
+
+			Nodes n = nodes.getNeighbours(*it);
+			unsigned mask = 0;
+			for (unsigned k = 0; k < 8; ++k)
+				if (n[k].exist())
+					mask |= 1u << k;
+			BOOST_REQUIRE(nodes.getNeighboursMask(*it) == mask);
+		}
+	}
+}
+
+void delete_intersections_test()
+{
+	srand(11);
+	vector<unsigned> hits(20, 0);
+	for (unsigned t = 0; t < 500; ++t)
+	{
+		Nodes nodes;
+		Edges edges;
+		random_graph(12, nodes, edges);
+		Edges reference(edges);
+
+		// Until no more intersections
+		for (unsigned round = 0; round < 10; ++round)
+		{
+			bool removed = reference_delete_intersections(nodes, reference, hits);
+			BOOST_REQUIRE(delete_intersections(nodes, edges) == removed);
+			BOOST_REQUIRE(edges == reference);
+			if (!removed)
+				break;
+		}
+	}
+
+	// Each rule was checked
+	for (unsigned k = 0; k < hits.size(); ++k)
+		BOOST_REQUIRE(hits[k] > 0);
+}
+
+void delete_intersections_s3_test()
+{
+	// Intersection (e[7], e[19]) of node (2,2): rule S3 with e[14] replaces 
+	// e[19] by e[15]. Neighbour n[0] sees the same intersection as its 
+	// (e[5], e[18]): rule S4 with e[13] replaces e[7] by e[6]
+	Node c(2, 2);
+	Nodes nodes;
+	nodes.push_back(c.adjacent(7));
+	nodes.push_back(c.adjacent(6));
+	nodes.push_back(c.adjacent(0));
+	nodes.push_back(c);
+	std::sort(nodes.begin(), nodes.end());
+
+	Edges edges;
+	edges.push_back(Edges::get20CircleEdge(c, 7));
+	edges.push_back(Edges::get20CircleEdge(c, 14));
+	edges.push_back(Edges::get20CircleEdge(c, 19));
+	std::sort(edges.begin(), edges.end());
+
+	BOOST_REQUIRE(delete_intersections(nodes, edges));
+
+	Edges expected;
+	expected.push_back(Edges::get20CircleEdge(c, 6));
+	expected.push_back(Edges::get20CircleEdge(c, 14));
+	expected.push_back(Edges::get20CircleEdge(c, 15));
+	std::sort(expected.begin(), expected.end());
+
+	BOOST_REQUIRE(edges == expected);
+	BOOST_REQUIRE(!delete_intersections(nodes, edges));
+}
+
+/**
+ delete_extra_diag_edges and delete_extra_vert_and_hor_edges written
+ out over circle edges found by scan of the whole graph
+ */
+void reference_delete_extra_edges(const Nodes & nodes, Edges & edges, bool diagonal)
+{
+	vector<Edge> to_remove;
+
+	for (Nodes::const_iterator it = nodes.begin(), itEnd = nodes.end(); it != itEnd; ++it)
+	{
+		Edges e = reference_20_circle_edges(edges, *it);
+
+		for (unsigned r = 0; r < 4; ++r)
+		{
+			// Sides (2r, 2r + 2) around diagonal edge 16 + r (circle edges 8 + 2r, 9 + 2r)
+			unsigned s0 = 2 * r, s1 = (2 * r + 2) % 8, d = 16 + r;
+
+			if (diagonal)
+			{
+				if (e[8 + 2 * r].exist() && e[9 + 2 * r].exist() && e[d].exist() && (!e[s0].exist() || !e[s1].exist()))
+					to_remove.push_back(e[d]);
+				continue;
+			}
+
+			// Side with diagonal edge and the other side of the triangle, then
+			// pairs of edges of which one has to exist to keep the side (as listed
+			// in delete_extra_vert_and_hor_edges)
+			static const unsigned rules[4][9] = {
+				{ 2, 16, 1, 11, 17, 11, 12, 10, 17 },
+				{ 4, 17, 3, 5, 18, 5, 6, 12, 18 },
+				{ 6, 18, 5, 7, 19, 7, 8, 14, 19 },
+				{ 0, 19, 7, 9, 16, 9, 10, 8, 16 }
+			};
+
+			const unsigned * rule = rules[r];
+			if (e[rule[0]].exist() && e[rule[1]].exist() && e[rule[2]].exist())
+				if ((!e[rule[3]].exist() && !e[rule[4]].exist()) ||
+					(!e[rule[5]].exist() && !e[rule[6]].exist()) ||
+					(!e[rule[7]].exist() && !e[rule[8]].exist()))
+					to_remove.push_back(e[rule[0]]);
+		}
+	}
+
+	make_vector_set(to_remove);
+	edges.remove(to_remove);
+}
+
+// Node c and its neighbours of given codes
+Nodes neighbourhood(const Node & c, const vector<unsigned> & codes)
+{
+	Nodes nodes;
+	nodes.push_back(c);
+	for (unsigned k : codes)
+		nodes.push_back(c.adjacent(k));
+	std::sort(nodes.begin(), nodes.end());
+
+	return nodes;
+}
+
+// Circle edges of c of given numbers
+Edges circle_edges(const Node & c, const vector<unsigned> & ks)
+{
+	Edges edges;
+	for (unsigned k : ks)
+		edges.push_back(Edges::get20CircleEdge(c, k));
+	std::sort(edges.begin(), edges.end());
+
+	return edges;
+}
+
+void delete_extra_edges_test()
+{
+	srand(13);
+	for (unsigned t = 0; t < 300; ++t)
+	{
+		Nodes nodes;
+		Edges edges;
+		random_graph(12, nodes, edges);
+
+		for (unsigned diagonal = 0; diagonal < 2; ++diagonal)
+		{
+			Edges reference(edges), result(edges);
+			reference_delete_extra_edges(nodes, reference, diagonal != 0);
+			if (diagonal)
+				delete_extra_diag_edges(nodes, result);
+			else
+				delete_extra_vert_and_hor_edges(nodes, result);
+
+			BOOST_REQUIRE(result == reference);
+		}
+	}
+}
+
+void edge_18_test()
+{
+	// Circle edge 18 (n[6] -> n[4]) used to be looked up as n[6] -> n[6], so
+	// it never existed for the passes below. Each case is a rule which did
+	// not fire then, or fired only because edge 18 was missing
+	Node c(3, 3);
+
+	// Triangle n[4], n[5], n[6] without sides 4 and 6: edge 18 is extra
+	Nodes nodes = neighbourhood(c, { 4, 5, 6 });
+	Edges edges = circle_edges(c, { 12, 13, 18 });
+	delete_extra_diag_edges(nodes, edges);
+	BOOST_REQUIRE(edges == circle_edges(c, { 12, 13 }));
+
+	// Same with both sides: edge 18 is kept
+	edges = circle_edges(c, { 4, 6, 12, 13, 18 });
+	delete_extra_diag_edges(nodes, edges);
+	BOOST_REQUIRE(edges == circle_edges(c, { 4, 6, 12, 13, 18 }));
+
+	// Side 6 is extra along edge 18 and side 5
+	nodes = neighbourhood(c, { 4, 5, 6 });
+	edges = circle_edges(c, { 5, 6, 18 });
+	delete_extra_vert_and_hor_edges(nodes, edges);
+	BOOST_REQUIRE(edges == circle_edges(c, { 5, 18 }));
+
+	// Side 4 along edge 17 and side 3 is kept: edges 6, 12 and 18 connect
+	// n[4] with n[5] and n[6] (it was removed when edge 18 was missing)
+	nodes = neighbourhood(c, { 2, 3, 4, 5, 6 });
+	edges = circle_edges(c, { 3, 4, 6, 12, 17, 18 });
+	Edges expected(edges);
+	delete_extra_vert_and_hor_edges(nodes, edges);
+	BOOST_REQUIRE(edges == expected);
+
+	// Without edge 18 side 4 is removed
+	edges = circle_edges(c, { 3, 4, 6, 12, 17 });
+	delete_extra_vert_and_hor_edges(nodes, edges);
+	BOOST_REQUIRE(edges == circle_edges(c, { 3, 6, 12, 17 }));
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+	test_suite* test = BOOST_TEST_SUITE("Graph based thinning test suite");
+
+	test->add(BOOST_TEST_CASE(&circle_edges_test));
+	test->add(BOOST_TEST_CASE(&delete_intersections_test));
+	test->add(BOOST_TEST_CASE(&delete_intersections_s3_test));
+	test->add(BOOST_TEST_CASE(&delete_extra_edges_test));
+	test->add(BOOST_TEST_CASE(&edge_18_test));
+
+	return test;
+}
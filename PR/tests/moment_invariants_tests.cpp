@@ -0,0 +1,235 @@
+/*                                                                 -*- C++ -*-
+ * File: moment_invariants_tests.cpp
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Boost unit tests for Hu's invariants and Zernike moments:
+ *   direct evaluation of definitions and invariance to rotation,
+ *   translation and scale
+ *
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "LA/matrix.h"
+#include "PR/statistical_features.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+typedef Matrix<uint8_t> Image;
+
+Image random_image(unsigned nrow, unsigned ncol, unsigned density)
+{
+	Image img(nrow, ncol, 0);
+	for (unsigned r = 0; r < nrow; ++r)
+		for (unsigned c = 0; c < ncol; ++c)
+			img[r][c] = density && rand() % density == 0 ? 255 : 0;
+
+	return img;
+}
+
+// Rotated by 90 degrees clockwise
+Image rotate(const Image & img)
+{
+	Image rotated(img.ncol(), img.nrow(), 0);
+	for (unsigned r = 0; r < img.nrow(); ++r)
+		for (unsigned c = 0; c < img.ncol(); ++c)
+			rotated[c][img.nrow() - 1 - r] = img[r][c];
+
+	return rotated;
+}
+
+// Largest difference relative to the largest expected value
+double relative_error(const vector<double> & actual, const vector<double> & expected)
+{
+	BOOST_REQUIRE(actual.size() == expected.size());
+
+	double error = 0, scale = 1e-12;
+	for (unsigned k = 0; k < actual.size(); ++k)
+	{
+		error = max(error, fabs(actual[k] - expected[k]));
+		scale = max(scale, fabs(expected[k]));
+	}
+
+	return error / scale;
+}
+
+double factorial(unsigned n)
+{
+	double v = 1;
+	for (unsigned k = 2; k <= n; ++k)
+		v *= k;
+
+	return v;
+}
+
+// |A(n, m)| summed pixel by pixel with complex exponentials
+vector<double> direct_zernike(const Image & img, unsigned order)
+{
+	unsigned nrow = img.nrow(), ncol = img.ncol();
+	double diameter = sqrt(static_cast<double>(nrow) * nrow + static_cast<double>(ncol) * ncol);
+	double pi = acos(-1.0);
+
+	vector<double> magnitudes;
+	for (unsigned n = 0; n <= order; ++n)
+		for (unsigned m = n % 2; m <= n; m += 2)
+		{
+			complex<double> a = 0;
+			for (unsigned r = 0; r < nrow; ++r)
+				for (unsigned c = 0; c < ncol; ++c)
+					if (img[r][c])
+					{
+						double x = (2.0 * c + 1 - ncol) / diameter;
+						double y = (2.0 * r + 1 - nrow) / diameter;
+						double rho = sqrt(x * x + y * y);
+
+						double radial = 0;
+						for (unsigned s = 0; s <= (n - m) / 2; ++s)
+							radial += (s % 2 ? -1 : 1) * factorial(n - s) /
+								(factorial(s) * factorial((n + m) / 2 - s) * factorial((n - m) / 2 - s)) * pow(rho, n - 2.0 * s);
+
+						a += radial * polar(1.0, -(m * atan2(y, x)));
+					}
+
+			magnitudes.push_back(abs(a) * (n + 1) / pi * 4 / (diameter * diameter));
+		}
+
+	return magnitudes;
+}
+
+// Hu's invariants from central moments summed pixel by pixel
+vector<double> direct_hu(const Image & img)
+{
+	vector<double> hu(7, 0.0);
+
+	double count = 0, x_sum = 0, y_sum = 0;
+	for (unsigned r = 0; r < img.nrow(); ++r)
+		for (unsigned c = 0; c < img.ncol(); ++c)
+			if (img[r][c])
+				count += 1, x_sum += c, y_sum += r;
+
+	if (!count)
+		return hu;
+
+	double eta[4][4] = { { 0 } };
+	for (unsigned p = 0; p < 4; ++p)
+		for (unsigned q = 0; p + q < 4; ++q)
+		{
+			double mu = 0;
+			for (unsigned r = 0; r < img.nrow(); ++r)
+				for (unsigned c = 0; c < img.ncol(); ++c)
+					if (img[r][c])
+						mu += pow(c - x_sum / count, static_cast<double>(p)) * pow(r - y_sum / count, static_cast<double>(q));
+
+			eta[p][q] = mu / pow(count, 1 + (p + q) / 2.0);
+		}
+
+	double n20 = eta[2][0], n02 = eta[0][2], n11 = eta[1][1];
+	double n30 = eta[3][0], n03 = eta[0][3], n21 = eta[2][1], n12 = eta[1][2];
+
+	hu[0] = n20 + n02;
+	hu[1] = (n20 - n02) * (n20 - n02) + 4 * n11 * n11;
+	hu[2] = (n30 - 3 * n12) * (n30 - 3 * n12) + (3 * n21 - n03) * (3 * n21 - n03);
+	hu[3] = (n30 + n12) * (n30 + n12) + (n21 + n03) * (n21 + n03);
+	hu[4] = (n30 - 3 * n12) * (n30 + n12) * ((n30 + n12) * (n30 + n12) - 3 * (n21 + n03) * (n21 + n03)) +
+		(3 * n21 - n03) * (n21 + n03) * (3 * (n30 + n12) * (n30 + n12) - (n21 + n03) * (n21 + n03));
+	hu[5] = (n20 - n02) * ((n30 + n12) * (n30 + n12) - (n21 + n03) * (n21 + n03)) + 4 * n11 * (n30 + n12) * (n21 + n03);
+	hu[6] = (3 * n21 - n03) * (n30 + n12) * ((n30 + n12) * (n30 + n12) - 3 * (n21 + n03) * (n21 + n03)) -
+		(n30 - 3 * n12) * (n21 + n03) * (3 * (n30 + n12) * (n30 + n12) - (n21 + n03) * (n21 + n03));
+
+	return hu;
+}
+
+void zernike_test()
+{
+	srand(11);
+
+	for (unsigned t = 0; t < 100; ++t)
+	{
+		unsigned nrow = 1 + rand() % 24, ncol = 1 + rand() % 24, order = rand() % 11;
+		Image img = random_image(nrow, ncol, rand() % 4);
+
+		vector<double> z = zernike_moments<Image, double>(img, order);
+		BOOST_REQUIRE(z.size() == (order / 2 + 1) * (order - order / 2 + 1));
+		BOOST_REQUIRE(relative_error(z, direct_zernike(img, order)) < 1e-10);
+
+		// Rotation by 90 degrees about the image centre
+		BOOST_REQUIRE(relative_error(zernike_moments<Image, double>(rotate(img), order), z) < 1e-10);
+	}
+
+	// Moments of all orders are in the table
+	ZernikeTable table(5, 7, 4);
+	BOOST_REQUIRE(table.size() == 9);
+	for (unsigned k = 0; k < table.size(); ++k)
+		BOOST_REQUIRE(table.m(k) <= table.n(k) && (table.n(k) - table.m(k)) % 2 == 0);
+
+	// Empty image
+	BOOST_REQUIRE((zernike_moments<Image, double>(Image(5, 7, 0), 4) == vector<double>(9, 0.0)));
+}
+
+void hu_test()
+{
+	srand(13);
+
+	for (unsigned t = 0; t < 100; ++t)
+	{
+		unsigned nrow = 1 + rand() % 24, ncol = 1 + rand() % 24;
+		Image img = random_image(nrow, ncol, rand() % 4);
+
+		vector<double> hu = hu_moments<Image, double>(img);
+		BOOST_REQUIRE(relative_error(hu, direct_hu(img)) < 1e-10);
+
+		// Rotation by 90 degrees
+		BOOST_REQUIRE(relative_error(hu_moments<Image, double>(rotate(img)), hu) < 1e-10);
+
+		// Translation
+		Image shifted(nrow + 7, ncol + 3, 0);
+		for (unsigned r = 0; r < nrow; ++r)
+			for (unsigned c = 0; c < ncol; ++c)
+				shifted[r + 5][c + 1] = img[r][c];
+
+		BOOST_REQUIRE(relative_error(hu_moments<Image, double>(shifted), hu) < 1e-10);
+	}
+
+	// Scale: each pixel becomes 3 x 3 block, discrete moments of blocks
+	// differ slightly from those of the continuous shape
+	Image img(12, 12, 0);
+	for (unsigned r = 2; r < 10; ++r)
+	{
+		img[r][3] = img[r][4] = 255;
+		img[2][r] = img[9][r - 2] = 255;
+	}
+
+	Image scaled(36, 36, 0);
+	for (unsigned r = 0; r < 36; ++r)
+		for (unsigned c = 0; c < 36; ++c)
+			scaled[r][c] = img[r / 3][c / 3];
+
+	vector<double> hu = hu_moments<Image, double>(img);
+	vector<double> hu_scaled = hu_moments<Image, double>(scaled);
+	for (unsigned k = 0; k < 2; ++k)
+		BOOST_REQUIRE(fabs(hu_scaled[k] - hu[k]) < 0.02 * hu[k]);
+
+	// Empty image
+	BOOST_REQUIRE((hu_moments<Image, double>(Image(4, 4, 0)) == vector<double>(7, 0.0)));
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+	test_suite* test = BOOST_TEST_SUITE("Moment invariants test suite");
+
+	test->add(BOOST_TEST_CASE(&zernike_test));
+	test->add(BOOST_TEST_CASE(&hu_test));
+
+	return test;
+}
@@ -0,0 +1,168 @@
+/*                                                                 -*- C++ -*-
+ * File: moments_tests.cpp
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Boost unit tests for geometric moments and slant correction
+ *
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+
+#include "LA/matrix.h"
+#include "PR/moments.h"
+#include "PR/slant_correction.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+typedef Matrix<uint8_t> Image;
+
+Image random_image(unsigned nrow, unsigned ncol, unsigned density)
+{
+	Image img(nrow, ncol, 0);
+	for (unsigned r = 0; r < nrow; ++r)
+		for (unsigned c = 0; c < ncol; ++c)
+			img[r][c] = rand() % 100 < density ? 255 : 0;
+
+	return img;
+}
+
+bool is_white(const Image & img)
+{
+	for (unsigned r = 0; r < img.nrow(); ++r)
+		for (unsigned c = 0; c < img.ncol(); ++c)
+			if (img[r][c])
+				return false;
+
+	return true;
+}
+
+void moments_test()
+{
+	srand(3);
+
+	for (unsigned t = 0; t < 200; ++t)
+	{
+		unsigned nrow = 1 + rand() % 40, ncol = 1 + rand() % 40;
+		Image img = random_image(nrow, ncol, rand() % 60);
+		Moments moments(img);
+
+		// Raw moments are exact
+		for (unsigned p = 0; p <= Moments::MAX_ORDER; ++p)
+			for (unsigned q = 0; p + q <= Moments::MAX_ORDER; ++q)
+				BOOST_REQUIRE(static_cast<double>(moments.raw(p, q)) == moment(img, p, q));
+
+		if (!moments.count())
+			continue;
+
+		// About the rounded centroid (as used by slant correction) and any pixel
+		unsigned centres[2][2] = {
+			{ static_cast<unsigned>(moments.x_center() + 0.5), static_cast<unsigned>(moments.y_center() + 0.5) },
+			{ static_cast<unsigned>(rand() % ncol), static_cast<unsigned>(rand() % nrow) }
+		};
+
+		for (const auto & centre : centres)
+			for (unsigned p = 0; p <= Moments::MAX_ORDER; ++p)
+				for (unsigned q = 0; p + q <= Moments::MAX_ORDER; ++q)
+				{
+					double expected = central_moment(img, centre[0], centre[1], p, q);
+					double scale = max(1.0, moment(img, p, q));
+					BOOST_REQUIRE(fabs(moments.central(p, q, centre[0], centre[1]) - expected) <= 1e-12 * scale);
+				}
+
+		// About the centroid: first order moments vanish
+		BOOST_REQUIRE(fabs(moments.central(1, 0)) < 1e-9 * max(1.0, moment(img, 1, 0)));
+		BOOST_REQUIRE(fabs(moments.central(0, 1)) < 1e-9 * max(1.0, moment(img, 0, 1)));
+	}
+
+	// Row by row accumulation gives the same moments
+	Image img = random_image(20, 30, 30);
+	Moments by_rows;
+	for (unsigned y = 0; y < img.nrow(); ++y)
+		by_rows.add_row(img[y], img.ncol(), y);
+
+	Moments whole(img);
+	for (unsigned p = 0; p <= Moments::MAX_ORDER; ++p)
+		for (unsigned q = 0; p + q <= Moments::MAX_ORDER; ++q)
+			BOOST_REQUIRE(by_rows.raw(p, q) == whole.raw(p, q));
+}
+
+void empty_image_test()
+{
+	Image empty(8, 10, 0);
+
+	Moments moments(empty);
+	BOOST_REQUIRE(moments.count() == 0);
+
+	Image result = moment_based_normalization(empty);
+	BOOST_REQUIRE(result.nrow() == 8 && result.ncol() == 10 && is_white(result));
+
+	result = slant_correction(empty);
+	BOOST_REQUIRE(result.nrow() == 8 && result.ncol() == 10 && is_white(result));
+
+	// Result of previous image is cleared
+	Image full(8, 10, 255);
+	result = full;
+	moment_based_normalization(empty, result);
+	BOOST_REQUIRE(is_white(result));
+
+	result = full;
+	slant_correction(empty, result);
+	BOOST_REQUIRE(is_white(result));
+}
+
+void single_row_test()
+{
+	// Black pixels in a single row have no slant (both corrections used to
+	// divide 0 by 0 there)
+	Image img(8, 10, 0);
+	for (unsigned c = 2; c <= 6; ++c)
+		img[3][c] = 255;
+
+	// Moment based correction keeps the image
+	Image result = moment_based_normalization(img);
+	BOOST_REQUIRE(result == img);
+
+	// Slant correction keeps the row and centres it: centroid (3, 4)
+	// moves to (4, 5)
+	Image expected(8, 10, 0);
+	for (unsigned c = 3; c <= 7; ++c)
+		expected[4][c] = 255;
+
+	result = slant_correction(img);
+	BOOST_REQUIRE(result == expected);
+
+	// Image of one row
+	Image line(1, 7, 0);
+	line[0][1] = line[0][2] = line[0][5] = 255;
+
+	BOOST_REQUIRE(moment_based_normalization(line) == line);
+
+	// Centroid column 8 / 3 is within a pixel from the centre 3: no shift
+	BOOST_REQUIRE(slant_correction(line) == line);
+
+	// Shifted by 2 columns to the centre
+	Image left(1, 7, 0), centred(1, 7, 0);
+	left[0][0] = left[0][1] = left[0][2] = 255;
+	centred[0][2] = centred[0][3] = centred[0][4] = 255;
+	BOOST_REQUIRE(slant_correction(left) == centred);
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+	test_suite* test = BOOST_TEST_SUITE("Moments test suite");
+
+	test->add(BOOST_TEST_CASE(&moments_test));
+	test->add(BOOST_TEST_CASE(&empty_image_test));
+	test->add(BOOST_TEST_CASE(&single_row_test));
+
+	return test;
+}
@@ -0,0 +1,273 @@
+/*                                                                 -*- C++ -*-
+ * File: normalization_tests.cpp
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Boost unit tests for size normalization of images
+ *
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+
+#include "LA/matrix.h"
+#include "PR/normalization.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+typedef Matrix<uint8_t> Image;
+
+const SizeNormalizer::Interpolation interpolations[3] = {
+	SizeNormalizer::NEAREST, SizeNormalizer::BILINEAR, SizeNormalizer::AREA
+};
+
+// Random blob of black pixels (255) with noise, not touching the border
+Image random_image(unsigned nrow, unsigned ncol)
+{
+	Image img(nrow, ncol, 0);
+
+	unsigned r0 = 1 + rand() % (nrow / 2), c0 = 1 + rand() % (ncol / 2);
+	for (unsigned r = r0; r + 1 < nrow && r < r0 + nrow / 2; ++r)
+		for (unsigned c = c0; c + 1 < ncol && c < c0 + ncol / 3; ++c)
+			img[r][c] = 255;
+
+	for (unsigned k = 0; k < 5; ++k)
+		img[rand() % nrow][rand() % ncol] = 255;
+
+	return img;
+}
+
+void axis_map_test()
+{
+	// Down and up scaling of windows inside the source (ARAN and MOMENT
+	// windows may also stick out of it)
+	const unsigned sizes[][2] = { { 20, 7 }, { 7, 20 }, { 28, 28 }, { 5, 28 }, { 13, 4 } };
+	const double windows[][2] = { { 0, 1 }, { 0.25, 0.5 }, { -0.5, 2 } };
+
+	for (const auto & s : sizes)
+		for (const auto & w : windows)
+			for (auto interpolation : interpolations)
+			{
+				unsigned src_size = s[0], size = s[1];
+				double begin = w[0] * src_size, length = w[1] * src_size;
+
+				AxisMap map;
+				map.build(src_size, size, begin, length, interpolation);
+				BOOST_REQUIRE(map.offset.size() == size + 1 && map.offset[0] == 0);
+				BOOST_REQUIRE(map.index.size() == map.offset[size] && map.weight.size() == map.offset[size]);
+
+				double step = length / size;
+				for (unsigned d = 0; d < size; ++d)
+				{
+					double sum = 0;
+					for (unsigned k = map.offset[d]; k < map.offset[d + 1]; ++k)
+					{
+						BOOST_REQUIRE(map.index[k] < src_size && map.weight[k] > 0);
+						sum += map.weight[k];
+					}
+
+					double lo = begin + d * step, hi = lo + step;
+					double centre = (lo + hi) / 2;
+
+					if (interpolation == SizeNormalizer::NEAREST)
+					{
+						// Pixel under the centre
+						bool inside = centre >= 0 && centre < src_size;
+						BOOST_REQUIRE(map.offset[d + 1] - map.offset[d] == (inside ? 1u : 0u));
+						if (inside)
+							BOOST_REQUIRE(map.index[map.offset[d]] == static_cast<unsigned>(floor(centre)));
+					}
+					else if (interpolation == SizeNormalizer::BILINEAR)
+					{
+						// Both nearest centres inside: weights sum to 1
+						if (centre >= 0.5 && centre <= src_size - 0.5)
+							BOOST_REQUIRE(fabs(sum - 1) < 1e-6);
+						BOOST_REQUIRE(sum < 1 + 1e-6);
+					}
+					else
+					{
+						// Overlap with the source, relative to the destination pixel
+						double overlap = (min(hi, static_cast<double>(src_size)) - max(lo, 0.0)) / step;
+						BOOST_REQUIRE(fabs(sum - max(overlap, 0.0)) < 1e-6);
+						if (lo >= 0 && hi <= src_size)
+							BOOST_REQUIRE(fabs(sum - 1) < 1e-6);
+					}
+				}
+			}
+}
+
+void interpolation_values_test()
+{
+	// Each pixel of 3 x 2 image becomes 2 x 3 block of 6 x 6 (bilinear
+	// interpolates between blocks, it is checked below)
+	Matrix<float> img(3, 2);
+	img[0][0] = 1, img[0][1] = 2, img[1][0] = 3, img[1][1] = 4, img[2][0] = 5, img[2][1] = 6;
+
+	Matrix<float> square(2, 2);
+	square[0][0] = 1, square[0][1] = 0, square[1][0] = 0, square[1][1] = 0;
+
+	for (auto interpolation : interpolations)
+	{
+		SizeNormalizer linear(6, SizeNormalizer::LINEAR, interpolation);
+		vector<float> out(36);
+		linear.normalize(img, out.data());
+
+		if (interpolation != SizeNormalizer::BILINEAR)
+			for (unsigned i = 0; i < 6; ++i)
+				for (unsigned j = 0; j < 6; ++j)
+					BOOST_REQUIRE(fabs(out[i * 6 + j] - img[i / 2][j / 3]) < 1e-6);
+
+		// Downscaling to one pixel
+		SizeNormalizer one(1, SizeNormalizer::LINEAR, interpolation);
+		float v;
+		one.normalize(square, &v);
+		BOOST_REQUIRE(fabs(v - (interpolation == SizeNormalizer::NEAREST ? 0.0f : 0.25f)) < 1e-6);
+	}
+
+	// Bilinear between centres: row [0, 4] to 4 pixels, white outside
+	Matrix<float> row(1, 2);
+	row[0][0] = 0, row[0][1] = 4;
+
+	SizeNormalizer bilinear(4, SizeNormalizer::LINEAR, SizeNormalizer::BILINEAR);
+	vector<float> out(16);
+	bilinear.normalize(row, out.data());
+
+	const float col_values[4] = { 0, 1, 3, 3 };
+	const float row_weights[4] = { 0.625f, 0.875f, 0.875f, 0.625f };
+	for (unsigned i = 0; i < 4; ++i)
+		for (unsigned j = 0; j < 4; ++j)
+			BOOST_REQUIRE(fabs(out[i * 4 + j] - row_weights[i] * col_values[j]) < 1e-6);
+
+	// Integral pixels are rounded and clamped
+	Image bright(3, 3, 255);
+	SizeNormalizer area(2, SizeNormalizer::LINEAR, SizeNormalizer::AREA);
+	Image normalized = area.normalize(bright);
+	for (unsigned i = 0; i < 2; ++i)
+		for (unsigned j = 0; j < 2; ++j)
+			BOOST_REQUIRE(normalized[i][j] == 255);
+}
+
+void upscaling_test()
+{
+	// Black image of any size and aspect ratio fills the normalized image
+	const unsigned sizes[][2] = { { 5, 3 }, { 3, 5 }, { 1, 1 }, { 2, 9 }, { 7, 7 } };
+
+	for (const auto & s : sizes)
+		for (auto interpolation : interpolations)
+		{
+			Matrix<float> img(s[0], s[1], 1.0f);
+			SizeNormalizer normalizer(28, SizeNormalizer::LINEAR, interpolation);
+
+			vector<float> out(28 * 28);
+			normalizer.normalize(img, out.data());
+
+			for (float v : out)
+			{
+				// Bilinear fades towards white outside at the border, each
+				// axis keeps at least half of the border pixel
+				BOOST_REQUIRE(v >= 0.25f - 1e-6f);
+				if (interpolation != SizeNormalizer::BILINEAR)
+					BOOST_REQUIRE(fabs(v - 1) < 1e-6);
+			}
+		}
+
+	// Stroke of width 1 stays connected: no empty rows under it
+	Image stroke(10, 10, 0);
+	for (unsigned r = 0; r < 10; ++r)
+		stroke[r][4] = 255;
+
+	for (auto interpolation : interpolations)
+	{
+		SizeNormalizer normalizer(32, SizeNormalizer::LINEAR, interpolation);
+		Image normalized = normalizer.normalize(stroke);
+
+		for (unsigned i = 0; i < 32; ++i)
+		{
+			unsigned black = 0;
+			for (unsigned j = 0; j < 32; ++j)
+				black += normalized[i][j] != 0;
+			BOOST_REQUIRE(black > 0);
+		}
+	}
+}
+
+void moment_empty_image_test()
+{
+	Image empty(10, 6, 0);
+
+	for (auto interpolation : interpolations)
+	{
+		SizeNormalizer moment(16, SizeNormalizer::MOMENT, interpolation);
+		SizeNormalizer linear(16, SizeNormalizer::LINEAR, interpolation);
+		SizeNormalizer::Workspace moment_ws, linear_ws;
+
+		vector<uint8_t> moment_out(16 * 16, 1), linear_out(16 * 16, 1);
+		moment.normalize(empty, moment_out.data(), moment_ws);
+		linear.normalize(empty, linear_out.data(), linear_ws);
+
+		// Same maps as LINEAR, all white
+		BOOST_REQUIRE(moment_ws.rows.offset == linear_ws.rows.offset && moment_ws.rows.index == linear_ws.rows.index);
+		BOOST_REQUIRE(moment_ws.cols.offset == linear_ws.cols.offset && moment_ws.cols.index == linear_ws.cols.index);
+		BOOST_REQUIRE(moment_ws.rows.weight == linear_ws.rows.weight && moment_ws.cols.weight == linear_ws.cols.weight);
+		BOOST_REQUIRE(moment_out == linear_out);
+		for (uint8_t v : moment_out)
+			BOOST_REQUIRE(v == 0);
+	}
+}
+
+void normalize_batch_test()
+{
+	srand(5);
+
+	// Sizes change between images, so that maps are rebuilt
+	vector<Image> images;
+	for (unsigned k = 0; k < 60; ++k)
+		images.push_back(random_image(8 + rand() % 30, 8 + rand() % 30));
+
+	const SizeNormalizer::Method methods[3] = { SizeNormalizer::LINEAR, SizeNormalizer::ARAN, SizeNormalizer::MOMENT };
+
+	for (auto method : methods)
+		for (auto interpolation : interpolations)
+		{
+			SizeNormalizer normalizer(20, method, interpolation);
+
+			vector<uint8_t> single(images.size() * 400);
+			normalizer.normalize_batch(images, single.data(), 1);
+
+			// Same as one by one
+			for (unsigned k = 0; k < images.size(); ++k)
+			{
+				Image normalized = normalizer.normalize(images[k]);
+				for (unsigned i = 0; i < 20; ++i)
+					for (unsigned j = 0; j < 20; ++j)
+						BOOST_REQUIRE(normalized[i][j] == single[k * 400 + i * 20 + j]);
+			}
+
+			for (unsigned nthreads = 2; nthreads <= 8; nthreads *= 2)
+			{
+				vector<uint8_t> parallel(images.size() * 400);
+				normalizer.normalize_batch(images, parallel.data(), nthreads);
+				BOOST_REQUIRE(parallel == single);
+			}
+		}
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+	test_suite* test = BOOST_TEST_SUITE("Normalization test suite");
+
+	test->add(BOOST_TEST_CASE(&axis_map_test));
+	test->add(BOOST_TEST_CASE(&interpolation_values_test));
+	test->add(BOOST_TEST_CASE(&upscaling_test));
+	test->add(BOOST_TEST_CASE(&moment_empty_image_test));
+	test->add(BOOST_TEST_CASE(&normalize_batch_test));
+
+	return test;
+}
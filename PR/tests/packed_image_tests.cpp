@@ -0,0 +1,384 @@
+/*                                                                 -*- C++ -*-
+ * File: packed_image_tests.cpp
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Boost unit tests for B/A scores, thinning, topological features
+ *   and chain codes on bit-packed images, compared with the per-pixel
+ *   code on framed images they replace
+ *
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+
+#include "LA/matrix.h"
+#include "PR/zoning.h"
+#include "PR/utils.h"
+#include "PR/thinning.h"
+#include "PR/topological_features.h"
+#include "PR/statistical_features.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+typedef Matrix<uint8_t> Image;
+
+/******************************************************************************
+*
+* Per-pixel implementations replaced by packed ones
+*
+*******************************************************************************/
+
+// Zhang-Suen thinning of image with white frame (as _zhang_suen_thinning used to do)
+Image reference_framed_thinning(const Image & img)
+{
+	Image skeleton(img);
+	bool changes = true;
+	while (changes)
+	{
+		changes = false;
+		for (unsigned step = 0; step < 2; ++step)
+		{
+			Image contour(img.nrow(), img.ncol());
+			for (unsigned r = 1; r < skeleton.nrow() - 1; ++r)
+				for (unsigned c = 1; c < skeleton.ncol() - 1; ++c)
+				{
+					if (!skeleton[r][c])
+						continue;
+
+					unsigned b = b_score(skeleton, r, c);
+					if (b < 2 || b > 6)
+						continue;
+
+					unsigned a = a_score(skeleton, r, c);
+					if (a != 1)
+						continue;
+
+					if (step == 0)
+					{
+						if (skeleton[r - 1][c] && skeleton[r][c + 1] && skeleton[r + 1][c])
+							continue;
+
+						if (skeleton[r][c + 1] && skeleton[r + 1][c] && skeleton[r][c - 1])
+							continue;
+					}
+					else
+					{
+						if (skeleton[r - 1][c] && skeleton[r][c + 1] && skeleton[r][c - 1])
+							continue;
+
+						if (skeleton[r - 1][c] && skeleton[r + 1][c] && skeleton[r][c - 1])
+							continue;
+					}
+
+					contour[r][c] = '*';
+				}
+
+			for (unsigned r = 1; r < contour.nrow() - 1; ++r)
+				for (unsigned c = 1; c < contour.ncol() - 1; ++c)
+					if (contour[r][c])
+					{
+						skeleton[r][c] = 0;
+						changes = true;
+					}
+		}
+	}
+
+	// Make contour binary
+	for (unsigned r = 0; r < skeleton.nrow(); ++r)
+		for (unsigned c = 0; c < skeleton.ncol(); ++c)
+			if (skeleton[r][c])
+				skeleton[r][c] = '*';
+
+	return skeleton;
+}
+
+// Zhang-Suen thinning through a temporary frame (as zhang_suen_thinning used to do)
+Image reference_thinning(const Image & img)
+{
+	bool frame = true;
+	for (unsigned c = 0; frame && c < img.ncol(); ++c)
+		if (img[0][c] || img[img.nrow() - 1][c])
+			frame = false;
+
+	for (unsigned r = 0; frame && r < img.nrow(); ++r)
+		if (img[r][0] || img[r][img.ncol() - 1])
+			frame = false;
+
+	if (frame)
+		return reference_framed_thinning(img);
+
+	Image framed_skeleton = reference_framed_thinning(make_frame(img));
+	Image skeleton(img.nrow(), img.ncol());
+	for (unsigned r = 1; r < framed_skeleton.nrow() - 1; ++r)
+		for (unsigned c = 1; c < framed_skeleton.ncol() - 1; ++c)
+			skeleton[r - 1][c - 1] = framed_skeleton[r][c];
+
+	return skeleton;
+}
+
+// End points, branches and crossings per zone, pixel by pixel
+vector<float> reference_feature_points(const Image & img, const Matrix<Zone> & zones)
+{
+	vector<float> features;
+	Image framed = make_frame(img);
+
+	for (const auto & zones_row : zones)
+		for (const auto & z : zones_row)
+		{
+			unsigned eps = 0, branches = 0, crosses = 0;
+
+			for (unsigned r = z.rowsBegin(); r < z.rowsEnd(); ++r)
+				for (unsigned c = z.colsBegin(); c < z.colsEnd(); ++c)
+				{
+					if (!img[r][c])
+						continue;
+
+					unsigned b = b_score(framed, r + 1, c + 1);
+					if (b < 2) ++eps;
+					if (b == 4) ++crosses;
+					if (b == 3 && a_score(framed, r + 1, c + 1) == 3)
+						++branches;
+				}
+
+			features.push_back(static_cast<float>(eps));
+			features.push_back(static_cast<float>(branches));
+			features.push_back(static_cast<float>(crosses));
+		}
+
+	return features;
+}
+
+// Chain code histogram of image with white frame (as _chain_codes used to do)
+vector<float> reference_framed_chain_codes(const Image & contour)
+{
+	vector<float> codes(8);
+
+	for (unsigned r = 1; r < contour.nrow() - 1; ++r)
+		for (unsigned c = 1; c < contour.ncol() - 1; ++c)
+		{
+			if (!contour[r][c])
+				continue;
+
+			if (!contour[r][c + 1])
+			{
+				if (contour[r - 1][c + 1])
+					codes[1] += 1;
+				else if (contour[r - 1][c])
+					codes[2] += 1;
+			}
+			if (!contour[r - 1][c])
+			{
+				if (contour[r - 1][c - 1])
+					codes[3] += 1;
+				else if (contour[r][c - 1])
+					codes[4] += 1;
+			}
+			if (!contour[r][c - 1])
+			{
+				if (contour[r + 1][c - 1])
+					codes[5] += 1;
+				else if (contour[r + 1][c])
+					codes[6] += 1;
+			}
+			if (!contour[r + 1][c])
+			{
+				if (contour[r + 1][c + 1])
+					codes[7] += 1;
+				else if (contour[r][c + 1])
+					codes[0] += 1;
+			}
+		}
+
+	return codes;
+}
+
+// Chain codes through a temporary frame (as chain_codes used to do)
+vector<float> reference_chain_codes(const Image & img)
+{
+	bool frame = true;
+	for (unsigned c = 0; frame && c < img.ncol(); ++c)
+		if (img[0][c] || img[img.nrow() - 1][c])
+			frame = false;
+
+	for (unsigned r = 0; frame && r < img.nrow(); ++r)
+		if (img[r][0] || img[r][img.ncol() - 1])
+			frame = false;
+
+	return reference_framed_chain_codes(frame ? img : make_frame(img));
+}
+
+/******************************************************************************
+*
+* Random images
+*
+*******************************************************************************/
+
+// Widths around and above one and two words
+const unsigned widths[] = { 1, 2, 5, 17, 28, 63, 64, 65, 70, 127, 128, 130 };
+
+// Strokes of width 1 - 4 over sparse noise. Ink touches the border unless
+// frame is set
+Image random_image(unsigned nrow, unsigned ncol, bool frame)
+{
+	Image img(nrow, ncol, 0);
+
+	unsigned nstrokes = rand() % 5;
+	for (unsigned s = 0; s < nstrokes; ++s)
+	{
+		unsigned width = 1 + rand() % 4;
+		unsigned r0 = rand() % nrow, c0 = rand() % ncol;
+		bool vertical = rand() % 2 != 0;
+		unsigned length = 1 + rand() % (vertical ? nrow : ncol);
+
+		for (unsigned t = 0; t < length; ++t)
+			for (unsigned k = 0; k < width; ++k)
+			{
+				unsigned r = vertical ? r0 + t : r0 + k + t / 4;
+				unsigned c = vertical ? c0 + k + t / 4 : c0 + t;
+				if (r < nrow && c < ncol)
+					img[r][c] = 255;
+			}
+	}
+
+	unsigned density = rand() % 8;
+	for (unsigned r = 0; r < nrow; ++r)
+		for (unsigned c = 0; c < ncol; ++c)
+			if (density && rand() % (density * 4) == 0)
+				img[r][c] = 255;
+
+	if (frame)
+	{
+		for (unsigned r = 0; r < nrow; ++r)
+			img[r][0] = img[r][ncol - 1] = 0;
+		for (unsigned c = 0; c < ncol; ++c)
+			img[0][c] = img[nrow - 1][c] = 0;
+	}
+
+	return img;
+}
+
+// nr * nc zones of about equal size (zones may be empty)
+Matrix<Zone> grid_zones(unsigned nrow, unsigned ncol, unsigned nr, unsigned nc)
+{
+	Matrix<Zone> zones(nr, nc);
+	for (unsigned i = 0; i < nr; ++i)
+		for (unsigned j = 0; j < nc; ++j)
+			zones[i][j] = Zone(i * nrow / nr, (i + 1) * nrow / nr, j * ncol / nc, (j + 1) * ncol / nc);
+
+	return zones;
+}
+
+/******************************************************************************
+*
+* Tests
+*
+*******************************************************************************/
+
+void neighbourhood_scores_test()
+{
+	srand(17);
+
+	for (unsigned t = 0; t < 200; ++t)
+	{
+		unsigned nrow = 1 + rand() % 30, ncol = widths[rand() % (sizeof(widths) / sizeof(widths[0]))];
+		Image img = random_image(nrow, ncol, false);
+		Image framed = make_frame(img);
+
+		PackedImage packed(img);
+		NeighbourhoodScores scores(packed);
+
+		for (unsigned r = 0; r < nrow; ++r)
+			for (unsigned c = 0; c < ncol; ++c)
+			{
+				unsigned b = b_score(framed, r + 1, c + 1);
+				unsigned a = a_score(framed, r + 1, c + 1);
+				BOOST_REQUIRE(scores.b(r, c) == b);
+				BOOST_REQUIRE(scores.a(r, c) == a);
+
+				// Comparison masks
+				unsigned w = c / PackedImage::WORD_BITS, bit = c % PackedImage::WORD_BITS;
+				BOOST_REQUIRE(((scores.b_between(r, w, 2, 6) >> bit) & 1) == (b >= 2 && b <= 6));
+				BOOST_REQUIRE(((scores.b_between(r, w, 3, 3) >> bit) & 1) == (b == 3));
+				BOOST_REQUIRE(((scores.a_equal(r, w, 1) >> bit) & 1) == (a == 1));
+				BOOST_REQUIRE(((scores.a_equal(r, w, 3) >> bit) & 1) == (a == 3));
+			}
+	}
+}
+
+void packed_thinning_test()
+{
+	srand(19);
+
+	for (unsigned t = 0; t < 300; ++t)
+	{
+		unsigned nrow = 1 + rand() % 40, ncol = widths[rand() % (sizeof(widths) / sizeof(widths[0]))];
+		bool frame = nrow > 2 && ncol > 2 && rand() % 3 == 0;
+		Image img = random_image(nrow, ncol, frame);
+
+		BOOST_REQUIRE(zhang_suen_thinning(img) == reference_thinning(img));
+	}
+
+	// Full image: every pixel touches the border or is surrounded
+	Image full(10, 70, 255);
+	BOOST_REQUIRE(zhang_suen_thinning(full) == reference_thinning(full));
+}
+
+void packed_feature_points_test()
+{
+	srand(23);
+
+	for (unsigned t = 0; t < 300; ++t)
+	{
+		unsigned nrow = 1 + rand() % 40, ncol = widths[rand() % (sizeof(widths) / sizeof(widths[0]))];
+		Image img = random_image(nrow, ncol, false);
+
+		// Skeletons have the end points and branches the features are for
+		if (rand() % 2)
+			img = zhang_suen_thinning(img);
+
+		// Zone boundaries inside and across words
+		Matrix<Zone> zones = grid_zones(nrow, ncol, 1 + rand() % 4, 1 + rand() % 5);
+		BOOST_REQUIRE((feature_points<Image, float>(img, zones) == reference_feature_points(img, zones)));
+	}
+}
+
+void packed_chain_codes_test()
+{
+	srand(29);
+
+	for (unsigned t = 0; t < 300; ++t)
+	{
+		unsigned nrow = 1 + rand() % 40, ncol = widths[rand() % (sizeof(widths) / sizeof(widths[0]))];
+		bool frame = nrow > 2 && ncol > 2 && rand() % 3 == 0;
+		Image img = random_image(nrow, ncol, frame);
+
+		// Codes are meant for contours and skeletons, but any image will do
+		if (rand() % 2)
+			img = zhang_suen_thinning(img);
+
+		BOOST_REQUIRE((chain_codes<Image, float>(img) == reference_chain_codes(img)));
+	}
+
+	Image full(10, 70, 255);
+	BOOST_REQUIRE((chain_codes<Image, float>(full) == reference_chain_codes(full)));
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+	test_suite* test = BOOST_TEST_SUITE("Packed image test suite");
+
+	test->add(BOOST_TEST_CASE(&neighbourhood_scores_test));
+	test->add(BOOST_TEST_CASE(&packed_thinning_test));
+	test->add(BOOST_TEST_CASE(&packed_feature_points_test));
+	test->add(BOOST_TEST_CASE(&packed_chain_codes_test));
+
+	return test;
+}
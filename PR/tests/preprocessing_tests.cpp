@@ -0,0 +1,242 @@
+/*                                                                 -*- C++ -*-
+ * File: preprocessing_tests.cpp
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Boost unit tests for arena allocation of preprocessing and
+ *   feature extraction
+ *
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+
+#include "LA/matrix.h"
+#include "LA/arena.h"
+#include "PR/preprocessing.h"
+#include "PR/statistical_features.h"
+#include "PR/topological_features.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+// Counts heap allocations of the whole program
+static unsigned long long heap_allocations = 0;
+
+void * operator new(size_t n)
+{
+	++heap_allocations;
+	void * p = malloc(n ? n : 1);
+	if (!p)
+		throw bad_alloc();
+	return p;
+}
+
+void operator delete(void * p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void * p, size_t) noexcept
+{
+	free(p);
+}
+
+typedef Matrix<uint8_t> Image;
+typedef ArenaAllocator<float> FeatureAlloc;
+
+// Slanted stroke with some noise
+Image random_digit(unsigned size)
+{
+	Image img(size, size, 0);
+
+	double slant = (static_cast<int>(rand() % 11) - 5) / 5.0;
+	for (unsigned r = 2; r + 2 < size; ++r)
+	{
+		int c = static_cast<int>(size / 2 + (r - size / 2.0) * slant);
+		for (int w = 0; w < 3; ++w)
+			if (c + w >= 0 && c + w < static_cast<int>(size))
+				img[r][c + w] = 255;
+	}
+
+	for (unsigned k = 0; k < 10; ++k)
+		img[rand() % size][rand() % size] = 255;
+
+	return img;
+}
+
+void arena_test()
+{
+	Arena arena(1024);
+
+	for (unsigned round = 0; round < 3; ++round)
+	{
+		Arena::Marker start = arena.mark();
+		{
+			Arena::Scope scope(arena);
+			for (unsigned k = 1; k < 50; ++k)
+			{
+				void * p = arena.allocate(k * 13, k % 2 ? 8 : 64);
+				BOOST_REQUIRE(reinterpret_cast<size_t>(p) % (k % 2 ? 8 : 64) == 0);
+			}
+
+			// Larger than a block
+			arena.allocate(5000);
+		}
+		BOOST_REQUIRE(arena.mark().block == start.block && arena.mark().offset == start.offset);
+	}
+
+	// Blocks are taken in the first round only
+	size_t blocks = arena.heap_allocations();
+	for (unsigned round = 0; round < 3; ++round)
+	{
+		for (unsigned k = 1; k < 50; ++k)
+			arena.allocate(k * 13, k % 2 ? 8 : 64);
+		arena.allocate(5000);
+		arena.reset();
+	}
+	BOOST_REQUIRE(arena.heap_allocations() == blocks);
+}
+
+void arena_matrix_test()
+{
+	srand(3);
+	Arena::Scope scope;
+
+	for (unsigned t = 0; t < 20; ++t)
+	{
+		Image img = random_digit(28);
+
+		ArenaMatrix<uint8_t> arena_img(img.nrow(), img.ncol());
+		BOOST_REQUIRE(arena_img.nrow() == 28 && arena_img.ncol() == 28);
+		for (unsigned r = 0; r < img.nrow(); ++r)
+			for (unsigned c = 0; c < img.ncol(); ++c)
+				arena_img[r][c] = img[r][c];
+
+		ArenaMatrix<uint8_t> corrected, normalized, thinned;
+		slant_correction(arena_img, corrected);
+		linear_aran_normalization(corrected, 32, normalized);
+		PackedScratch scratch;
+		zhang_suen_thinning(normalized, thinned, scratch);
+
+		Image expected = zhang_suen_thinning(linear_aran_normalization(slant_correction(img), 32));
+		BOOST_REQUIRE(thinned.nrow() == expected.nrow() && thinned.ncol() == expected.ncol());
+		for (unsigned r = 0; r < expected.nrow(); ++r)
+			for (unsigned c = 0; c < expected.ncol(); ++c)
+				BOOST_REQUIRE(thinned[r][c] == expected[r][c]);
+	}
+}
+
+void steady_state_allocations_test()
+{
+	srand(5);
+
+	vector<Image> digits;
+	for (unsigned k = 0; k < 200; ++k)
+		digits.push_back(random_digit(28));
+
+	Preprocessing preprocessing;
+	preprocessing.add(Preprocessing::SLANT_CORRECTION).add(Preprocessing::ARAN_NORMALIZATION, 32);
+
+	Matrix<Zone> zones = zoning(32, 32, 4);
+
+	// Features of each digit are written to a row of features
+	unsigned dim = histograms<Image, float>(Image(32, 32), zones).size() + 8 + 48 + 32;
+	Matrix<float> features(digits.size(), dim);
+
+	Preprocessing::Workspace<Image> ws;
+	PackedScratch scratch;
+	Image normalized;
+
+	for (unsigned pass = 0; pass < 2; ++pass)
+	{
+		unsigned long long allocations = heap_allocations;
+
+		for (unsigned k = 0; k < digits.size(); ++k)
+		{
+			Arena::Scope scope;
+
+			preprocessing.process(digits[k], normalized, ws);
+
+			ArenaMatrix<uint8_t> skeleton;
+			zhang_suen_thinning(normalized, skeleton, scratch);
+
+			vector<float, FeatureAlloc> h = histograms<Image, float, FeatureAlloc>(normalized, zones);
+			vector<float, FeatureAlloc> cc = chain_codes<ArenaMatrix<uint8_t>, float, FeatureAlloc>(skeleton, scratch);
+			vector<float, FeatureAlloc> fp = feature_points<ArenaMatrix<uint8_t>, float, FeatureAlloc>(skeleton, zones, scratch);
+			vector<float, FeatureAlloc> rh = radial_histograms<Image, float, FeatureAlloc>(normalized);
+
+			auto it = features[k].begin();
+			it = copy(h.begin(), h.end(), it);
+			it = copy(cc.begin(), cc.end(), it);
+			it = copy(fp.begin(), fp.end(), it);
+			copy(rh.begin(), rh.end(), it);
+		}
+
+		// The first pass grows buffers and the arena
+		if (pass)
+			BOOST_REQUIRE(heap_allocations == allocations);
+	}
+
+	// Same as with the heap
+	for (unsigned k = 0; k < digits.size(); ++k)
+	{
+		Image img = linear_aran_normalization(slant_correction(digits[k]), 32);
+		Image skeleton = zhang_suen_thinning(img);
+
+		vector<float> f = histograms<Image, float>(img, zones);
+		vector<float> cc = chain_codes<Image, float>(skeleton);
+		vector<float> fp = feature_points<Image, float>(skeleton, zones);
+		vector<float> rh = radial_histograms<Image, float>(img);
+
+		f.insert(f.end(), cc.begin(), cc.end());
+		f.insert(f.end(), fp.begin(), fp.end());
+		f.insert(f.end(), rh.begin(), rh.end());
+
+		BOOST_REQUIRE(f == features[k]);
+	}
+}
+
+void process_batch_test()
+{
+	srand(9);
+
+	vector<Image> digits;
+	for (unsigned k = 0; k < 50; ++k)
+		digits.push_back(random_digit(20 + k % 13));
+
+	Preprocessing preprocessing;
+	preprocessing.add(Preprocessing::SLANT_CORRECTION).add(Preprocessing::ARAN_NORMALIZATION, 32).add(Preprocessing::THINNING);
+
+	// Default of one thread, all hardware threads and more threads than images
+	vector<Image> out;
+	for (unsigned nthreads : { 1u, 0u, 64u })
+	{
+		if (nthreads == 1)
+			preprocessing.process_batch(digits, out);
+		else
+			preprocessing.process_batch(digits, out, nthreads);
+
+		BOOST_REQUIRE(out.size() == digits.size());
+		for (unsigned k = 0; k < digits.size(); ++k)
+			BOOST_REQUIRE(out[k] == preprocessing.process(digits[k]));
+	}
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+	test_suite* test = BOOST_TEST_SUITE("Preprocessing test suite");
+
+	test->add(BOOST_TEST_CASE(&arena_test));
+	test->add(BOOST_TEST_CASE(&arena_matrix_test));
+	test->add(BOOST_TEST_CASE(&steady_state_allocations_test));
+	test->add(BOOST_TEST_CASE(&process_batch_test));
+
+	return test;
+}
@@ -0,0 +1,155 @@
+/*                                                                 -*- C++ -*-
+ * File: statistical_features_tests.cpp
+ *
+ * Author: Ilya Ivensky
+ *
+ * Created on: Oct 19, 2026
+ *
+ * Description:
+ *   Boost unit tests for statistical features of images
+ *
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <vector>
+
+#include "LA/matrix.h"
+#include "PR/zoning.h"
+#include "PR/statistical_features.h"
+
+using namespace std;
+using boost::unit_test_framework::test_suite;
+
+typedef Matrix<uint8_t> Image;
+
+void histograms_test()
+{
+	// Zone A is columns 0 - 2, zone B is columns 3 - 4:
+	//   . X X | . X
+	//   . . X | X .
+	//   X . . | X .
+	Image img(3, 5, 0);
+	img[0][1] = img[0][2] = img[1][2] = img[2][0] = 255;
+	img[0][4] = img[1][3] = img[2][3] = 255;
+
+	// hp by r, vp by c, lrd by rows - 1 + c - r, rld by r + c
+	const float a[] = {
+		2, 1, 1,
+		1, 1, 2,
+		1, 0, 0, 2, 1,
+		0, 1, 2, 1, 0
+	};
+	const float b[] = {
+		1, 1, 1,
+		2, 1,
+		1, 1, 0, 1,
+		0, 2, 1, 0
+	};
+
+	vector<float> expected(a, a + sizeof(a) / sizeof(a[0]));
+	expected.insert(expected.end(), b, b + sizeof(b) / sizeof(b[0]));
+
+	// Grid of zones, scanned row by row of image
+	Matrix<Zone> grid(1, 2);
+	grid[0][0] = Zone(0, 3, 0, 3);
+	grid[0][1] = Zone(0, 3, 3, 5);
+	BOOST_REQUIRE(is_zone_grid(grid) && profiles_size(grid) == expected.size());
+	BOOST_REQUIRE((histograms<Image, float>(img, grid) == expected));
+
+	// Same zones one under the other, scanned zone by zone
+	Matrix<Zone> column(2, 1);
+	column[0][0] = grid[0][0];
+	column[1][0] = grid[0][1];
+	BOOST_REQUIRE(!is_zone_grid(column));
+	BOOST_REQUIRE((histograms<Image, float>(img, column) == expected));
+}
+
+// Ray k of quadrant q from pixel (r, c) walked point by point, with bounds checks
+unsigned walk_ray(const Image & img, unsigned r, unsigned c, unsigned q, unsigned k, unsigned granularity)
+{
+	const int sign_r[4] = { 1, 1, -1, -1 };
+	const int sign_c[4] = { 1, -1, 1, -1 };
+
+	double dr = sqrt(1.0 - static_cast<double>(k) / granularity);
+	double dc = sqrt(static_cast<double>(k) / granularity);
+
+	unsigned count = 0;
+	for (unsigned t = 0;; ++t)
+	{
+		long y = static_cast<long>(r) + sign_r[q] * static_cast<long>(floor(t * dr + 0.5));
+		long x = static_cast<long>(c) + sign_c[q] * static_cast<long>(floor(t * dc + 0.5));
+		if (y < 0 || x < 0 || y >= static_cast<long>(img.nrow()) || x >= static_cast<long>(img.ncol()))
+			break;
+
+		count += img[y][x] != 0;
+	}
+
+	return count;
+}
+
+void ray_table_test()
+{
+	srand(7);
+
+	// Precomputed offsets give the same counts as walking rays from every pixel
+	for (unsigned t = 0; t < 300; ++t)
+	{
+		unsigned nrow = 1 + rand() % 30, ncol = 1 + rand() % 30, granularity = 1 + rand() % 16;
+		unsigned density = rand() % 4;
+
+		Image img(nrow, ncol, 0);
+		for (unsigned r = 0; r < nrow; ++r)
+			for (unsigned c = 0; c < ncol; ++c)
+				img[r][c] = density && rand() % density == 0 ? 255 : 0;
+
+		RayTable table(nrow, ncol, granularity);
+		BOOST_REQUIRE(table.size() == 4 * granularity);
+
+		for (unsigned r = 0; r < nrow; ++r)
+			for (unsigned c = 0; c < ncol; ++c)
+			{
+				vector<unsigned> counts(table.size(), 0);
+				table.add(img, r, c, counts.data());
+
+				for (unsigned q = 0; q < 4; ++q)
+					for (unsigned k = 0; k < granularity; ++k)
+						BOOST_REQUIRE(counts[q * granularity + k] == walk_ray(img, r, c, q, k, granularity));
+			}
+	}
+
+	BOOST_REQUIRE_THROW(RayTable(4, 4, 0), exception);
+}
+
+void radial_histograms_test()
+{
+	//   X X . . .
+	//   . X . . .
+	//   . X . . .
+	//   . . . . X
+	// Centroid (1.2, 1.4) is rounded to pixel (1, 1)
+	Image img(4, 5, 0);
+	img[0][0] = img[0][1] = img[1][1] = img[2][1] = img[3][4] = 255;
+
+	// Ray 1 goes by offsets (0, 0), (1, 1), (1, 1), (2, 2), ...
+	const float expected[8] = { 2, 1, 2, 1, 2, 1, 2, 3 };
+	BOOST_REQUIRE((radial_histograms<Image, float>(img, 2) == vector<float>(expected, expected + 8)));
+
+	// Empty image
+	BOOST_REQUIRE((radial_histograms<Image, float>(Image(4, 5, 0), 2) == vector<float>(8, 0)));
+	BOOST_REQUIRE_THROW((radial_histograms<Image, float>(img, 0)), exception);
+}
+
+boost::unit_test_framework::test_suite * init_unit_test_suite(int argc, char *argv[])
+{
+	test_suite* test = BOOST_TEST_SUITE("Statistical features test suite");
+
+	test->add(BOOST_TEST_CASE(&histograms_test));
+	test->add(BOOST_TEST_CASE(&ray_table_test));
+	test->add(BOOST_TEST_CASE(&radial_histograms_test));
+
+	return test;
+}
@@ -15,130 +15,73 @@
 
 #include "PR/utils.h"
 
-template <class Image>
-static Image _zhang_suen_thinning (const Image & img)
+/**
+ Both sub-iterations work on whole words of packed image: deletion
+ mask of a word is built from B/A score masks and neighbour words.
+ Pixels outside of the image are white, so image is processed as 
+ if it had a white frame (no copy is needed).
+ Result is written to thinned (resized if needed, its type may differ
+ from the type of img)
+ */
+template <class Image, class Thinned>
+void zhang_suen_thinning (const Image & img, Thinned & thinned, PackedScratch & scratch)
 {
-	Image skeleton(img);
+	typedef PackedImage::Word Word;
+	typedef PackedNeighbours PN;
+
+	PackedImage & skeleton = scratch.image;
+	NeighbourhoodScores & scores = scratch.scores;
+	vector<Word> & deleted = scratch.mask;
+
+	skeleton.assign(img);
+	deleted.resize(skeleton.nrow() * skeleton.words());
+
 	bool changes = true;
 	while (changes) 
 	{
 		changes = false;
+		for (unsigned step = 0; step < 2; ++step)
 		{
-			// Step 1
-			Image contour(img.nrow(), img.ncol());
-			for (unsigned r = 1; r < skeleton.nrow() - 1; ++r)
-				for (unsigned c = 1; c < skeleton.ncol() - 1; ++c)
+			// All pixels are checked against the skeleton before deletion
+			scores.compute(skeleton);
+			for (unsigned r = 0; r < skeleton.nrow(); ++r)
+				for (unsigned w = 0; w < skeleton.words(); ++w)
 				{
-					if (!skeleton[r][c])
-						continue;
-
-					unsigned b = b_score(skeleton, r, c);
-					if (b < 2 || b > 6)
-						continue;
-
-					unsigned a = a_score(skeleton, r, c);
-					if (a != 1)
-						continue;
+					PackedNeighbours n(skeleton, r, w);
+					Word d = skeleton[r][w] & scores.b_between(r, w, 2, 6) & scores.a_equal(r, w, 1);
 
-					if (skeleton[r - 1][c] && skeleton[r][c + 1] && skeleton[r + 1][c])
-						continue;
+					if (step == 0)
+						d &= ~(n[PN::N] & n[PN::E] & n[PN::S]) & ~(n[PN::E] & n[PN::S] & n[PN::W]);
+					else
+						d &= ~(n[PN::N] & n[PN::E] & n[PN::W]) & ~(n[PN::N] & n[PN::S] & n[PN::W]);
 
-					if (skeleton[r][c + 1] && skeleton[r + 1][c] && skeleton[r][c - 1])
-						continue;
-
-					if (skeleton[r][c])
-						contour[r][c] = '*';
-				}
-			
-			for (unsigned r = 1; r < contour.nrow() - 1; ++r)
-				for (unsigned c = 1; c < contour.ncol() - 1; ++c)
-				{
-					if (!contour[r][c])
-						continue;
-
-					skeleton[r][c] = 0;
-					changes = true;
+					deleted[r * skeleton.words() + w] = d;
 				}
-		}
-
-		{
-			// Step 2
-			Image contour(img.nrow(), img.ncol());
-			for (unsigned r = 1; r < skeleton.nrow() - 1; ++r)
-				for (unsigned c = 1; c < skeleton.ncol() - 1; ++c)
-				{
-					if (!skeleton[r][c])
-						continue;
-
-					unsigned b = b_score(skeleton, r, c);
-					if (b < 2 || b > 6)
-						continue;
-
-					unsigned a = a_score(skeleton, r, c);
-					if (a != 1)
-						continue;
 
-					if (skeleton[r - 1][c] && skeleton[r][c + 1] && skeleton[r][c - 1])
-						continue;
-
-					if (skeleton[r - 1][c] && skeleton[r + 1][c] && skeleton[r][c - 1])
-						continue;
-
-					if (skeleton[r][c])
-						contour[r][c] = '*';
-				}
-			
-			for (unsigned r = 1; r < contour.nrow() - 1; ++r)
-				for (unsigned c = 1; c < contour.ncol() - 1; ++c)
+			for (unsigned r = 0; r < skeleton.nrow(); ++r)
+				for (unsigned w = 0; w < skeleton.words(); ++w)
 				{
-					if (!contour[r][c])
-						continue;
-
-					skeleton[r][c] = 0;
-					changes = true;
+					Word d = deleted[r * skeleton.words() + w];
+					skeleton[r][w] &= ~d;
+					changes = changes || d;
 				}
 		}
 	}
 
 	// Make contour binary
-	for (unsigned r = 0; r < skeleton.nrow(); ++r)
-		for (unsigned c = 0; c < skeleton.ncol(); ++c)
-			if (skeleton[r][c])
-				skeleton[r][c] = '*';
-
-	return skeleton;
+	if (thinned.nrow() != img.nrow() || thinned.ncol() != img.ncol())
+		thinned = Thinned(img.nrow(), img.ncol());
+	skeleton.unpack(thinned, '*');
 }
 
 template <class Image>
 Image zhang_suen_thinning (const Image & img)
 {
-	// Detect whether there is a white frame. 
-	// It is needed for optimization only
-	// If there is a frame, then we can scan image from 1 to last -1,
-	// and check neighbors without checking boundaries
-
-	bool frame = true;
-	for (unsigned c = 0; frame && c < img.ncol(); ++c)
-		if (img[0][c] || img[img.nrow() - 1][c])
-			frame = false;
-
-	for (unsigned r = 0; frame && r < img.nrow(); ++r)
-		if (img[r][0] || img[r][img.ncol() - 1])
-			frame = false;
-
-	if (frame)
-		return _zhang_suen_thinning(img);
-
-	// There is no frame - we will create one temporarily 
-	
-	Image framed = make_frame(img);
-	Image framed_skeleton = _zhang_suen_thinning(framed);
-	Image skeleton(img.nrow(), img.ncol());
-	for (unsigned r = 1; r < framed_skeleton.nrow() - 1; ++r)
-		for (unsigned c = 1; c < framed_skeleton.ncol() - 1; ++c)
-			skeleton[r - 1][c - 1] = framed_skeleton[r][c];
+	PackedScratch scratch;
+	Image thinned(img.nrow(), img.ncol());
+	zhang_suen_thinning(img, thinned, scratch);
 
-	return skeleton;
+	return thinned;
 }
 
 #endif
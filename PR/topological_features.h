@@ -18,11 +18,17 @@
 #include "PR/zoning.h"
 #include "PR/utils.h"
 
-template <class Image, class Feature>
-vector<Feature> feature_points(const Image & img, const Matrix<Zone> & zones)
+// B/A scores are computed for the whole image at once and counted per zone by masks
+template <class Image, class Feature, class Alloc = allocator<Feature> >
+vector<Feature, Alloc> feature_points(const Image & img, const Matrix<Zone> & zones, PackedScratch & scratch)
 {
-	vector<Feature> features(zones.nrow() * zones.ncol() * 3);
-	Image framed = make_frame(img);
+	typedef PackedImage::Word Word;
+
+	vector<Feature, Alloc> features(zones.nrow() * zones.ncol() * 3);
+	PackedImage & packed = scratch.image;
+	NeighbourhoodScores & scores = scratch.scores;
+	packed.assign(img);
+	scores.compute(packed);
 
 	unsigned zone_offset = 0;
 
@@ -33,25 +39,18 @@ vector<Feature> feature_points(const Image & img, const Matrix<Zone> & zones)
 		{
 			const Zone & z  = *itCol;
 
-			unsigned rows = z.rowsEnd() - z.rowsBegin();
-			unsigned cols = z.colsEnd() - z.colsBegin();
-
 			unsigned eps = 0, branches = 0, crosses = 0;
 
 			for (unsigned r = z.rowsBegin(); r < z.rowsEnd(); ++r)
-				for (unsigned c = z.colsBegin(); c < z.colsEnd(); ++c)
+				for (unsigned w = z.colsBegin() / PackedImage::WORD_BITS; w * PackedImage::WORD_BITS < z.colsEnd(); ++w)
 				{
-					if (!img[r][c])
+					Word pixels = packed[r][w] & PackedImage::columns(w, z.colsBegin(), z.colsEnd());
+					if (!pixels)
 						continue;
 
-					unsigned b = b_score(framed, r + 1, c + 1); 
-					if (b < 2) ++eps;
-					if (b == 4) ++crosses;
-					if (b == 3)
-					{
-						unsigned a = a_score(framed, r + 1, c + 1);
-						if (a == 3) ++branches;
-					}
+					eps += popcount(pixels & scores.b_between(r, w, 0, 1));
+					crosses += popcount(pixels & scores.b_between(r, w, 4, 4));
+					branches += popcount(pixels & scores.b_between(r, w, 3, 3) & scores.a_equal(r, w, 3));
 				}
 
 			features[zone_offset] = static_cast<float>(eps);
@@ -62,4 +61,12 @@ vector<Feature> feature_points(const Image & img, const Matrix<Zone> & zones)
 
 	return features;
 }
+
+template <class Image, class Feature, class Alloc = allocator<Feature> >
+vector<Feature, Alloc> feature_points(const Image & img, const Matrix<Zone> & zones)
+{
+	PackedScratch scratch;
+	return feature_points<Image, Feature, Alloc>(img, zones, scratch);
+}
+
 #endif
@@ -14,6 +14,19 @@
 #ifndef _UTILS_H_
 #define _UTILS_H_
 
+#include "PR/packed_image.h"
+
+// Makes img nrow * ncol and white, reusing its storage if the size is the same
+template <class Image>
+void clear_image(Image & img, unsigned nrow, unsigned ncol)
+{
+	if (img.nrow() != nrow || img.ncol() != ncol)
+		img = Image(nrow, ncol);
+
+	for (auto & row : img)
+		fill(row.begin(), row.end(), 0);
+}
+
 template <class Image>
 Image make_frame(const Image & img)
 {
@@ -126,4 +139,140 @@ unsigned a_score(const Image & img, unsigned r, unsigned c)
 	return a;
 }
 
+/************************************************************
+* 8 neighbours of pixels of one word of packed image, in the
+* order of a_score (clockwise from the top)
+************************************************************/
+struct PackedNeighbours
+{
+	typedef PackedImage::Word Word;
+
+	enum { N, NE, E, SE, S, SW, W, NW };
+
+	Word n[8];
+
+	PackedNeighbours(const PackedImage & img, unsigned r, unsigned w)
+	{
+		const Word * up = img.row(static_cast<signed>(r) - 1);
+		const Word * mid = img.row(r);
+		const Word * down = img.row(r + 1);
+
+		n[N] = up[w];
+		n[NE] = PackedImage::east(up, w);
+		n[E] = PackedImage::east(mid, w);
+		n[SE] = PackedImage::east(down, w);
+		n[S] = down[w];
+		n[SW] = PackedImage::west(down, w);
+		n[W] = PackedImage::west(mid, w);
+		n[NW] = PackedImage::west(up, w);
+	}
+
+	const Word & operator[](unsigned k) const { return n[k]; }
+};
+
+/************************************************************
+* B and A scores of all pixels of packed image, 64 pixels at
+* once: neighbours are shifted words and the scores are summed
+* by bit-sliced adders. Scores are kept bit-sliced as well
+* (plane k holds bit k of scores of the word's pixels), so
+* comparisons are masks too.
+* Pixels outside of the image are white (as with make_frame)
+************************************************************/
+class NeighbourhoodScores
+{
+public:
+
+	typedef PackedImage::Word Word;
+
+	// B is up to 8, A is up to 4
+	enum { B_PLANES = 4, A_PLANES = 3 };
+
+	NeighbourhoodScores() : nwords(0) {}
+
+	explicit NeighbourhoodScores(const PackedImage & img) { compute(img); }
+
+	void compute(const PackedImage & img)
+	{
+		nwords = img.words();
+		b_planes.assign(img.nrow() * nwords * B_PLANES, 0);
+		a_planes.assign(img.nrow() * nwords * A_PLANES, 0);
+
+		for (unsigned r = 0; r < img.nrow(); ++r)
+			for (unsigned w = 0; w < nwords; ++w)
+			{
+				PackedNeighbours n(img, r, w);
+				Word * b = &b_planes[(r * nwords + w) * B_PLANES];
+				Word * a = &a_planes[(r * nwords + w) * A_PLANES];
+
+				// A counts white -> black transitions around the pixel
+				for (unsigned k = 0; k < 8; ++k)
+				{
+					add(b, B_PLANES, n[k]);
+					add(a, A_PLANES, ~n[k] & n[(k + 1) % 8]);
+				}
+			}
+	}
+
+	unsigned b(unsigned r, unsigned c) const { return value(&b_planes[(r * nwords + c / PackedImage::WORD_BITS) * B_PLANES], B_PLANES, c); }
+	unsigned a(unsigned r, unsigned c) const { return value(&a_planes[(r * nwords + c / PackedImage::WORD_BITS) * A_PLANES], A_PLANES, c); }
+
+	// Pixels of word w of row r with lo <= B <= hi
+	Word b_between(unsigned r, unsigned w, unsigned lo, unsigned hi) const
+	{
+		const Word * b = &b_planes[(r * nwords + w) * B_PLANES];
+		Word mask = 0;
+		for (unsigned v = lo; v <= hi; ++v)
+			mask |= equal(b, B_PLANES, v);
+		return mask;
+	}
+
+	// Pixels of word w of row r with A == v
+	Word a_equal(unsigned r, unsigned w, unsigned v) const { return equal(&a_planes[(r * nwords + w) * A_PLANES], A_PLANES, v); }
+
+private:
+
+	// Adds bit of x to the number of each pixel
+	static void add(Word * planes, unsigned n, Word x)
+	{
+		for (unsigned k = 0; k < n; ++k)
+		{
+			Word carry = planes[k] & x;
+			planes[k] ^= x;
+			x = carry;
+		}
+	}
+
+	static Word equal(const Word * planes, unsigned n, unsigned v)
+	{
+		Word mask = ~Word(0);
+		for (unsigned k = 0; k < n; ++k)
+			mask &= (v >> k) & 1 ? planes[k] : ~planes[k];
+		return mask;
+	}
+
+	static unsigned value(const Word * planes, unsigned n, unsigned c)
+	{
+		unsigned v = 0;
+		for (unsigned k = 0; k < n; ++k)
+			v |= static_cast<unsigned>((planes[k] >> (c % PackedImage::WORD_BITS)) & 1) << k;
+		return v;
+	}
+
+	unsigned nwords;
+	vector<Word> b_planes;
+	vector<Word> a_planes;
+};
+
+/************************************************************
+* Buffers of packed image processing (thinning, chain codes,
+* feature points). Passing the same scratch for every image
+* of a loop avoids allocations once the buffers have grown
+************************************************************/
+struct PackedScratch
+{
+	PackedImage image;
+	NeighbourhoodScores scores;
+	vector<PackedImage::Word> mask;
+};
+
 #endif